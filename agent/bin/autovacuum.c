@@ -635,8 +635,8 @@ Autovacuum_exec(AutovacuumLog *av, PGconn *conn, const char *instid)
 	params[39] = list_nth(av->params, idx_offset + 0);	/* io_timings_read */
 	params[40] = list_nth(av->params, idx_offset + 1);	/* io_timings_write */
 
-	return pgut_command(conn, SQL_INSERT_AUTOVACUUM,
-						lengthof(params), params) == PGRES_COMMAND_OK;
+	return writer_put(conn, SQL_INSERT_AUTOVACUUM,
+					  lengthof(params), params);
 }
 
 static bool
@@ -661,8 +661,8 @@ Autoanalyze_exec(AutovacuumLog *av, PGconn *conn, const char *instid)
 	params[11] = list_nth(av->params, NUM_AUTOANALYZE + NUM_RUSAGE + 0);	/* io_timings_read */
 	params[12] = list_nth(av->params, NUM_AUTOANALYZE + NUM_RUSAGE + 1);	/* io_timings_write */
 	
-	return pgut_command(conn, SQL_INSERT_AUTOANALYZE,
-						lengthof(params), params) == PGRES_COMMAND_OK;
+	return writer_put(conn, SQL_INSERT_AUTOANALYZE,
+					  lengthof(params), params);
 }
 
 static bool
@@ -686,8 +686,8 @@ AutovacuumCancel_exec(AutovacuumLog *av, PGconn *conn, const char *instid)
 	else
 		query = SQL_INSERT_AUTOANALYZE_CANCEL;
 
-	return pgut_command(conn, query,
-						lengthof(params), params) == PGRES_COMMAND_OK;
+	return writer_put(conn, query,
+					  lengthof(params), params);
 }
 
 static void
@@ -175,6 +175,6 @@ Checkpoint_exec(CheckpointLog *ckpt, PGconn *conn, const char *instid)
 	params[8] = sync_duration;	/* sync_duration */
 	params[9] = total_duration;	/* total_duration */
 
-	return pgut_command(conn,
-				SQL_INSERT_CHECKPOINT, 10, params) == PGRES_COMMAND_OK;
+	return writer_put(conn,
+				SQL_INSERT_CHECKPOINT, 10, params);
 }
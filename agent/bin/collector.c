@@ -5,6 +5,7 @@
  */
 
 #include "pg_statsinfod.h"
+#include "collector_sql.h"
 
 #include <time.h>
 
@@ -19,15 +20,43 @@ volatile time_t	collector_reload_time;
 volatile char  *snapshot_requested;
 volatile char  *maintenance_requested;
 volatile char  *postmaster_start_time;
+volatile time_t	last_alert_time;
 
 static PGconn  *collector_conn = NULL;
 
+/* a pooled connection to a database, used only by the collector thread */
+typedef struct PooledConn
+{
+	PGconn	   *conn;
+	bool		in_use;
+	time_t		last_used;
+} PooledConn;
+
+/* idle connections are checked before reuse after this */
+#define POOL_CHECK_SECS		60
+
+/*
+ * reset a released connection for the next user. RESET ALL also resets the
+ * settings applied by do_connect(), so they are applied again.
+ */
+#define POOL_RESET_SQL \
+	"RESET ALL; DEALLOCATE ALL; DISCARD TEMP; " SESSION_SETTINGS_SQL
+
+static List	   *conn_pool = NIL;
+static int64	pool_hits = 0;		/* idle connections reused */
+static int64	pool_misses = 0;	/* new connections */
+static int64	pool_reconnects = 0;	/* broken idle connections replaced */
+
 static void reload_params(void);
 static void do_sample(void);
-static void do_snapshot(char *comment);
+static void do_snapshot(char *comment, const char *escalation);
+static char *check_escalation(void);
+static time_t get_next_snapshot(time_t now);
 static bool update_hardware_info(void);
 static void get_server_encoding(void);
 static void collector_disconnect(void);
+static void pool_remove(PooledConn *pc);
+static PGconn *connect_database(PGconn **conn, const char *dbname, const char *schema);
 bool extract_dbname(const char *conninfo, char *dbname, size_t size);
 static void get_postmaster_start_time(void);
 
@@ -59,13 +88,18 @@ collector_main(void *arg)
 	time_t		now;
 	time_t		next_sample;
 	time_t		next_snapshot;
+	time_t		next_mini_snapshot;
+	time_t		next_escalation = 0;
+	time_t		escalation_end = 0;
+	char	   *escalation = NULL;
 	pid_t		log_maintenance_pid = 0;
 	int			fd_err;
 	bool		need_hw_update = true;
 
 	now = time(NULL);
 	next_sample = get_next_time(now, sampling_interval);
-	next_snapshot = get_next_time(now, snapshot_interval);
+	next_snapshot = get_next_snapshot(now);
+	next_mini_snapshot = get_next_time(now, mini_snapshot_interval);
 
 	/* we set actual server encoding to libpq default params. */
 	get_server_encoding();
@@ -96,6 +130,16 @@ collector_main(void *arg)
 			do_sample();
 			now = time(NULL);
 			next_sample = get_next_time(now, sampling_interval);
+
+			/* take lightweight snapshots for a while on a trigger */
+			if (escalation == NULL &&
+				(escalation = check_escalation()) != NULL)
+			{
+				elog(LOG, "high-frequency snapshots started for %d seconds (%s)",
+					escalation_duration, escalation);
+				escalation_end = now + escalation_duration;
+				next_escalation = now;
+			}
 		}
 
 		/* snapshot by manual */
@@ -109,15 +153,41 @@ collector_main(void *arg)
 			pthread_mutex_unlock(&reload_lock);
 
 			if (comment)
-				do_snapshot(comment);
+				do_snapshot(comment, NULL);
 		}
 
 		/* snapshot by time */
 		if (now >= next_snapshot)
 		{
-			do_snapshot(NULL);
+			do_snapshot(NULL, NULL);
+			now = time(NULL);
+			next_snapshot = get_next_snapshot(now);
+			next_escalation = get_next_time(now, escalation_interval);
+		}
+
+		/* mini-snapshot of the instance-level counters */
+		if (mini_snapshot_interval > 0 && now >= next_mini_snapshot)
+		{
+			QueueItem	*ts = get_instance_ts();
+
+			if (ts != NULL)
+				writer_send(ts);
+			now = time(NULL);
+			next_mini_snapshot = get_next_time(now, mini_snapshot_interval);
+		}
+
+		/* lightweight snapshot while escalated */
+		if (escalation != NULL && now >= escalation_end)
+		{
+			elog(LOG, "high-frequency snapshots ended");
+			free(escalation);
+			escalation = NULL;
+		}
+		else if (escalation != NULL && now >= next_escalation)
+		{
+			do_snapshot(NULL, escalation);
 			now = time(NULL);
-			next_snapshot = get_next_time(now, snapshot_interval);
+			next_escalation = get_next_time(now, escalation_interval);
 		}
 
 		/* maintenance by manual */
@@ -196,9 +266,13 @@ collector_main(void *arg)
 				need_hw_update = false;
 		}
 
+		/* close the pooled connections left unused for a while */
+		collector_pool_expire(now);
+
 		usleep(200 * 1000);	/* 200ms */
 	}
 
+	free(escalation);
 	collector_disconnect();
 	shutdown_progress(COLLECTOR_SHUTDOWN);
 
@@ -249,25 +323,129 @@ do_sample(void)
 	}
 }
 
+/*
+ * get_next_snapshot - return the time of the next scheduled snapshot.
+ *
+ * Snapshots are taken at multiples of snapshot_interval, delayed by an offset
+ * within snapshot_jitter derived from the instance ID, so that the agents
+ * sharing a repository spread their writes. The offset is 0 until the writer
+ * knows the instance ID.
+ */
+static time_t
+get_next_snapshot(time_t now)
+{
+	int		window = Min(snapshot_jitter, snapshot_interval);
+	time_t	offset = 0;
+
+	if (window > 1 && writer_instid > 0)
+		offset = (time_t) (((uint64) writer_instid * UINT64CONST(2654435761))
+						   % (uint64) window);
+
+	return get_next_time(now - offset, snapshot_interval) + offset;
+}
+
+/*
+ * check_escalation - return the triggers of the high-frequency snapshots
+ * found in the current activity, or NULL if none.
+ */
+static char *
+check_escalation(void)
+{
+	static int64	prev_busy = -1;
+	static int64	prev_total = 0;
+	static time_t	prev_alert_time = 0;
+	StringInfoData	buf;
+	PGconn		   *conn;
+	PGresult	   *res;
+
+	initStringInfo(&buf);
+
+	/* an alert has been raised since the last check */
+	if (last_alert_time != prev_alert_time)
+	{
+		if (escalation_on_alert)
+			appendStringInfoString(&buf, "alert");
+		prev_alert_time = last_alert_time;
+	}
+
+	if ((escalation_waiting_sessions > 0 ||
+		 escalation_replication_lag > 0 ||
+		 escalation_cpu_usage > 0) &&
+		(conn = collector_connect(NULL)) != NULL)
+	{
+		res = pgut_execute(conn, SQL_SELECT_ESCALATION, 0, NULL);
+		if (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) == 1)
+		{
+			int64	waiting = 0;
+			int64	lag = 0;
+			int64	cpu[4];
+			int64	busy;
+			int64	total;
+			int		i;
+
+			parse_int64(PQgetvalue(res, 0, 0), &waiting);
+			parse_int64(PQgetvalue(res, 0, 1), &lag);
+			for (i = 0; i < lengthof(cpu); i++)
+			{
+				cpu[i] = 0;
+				parse_int64(PQgetvalue(res, 0, 2 + i), &cpu[i]);
+			}
+			busy = cpu[0] + cpu[1] + cpu[3];	/* user, system and iowait */
+			total = busy + cpu[2];
+
+			if (escalation_waiting_sessions > 0 &&
+				waiting >= escalation_waiting_sessions)
+				appendStringInfo(&buf, "%swaiting sessions: " INT64_FORMAT,
+								 buf.len > 0 ? ", " : "", waiting);
+			if (escalation_replication_lag > 0 &&
+				lag >= escalation_replication_lag)
+				appendStringInfo(&buf, "%sreplication lag: " INT64_FORMAT " sec",
+								 buf.len > 0 ? ", " : "", lag);
+			if (escalation_cpu_usage > 0 && prev_busy >= 0 &&
+				total > prev_total && busy >= prev_busy &&
+				(busy - prev_busy) * 100 >=
+					(total - prev_total) * escalation_cpu_usage)
+				appendStringInfo(&buf, "%scpu usage: " INT64_FORMAT "%%",
+								 buf.len > 0 ? ", " : "",
+								 (busy - prev_busy) * 100 / (total - prev_total));
+
+			prev_busy = busy;
+			prev_total = total;
+		}
+		PQclear(res);
+	}
+
+	if (buf.len == 0)
+	{
+		termStringInfo(&buf);
+		return NULL;
+	}
+
+	return buf.data;
+}
+
 /*
  * ownership of comment will be granted to snapshot item.
  */
 static void
-do_snapshot(char *comment)
+do_snapshot(char *comment, const char *escalation)
 {
 	QueueItem	*snap = NULL;
 
 	/* skip current snapshot if previous snapshot still not complete */
 	if (writer_has_queue(QUEUE_SNAPSHOT))
 	{
-		elog(WARNING, "previous snapshot is not complete, so current snapshot was skipped");
+		if (escalation == NULL)
+			elog(WARNING, "previous snapshot is not complete, so current snapshot was skipped");
+		else
+			elog(DEBUG2, "previous snapshot is not complete, so lightweight snapshot was skipped");
 		free(comment);
 		return;
 	}
 
 	/* exclusive control during snapshot and maintenance */
 	pthread_mutex_lock(&maintenance_lock);
-	snap = get_snapshot(comment);
+	snap = get_snapshot(comment, escalation);
 	pthread_mutex_unlock(&maintenance_lock);
 
 	if (snap != NULL)
@@ -462,7 +640,6 @@ PGconn *
 collector_connect(const char *db)
 {
 	char		 dbname[NAMEDATALEN];
-	char		 info[1024];
 	const char	*schema;
 
 	if (db == NULL)
@@ -478,14 +655,35 @@ collector_connect(const char *db)
 		schema = NULL;
 	}
 
+	return connect_database(&collector_conn, dbname, schema);
+}
+
+/*
+ * collector_connect_db - connect to the database with a connection other
+ * than the collector's own one
+ */
+PGconn *
+collector_connect_db(PGconn **conn, const char *db)
+{
+	return connect_database(conn, db, NULL);
+}
+
+static PGconn *
+connect_database(PGconn **conn, const char *dbname, const char *schema)
+{
+	char		 info[1024];
+
 	/* disconnect if need to connect another database */
-	if (collector_conn)
+	if (*conn)
 	{
 		char	*pgdb;
 
-		pgdb = PQdb(collector_conn);
+		pgdb = PQdb(*conn);
 		if (pgdb == NULL || strcmp(pgdb, dbname) != 0)
-			collector_disconnect();
+		{
+			pgut_disconnect(*conn);
+			*conn = NULL;
+		}
 	}
 	else
 	{
@@ -513,7 +711,7 @@ collector_connect(const char *db)
 		"port=%s %s dbname=%s options='-c log_statement=none'",
 		postmaster_port, target_server, dbname);
 #endif
-	return do_connect(&collector_conn, info, schema);
+	return do_connect(conn, info, schema);
 }
 
 static void
@@ -521,6 +719,175 @@ collector_disconnect(void)
 {
 	pgut_disconnect(collector_conn);
 	collector_conn = NULL;
+
+	while (conn_pool != NIL)
+		pool_remove((PooledConn *) linitial(conn_pool));
+}
+
+/*
+ * collector_pool_get - take a connection to the database from the pool, or
+ * connect to it if the pool has no idle one. The connection should be given
+ * back with collector_pool_release().
+ */
+PGconn *
+collector_pool_get(const char *db)
+{
+	ListCell   *cell;
+	PooledConn *pc;
+	bool		broken = false;
+
+	foreach(cell, conn_pool)
+	{
+		PGresult   *res;
+		bool		alive;
+
+		pc = (PooledConn *) lfirst(cell);
+		if (pc->in_use || strcmp(PQdb(pc->conn), db) != 0)
+			continue;
+
+		/* the server may have closed the connection while it was idle */
+		alive = (PQstatus(pc->conn) == CONNECTION_OK);
+		if (alive && time(NULL) >= pc->last_used + POOL_CHECK_SECS)
+		{
+			res = pgut_execute(pc->conn, "SELECT 1", 0, NULL);
+			alive = (PQresultStatus(res) == PGRES_TUPLES_OK);
+			PQclear(res);
+		}
+
+		if (alive)
+		{
+			pc->in_use = true;
+			pool_hits++;
+			return pc->conn;
+		}
+
+		elog(DEBUG2, "pooled connection to database \"%s\" is broken", db);
+		pool_remove(pc);
+		broken = true;
+		break;
+	}
+
+	pc = pgut_new(PooledConn);
+	pc->conn = NULL;
+	if (connect_database(&pc->conn, db, NULL) == NULL)
+	{
+		free(pc);
+		return NULL;
+	}
+	pc->in_use = true;
+	pc->last_used = time(NULL);
+	conn_pool = lappend(conn_pool, pc);
+
+	if (broken)
+		pool_reconnects++;
+	else
+		pool_misses++;
+
+	return pc->conn;
+}
+
+/*
+ * collector_pool_release - give the connection back to the pool. The session
+ * is reset for the next user. Broken connections, and the least recently used
+ * ones over connection_pool_size, are closed.
+ */
+void
+collector_pool_release(PGconn *conn)
+{
+	ListCell   *cell;
+	PooledConn *pc = NULL;
+	PooledConn *oldest;
+	int			nidle;
+
+	if (conn == NULL)
+		return;
+
+	foreach(cell, conn_pool)
+	{
+		if (((PooledConn *) lfirst(cell))->conn == conn)
+		{
+			pc = (PooledConn *) lfirst(cell);
+			break;
+		}
+	}
+	if (pc == NULL)
+	{
+		pgut_disconnect(conn);
+		return;
+	}
+
+	pc->in_use = false;
+	pc->last_used = time(NULL);
+
+	if (connection_pool_size <= 0 ||
+		PQstatus(conn) != CONNECTION_OK ||
+		PQtransactionStatus(conn) != PQTRANS_IDLE ||
+		pgut_command(conn, POOL_RESET_SQL, 0, NULL) != PGRES_COMMAND_OK)
+	{
+		pool_remove(pc);
+		return;
+	}
+
+	for (;;)
+	{
+		nidle = 0;
+		oldest = NULL;
+		foreach(cell, conn_pool)
+		{
+			PooledConn *idle = (PooledConn *) lfirst(cell);
+
+			if (idle->in_use)
+				continue;
+			nidle++;
+			if (oldest == NULL || idle->last_used < oldest->last_used)
+				oldest = idle;
+		}
+		if (nidle <= connection_pool_size)
+			break;
+		pool_remove(oldest);
+	}
+}
+
+/*
+ * collector_pool_expire - close the connections which have been idle for
+ * connection_pool_idle_timeout
+ */
+void
+collector_pool_expire(time_t now)
+{
+	ListCell   *cell;
+
+	foreach(cell, conn_pool)
+	{
+		PooledConn *pc = (PooledConn *) lfirst(cell);
+
+		if (!pc->in_use &&
+			now >= pc->last_used + connection_pool_idle_timeout)
+		{
+			pool_remove(pc);
+			break;	/* the rest are checked in the next call */
+		}
+	}
+}
+
+/*
+ * collector_pool_counters - return the number of pooled connections reused,
+ * newly connected, and replaced since the start
+ */
+void
+collector_pool_counters(int64 *hits, int64 *misses, int64 *reconnects)
+{
+	*hits = pool_hits;
+	*misses = pool_misses;
+	*reconnects = pool_reconnects;
+}
+
+static void
+pool_remove(PooledConn *pc)
+{
+	conn_pool = list_delete_ptr(conn_pool, pc);
+	pgut_disconnect(pc->conn);
+	free(pc);
 }
 
 bool
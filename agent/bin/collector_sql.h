@@ -16,6 +16,140 @@
  *----------------------------------------------------------------------------
  */
 
+/* capability probes */
+#define SQL_PROBE_PG_STAT_STATEMENTS "\
+SELECT relname FROM pg_class \
+ WHERE relname = 'pg_stat_statements' AND relkind = 'v'"
+
+#define SQL_PROBE_PG_STORE_PLANS "\
+SELECT relname FROM pg_class \
+ WHERE relname = 'pg_store_plans' AND relkind = 'v'"
+
+#define SQL_PROBE_RUSAGE "\
+SELECT 1 FROM pg_settings \
+ WHERE name = 'pg_statsinfo.rusage_track' AND setting IN ('all', 'top')"
+
+#define SQL_PROBE_PG_BUFFERCACHE "\
+SELECT relname FROM pg_class \
+ WHERE relname = 'pg_buffercache' AND relkind = 'v'"
+
+#define SQL_PROBE_PG_WALINSPECT "\
+SELECT 1 FROM pg_extension \
+ WHERE extname = 'pg_walinspect'"
+
+#define SQL_PROBE_COLLECT_COLUMN "\
+SELECT 1 FROM pg_settings \
+ WHERE name = 'pg_statsinfo.collect_column' AND setting = 'on'"
+
+#define SQL_PROBE_COLLECT_INDEX "\
+SELECT 1 FROM pg_settings \
+ WHERE name = 'pg_statsinfo.collect_index' AND setting = 'on'"
+
+/*
+ * fingerprint of the per database statistics. Only cheap aggregates of the
+ * catalogs and the counters are taken, since it is computed in every
+ * snapshot to skip the databases which have not changed.
+ */
+#define SQL_SELECT_FINGERPRINT "\
+SELECT \
+	pg_catalog.concat_ws(':', r.*, n.*, h.*, f.*) \
+FROM \
+( \
+	SELECT \
+		pg_catalog.count(*), \
+		pg_catalog.sum(c.oid::bigint), \
+		pg_catalog.sum(c.relfilenode::bigint), \
+		pg_catalog.sum(pg_catalog.hashtext(pg_catalog.concat_ws(':', \
+			c.relnamespace, c.relname, c.relkind, c.reloptions))), \
+		pg_catalog.sum(c.relpages), \
+		pg_catalog.sum(c.reltuples), \
+		pg_catalog.sum(c.relnatts), \
+		pg_catalog.sum(pg_catalog.pg_stat_get_numscans(c.oid)), \
+		pg_catalog.sum(pg_catalog.pg_stat_get_tuples_returned(c.oid)), \
+		pg_catalog.sum(pg_catalog.pg_stat_get_tuples_fetched(c.oid)), \
+		pg_catalog.sum(pg_catalog.pg_stat_get_tuples_inserted(c.oid)), \
+		pg_catalog.sum(pg_catalog.pg_stat_get_tuples_updated(c.oid)), \
+		pg_catalog.sum(pg_catalog.pg_stat_get_tuples_deleted(c.oid)), \
+		pg_catalog.sum(pg_catalog.pg_stat_get_live_tuples(c.oid)), \
+		pg_catalog.sum(pg_catalog.pg_stat_get_dead_tuples(c.oid)), \
+		pg_catalog.sum(pg_catalog.pg_stat_get_blocks_fetched(c.oid)), \
+		pg_catalog.sum(pg_catalog.pg_stat_get_blocks_hit(c.oid)), \
+		pg_catalog.max(pg_catalog.pg_stat_get_last_vacuum_time(c.oid)), \
+		pg_catalog.max(pg_catalog.pg_stat_get_last_autovacuum_time(c.oid)), \
+		pg_catalog.max(pg_catalog.pg_stat_get_last_analyze_time(c.oid)), \
+		pg_catalog.max(pg_catalog.pg_stat_get_last_autoanalyze_time(c.oid)) \
+	FROM \
+		pg_class c JOIN \
+		pg_namespace n ON c.relnamespace = n.oid \
+	WHERE \
+		c.relkind IN ('r', 't', 'i', 'p', 'I') AND \
+		n.nspname <> ALL (('{' || $1 || '}')::text[]) AND \
+		n.nspname !~ '^pg_(toast_)?temp_' \
+) r, \
+( \
+	SELECT \
+		pg_catalog.count(*), \
+		pg_catalog.sum(pg_catalog.hashtext(pg_catalog.concat_ws(':', \
+			n.oid, n.nspname))) \
+	FROM \
+		pg_namespace n \
+	WHERE \
+		n.nspname <> ALL (('{' || $1 || '}')::text[]) AND \
+		n.nspname !~ '^pg_(toast_)?temp_' \
+) n, \
+( \
+	SELECT \
+		pg_catalog.count(*), \
+		pg_catalog.sum(pg_catalog.hashtext(pg_catalog.concat_ws(':', \
+			i.inhrelid, i.inhparent, i.inhseqno))) \
+	FROM \
+		pg_inherits i \
+) h, \
+( \
+	SELECT \
+		pg_catalog.count(*), \
+		pg_catalog.sum(s.funcid::bigint), \
+		pg_catalog.sum(s.calls), \
+		pg_catalog.sum(s.total_time), \
+		pg_catalog.sum(s.self_time) \
+	FROM \
+		pg_stat_user_functions s \
+	WHERE \
+		s.schemaname <> ALL (('{' || $1 || '}')::text[]) AND \
+		s.schemaname !~ '^pg_temp_' \
+) f"
+
+/*
+ * statistics of tables and indexes collected in one pass over the catalogs.
+ * The functions are installed only in the databases having the statsinfo
+ * schema, and the catalog join queries are used in the others.
+ */
+#define SQL_HAS_RELATION_STATS "\
+SELECT \
+	pg_catalog.to_regprocedure('statsinfo.tables(text)') IS NOT NULL AND \
+	pg_catalog.to_regprocedure('statsinfo.indexes(text)') IS NOT NULL"
+
+#define SQL_SELECT_TABLE_BULK	"SELECT * FROM statsinfo.tables($1)"
+#define SQL_SELECT_INDEX_BULK	"SELECT * FROM statsinfo.indexes($1)"
+
+/*
+ * settings and probes of a database taken before collecting it, in a single
+ * round trip. $1: excluded schemas, $2: statement_timeout for the budget or
+ * NULL, $3: whether to take the fingerprint.
+ */
+#define SQL_SELECT_DB_PREPARE "\
+SELECT \
+	CASE WHEN $2::text IS NOT NULL \
+		THEN pg_catalog.set_config('statement_timeout', $2, false) END, \
+	CASE WHEN $3::boolean \
+		THEN (" SQL_SELECT_FINGERPRINT ") END, \
+	(" SQL_HAS_RELATION_STATS "), \
+	EXISTS (" SQL_PROBE_COLLECT_COLUMN "), \
+	EXISTS (" SQL_PROBE_COLLECT_INDEX "), \
+	CASE WHEN $4::boolean \
+		THEN pg_catalog.set_config('" SQL_ROLLUP_LEAVES_GUC "', \
+			COALESCE($5, (" SQL_SELECT_ROLLUP_LEAF_SET ")), false) END"
+
 /* database */
 #define SQL_SELECT_DATABASE "\
 SELECT \
@@ -51,9 +185,21 @@ ORDER BY dbid"
 /* activity */
 #define SQL_SELECT_ACTIVITY				"SELECT * FROM statsinfo.activity()"
 
+/* replication lag sampled between snapshots */
+#define SQL_SELECT_REPLICATION_LAG		"SELECT * FROM statsinfo.replication_lag()"
+
+/* WAL retention of replication slots sampled between snapshots */
+#define SQL_SELECT_REPLICATION_SLOT_RETENTION	"SELECT * FROM statsinfo.replication_slot_retention()"
+
+/* phases of maintenance operations completed between snapshots */
+#define SQL_SELECT_PROGRESS				"SELECT * FROM statsinfo.progress()"
+
 /* long transaction */
 #define SQL_SELECT_LONG_TRANSACTION		"SELECT * FROM statsinfo.long_xact()"
 
+/* backend memory */
+#define SQL_SELECT_BACKEND_MEMORY		"SELECT * FROM statsinfo.backend_memory()"
+
 /* tablespace */
 #define SQL_SELECT_TABLESPACE			"SELECT * FROM statsinfo.tablespaces"
 
@@ -79,8 +225,37 @@ SELECT \
 FROM \
 	pg_roles"
 
-/* statement */
+/*
+ * statement
+ *
+ * $4 .. $10 are the counters of the statements collected last. Only the
+ * statements whose counters changed since then are returned. When $3 is not
+ * zero, only the top-$3 statements in terms of the increase of execution time,
+ * block I/O and calls are returned.
+ */
 #define SQL_SELECT_STATEMENT "\
+WITH s AS ( \
+	SELECT \
+		s.*, \
+		s.shared_blks_read + s.shared_blks_written + \
+		s.local_blks_read + s.local_blks_written + \
+		s.temp_blks_read + s.temp_blks_written AS io, \
+		p.calls AS prev_calls, \
+		p.total_exec_time AS prev_exec_time, \
+		p.io AS prev_io \
+	FROM \
+		pg_stat_statements s \
+		LEFT JOIN pg_roles r ON r.oid = s.userid \
+		LEFT JOIN pg_catalog.unnest($4::oid[], $5::oid[], $6::bigint[], \
+			$7::bool[], $8::bigint[], $9::float8[], $10::bigint[]) \
+			AS p(dbid, userid, queryid, toplevel, calls, total_exec_time, io) \
+		ON p.dbid = s.dbid AND p.userid = s.userid AND \
+		   p.queryid = s.queryid AND p.toplevel = s.toplevel \
+	WHERE \
+		r.rolname <> ALL (('{' || $1 || '}')::text[]) AND \
+		(p.calls IS NULL OR p.calls <> s.calls OR \
+		 p.total_exec_time <> s.total_exec_time / 1000) \
+) \
 SELECT \
 	s.dbid, \
 	s.userid, \
@@ -106,23 +281,38 @@ SELECT \
 	s.local_blk_read_time, \
 	s.local_blk_write_time, \
 	s.temp_blk_read_time, \
-	s.temp_blk_write_time \
+	s.temp_blk_write_time, \
+	s.toplevel \
 FROM \
-	pg_stat_statements s \
-	LEFT JOIN pg_roles r ON r.oid = s.userid \
+	s \
 WHERE \
-	r.rolname <> ALL (('{' || $1 || '}')::text[]) \
+	$3::integer = 0 OR \
+	(s.dbid, s.userid, s.queryid, s.toplevel) IN ( \
+		(SELECT dbid, userid, queryid, toplevel FROM s \
+		  ORDER BY total_exec_time / 1000 - coalesce(prev_exec_time, 0) DESC \
+		  LIMIT $3) \
+		UNION ALL \
+		(SELECT dbid, userid, queryid, toplevel FROM s \
+		  ORDER BY io - coalesce(prev_io, 0) DESC LIMIT $3) \
+		UNION ALL \
+		(SELECT dbid, userid, queryid, toplevel FROM s \
+		  ORDER BY calls - coalesce(prev_calls, 0) DESC LIMIT $3)) \
 ORDER BY \
 	s.total_exec_time DESC LIMIT $2"
 
-/* plan */
+/*
+ * plan
+ *
+ * The plan text is returned only when ($3, $4) does not contain the pair of
+ * planid and the hash of the text, which are known to be in the repository.
+ */
 #define SQL_SELECT_PLAN "\
 SELECT \
 	p.dbid, \
 	p.userid, \
 	p.queryid, \
 	p.planid, \
-	p.plan, \
+	h.plan_hash, \
 	p.calls, \
 	p.total_time / 1000, \
 	p.rows, \
@@ -143,14 +333,25 @@ SELECT \
 	p.temp_blk_read_time, \
 	p.temp_blk_write_time, \
 	p.first_call, \
-	p.last_call \
+	p.last_call, \
+	CASE WHEN k.planid IS NULL THEN p.plan END \
 FROM \
-	pg_store_plans p \
-	LEFT JOIN pg_roles r ON r.oid = p.userid \
-WHERE \
-	r.rolname <> ALL (('{' || $1 || '}')::text[]) \
+	(SELECT \
+		p.* \
+	 FROM \
+		pg_store_plans p \
+		LEFT JOIN pg_roles r ON r.oid = p.userid \
+	 WHERE \
+		r.rolname <> ALL (('{' || $1 || '}')::text[]) \
+	 ORDER BY \
+		p.total_time DESC LIMIT $2) p \
+	CROSS JOIN LATERAL \
+	(SELECT ('x' || pg_catalog.substr(pg_catalog.md5(p.plan), 1, 16))::bit(64)::bigint \
+		AS plan_hash) h \
+	LEFT JOIN pg_catalog.unnest($3::bigint[], $4::bigint[]) AS k(planid, hash) \
+	ON k.planid = p.planid AND k.hash = h.plan_hash \
 ORDER BY \
-	p.total_time DESC LIMIT $2"
+	p.total_time DESC"
 
 /* lock */
 #define SQL_SELECT_LOCK_APPNAME				"sa.application_name"
@@ -158,7 +359,7 @@ ORDER BY \
 
 #define SQL_SELECT_LOCK "\
 SELECT \
-	sa.datid, \
+	t.dbid, \
 	ns.nspname, \
 	t.relation, \
 	sa.application_name, \
@@ -168,35 +369,27 @@ SELECT \
 	t.blockee_pid, \
 	t.blocker_pid, \
 	px.gid AS blocker_gid, \
-	sa.wait_event_type, \
-	sa.wait_event, \
-	(pg_catalog.statement_timestamp() - t.waitstart)::interval(0), \
-	sa.query, \
+	t.wait_event_type, \
+	t.wait_event, \
+	(t.last_seen - t.waitstart)::interval(0), \
+	t.blockee_query, \
 	CASE \
 		WHEN px.gid IS NOT NULL THEN '(xact is detached from session)' \
-		WHEN lx.queries IS NULL THEN '(library might not have been loaded)' \
-		ELSE lx.queries \
-	END \
-FROM \
-	(SELECT DISTINCT \
-		pid AS blockee_pid, \
-		pg_catalog.unnest(pg_catalog.pg_blocking_pids(pid)) AS blocker_pid, \
-		transactionid, \
-		relation, \
-		waitstart \
-	 FROM \
-		pg_locks \
-	 WHERE \
-		granted = false \
-	) t \
+		WHEN lx.queries IS NOT NULL THEN lx.queries \
+		WHEN t.blocker_query IS NOT NULL THEN t.blocker_query \
+		ELSE '(library might not have been loaded)' \
+	END, \
+	t.waitstart, \
+	t.samples \
+FROM \
+	statsinfo.lock_waits() t \
 	LEFT JOIN pg_prepared_xacts px ON px.transaction = t.transactionid \
 	LEFT JOIN pg_stat_activity sa ON sa.pid = t.blockee_pid \
 	LEFT JOIN statsinfo.last_xact_activity() lx ON lx.pid = t.blocker_pid \
-	LEFT JOIN pg_database db ON db.oid = sa.datid \
 	LEFT JOIN pg_class c ON c.oid = t.relation \
 	LEFT JOIN pg_namespace ns ON ns.oid = c.relnamespace \
 WHERE \
-	t.waitstart < pg_catalog.statement_timestamp() - pg_catalog.current_setting('" GUC_PREFIX ".long_lock_threshold')::interval"
+	t.last_seen - t.waitstart > pg_catalog.current_setting('" GUC_PREFIX ".long_lock_threshold')::interval"
 
 /* bgwriter */
 #define SQL_SELECT_BGWRITER "\
@@ -207,6 +400,59 @@ SELECT \
 FROM \
 	pg_stat_bgwriter"
 
+/* buffercache */
+#define SQL_SELECT_BUFFERCACHE "\
+SELECT \
+	b.reldatabase, \
+	b.reltablespace, \
+	b.relfilenode, \
+	b.relforknumber, \
+	n.nspname, \
+	c.relname, \
+	b.buffers, \
+	b.dirty, \
+	b.pinned, \
+	b.usagecount_0, \
+	b.usagecount_1, \
+	b.usagecount_2, \
+	b.usagecount_3, \
+	b.usagecount_4, \
+	b.usagecount_5 \
+FROM \
+	(SELECT \
+		reldatabase, \
+		reltablespace, \
+		relfilenode, \
+		relforknumber, \
+		pg_catalog.count(*) AS buffers, \
+		pg_catalog.count(*) FILTER (WHERE isdirty) AS dirty, \
+		pg_catalog.sum(pinning_backends) AS pinned, \
+		pg_catalog.count(*) FILTER (WHERE usagecount = 0) AS usagecount_0, \
+		pg_catalog.count(*) FILTER (WHERE usagecount = 1) AS usagecount_1, \
+		pg_catalog.count(*) FILTER (WHERE usagecount = 2) AS usagecount_2, \
+		pg_catalog.count(*) FILTER (WHERE usagecount = 3) AS usagecount_3, \
+		pg_catalog.count(*) FILTER (WHERE usagecount = 4) AS usagecount_4, \
+		pg_catalog.count(*) FILTER (WHERE usagecount >= 5) AS usagecount_5 \
+	 FROM \
+		pg_buffercache \
+	 WHERE \
+		relfilenode IS NOT NULL \
+	 GROUP BY \
+		reldatabase, \
+		reltablespace, \
+		relfilenode, \
+		relforknumber \
+	 ORDER BY \
+		buffers DESC LIMIT $1 \
+	) b \
+	LEFT JOIN pg_class c ON \
+		b.reldatabase IN (0, (SELECT oid FROM pg_database WHERE datname = pg_catalog.current_database())) \
+	AND \
+		c.oid = pg_catalog.pg_filenode_relation(b.reltablespace, b.relfilenode) \
+	LEFT JOIN pg_namespace n ON n.oid = c.relnamespace \
+ORDER BY \
+	b.buffers DESC"
+
 /* replication */
 #define SQL_SELECT_REPLICATION_BACKEND_XMIN		"backend_xmin"
 
@@ -327,6 +573,54 @@ SELECT \
 WHERE \
 	NOT pg_catalog.pg_is_in_recovery()"
 
+/* wal composition */
+#define SQL_SELECT_WAL_LOCATION "\
+SELECT \
+	pg_catalog.pg_current_wal_lsn() \
+WHERE \
+	NOT pg_catalog.pg_is_in_recovery()"
+
+/*
+ * $1: location of the previous snapshot, $2: current location,
+ * $3: max size to be inspected (MB). If the interval is larger than the
+ * budget, only the latest part of it is inspected. The start never goes
+ * before the oldest WAL segment of the current timeline still in pg_wal,
+ * because older segments may have been recycled already.
+ */
+#define SQL_SELECT_WAL_COMPOSITION "\
+SELECT \
+	r.start_lsn, \
+	r.end_lsn, \
+	pg_catalog.split_part(w.resource_manager, '/', 1), \
+	pg_catalog.split_part(w.resource_manager, '/', 2), \
+	w.count, \
+	w.record_size, \
+	w.fpi_size, \
+	w.combined_size \
+FROM \
+	(SELECT \
+		GREATEST( \
+			CASE WHEN pg_catalog.pg_wal_lsn_diff($2::pg_lsn, $1::pg_lsn) > $3::numeric * 1024 * 1024 \
+				THEN $2::pg_lsn - $3::numeric * 1024 * 1024 \
+				ELSE $1::pg_lsn END, \
+			(SELECT \
+				'0/0'::pg_lsn + \
+				('x' || pg_catalog.substr(name, 9, 8))::bit(32)::bigint::numeric * 4294967296 + \
+				('x' || pg_catalog.substr(name, 17, 8))::bit(32)::bigint::numeric * \
+					pg_catalog.pg_size_bytes(pg_catalog.current_setting('wal_segment_size')) \
+			 FROM pg_catalog.pg_ls_waldir() \
+			 WHERE name ~ '^[0-9A-F]{24}$' \
+			   AND pg_catalog.substr(name, 1, 8) = \
+				   pg_catalog.substr(pg_catalog.pg_walfile_name($2::pg_lsn), 1, 8) \
+			 ORDER BY name LIMIT 1)) AS start_lsn, \
+		$2::pg_lsn AS end_lsn \
+	) r, \
+	pg_get_wal_stats(r.start_lsn, r.end_lsn, true) w \
+WHERE \
+	r.start_lsn < r.end_lsn \
+AND \
+	w.count > 0"
+
 /* archive */
 #define SQL_SELECT_ARCHIVE "\
 SELECT * FROM pg_stat_archiver"
@@ -335,6 +629,65 @@ SELECT * FROM pg_stat_archiver"
 #define SQL_SELECT_CPU "\
 SELECT * FROM statsinfo.cpustats($1)"
 
+/* escalation triggers, sampled by the collector */
+#define SQL_SELECT_ESCALATION "\
+SELECT \
+	(SELECT pg_catalog.count(*) FROM pg_stat_activity \
+	 WHERE wait_event_type = 'Lock'), \
+	(SELECT COALESCE(pg_catalog.max(EXTRACT(epoch FROM \
+		GREATEST(write_lag, flush_lag, replay_lag)))::bigint, 0) \
+	 FROM pg_stat_replication), \
+	c.cpu_user, \
+	c.cpu_system, \
+	c.cpu_idle, \
+	c.cpu_iowait \
+FROM \
+	statsinfo.cpustats() c"
+
+/* instance-level counters of a mini-snapshot, run as a prepared statement */
+#define SQL_SELECT_INSTANCE_TS "\
+SELECT \
+	pg_catalog.now(), \
+	d.xact_commit, \
+	d.xact_rollback, \
+	d.blks_read, \
+	d.blks_hit, \
+	w.wal_bytes, \
+	io.reads, \
+	io.writes, \
+	io.extends, \
+	io.fsyncs, \
+	b.buffers_clean, \
+	b.buffers_alloc, \
+	c.num_timed, \
+	c.num_requested, \
+	c.buffers_written, \
+	a.active, \
+	a.idle_in_xact, \
+	a.waiting \
+FROM \
+	(SELECT \
+		pg_catalog.sum(xact_commit)::bigint AS xact_commit, \
+		pg_catalog.sum(xact_rollback)::bigint AS xact_rollback, \
+		pg_catalog.sum(blks_read)::bigint AS blks_read, \
+		pg_catalog.sum(blks_hit)::bigint AS blks_hit \
+	 FROM pg_stat_database) d, \
+	pg_stat_wal w, \
+	(SELECT \
+		pg_catalog.sum(reads)::bigint AS reads, \
+		pg_catalog.sum(writes)::bigint AS writes, \
+		pg_catalog.sum(extends)::bigint AS extends, \
+		pg_catalog.sum(fsyncs)::bigint AS fsyncs \
+	 FROM pg_stat_io) io, \
+	pg_stat_bgwriter b, \
+	pg_stat_checkpointer c, \
+	(SELECT \
+		pg_catalog.count(*) FILTER (WHERE state = 'active')::integer AS active, \
+		pg_catalog.count(*) FILTER (WHERE state LIKE 'idle in transaction%')::integer AS idle_in_xact, \
+		pg_catalog.count(*) FILTER (WHERE wait_event_type = 'Lock')::integer AS waiting \
+	 FROM pg_stat_activity \
+	 WHERE backend_type = 'client backend') a"
+
 /* device */
 #define SQL_SELECT_DEVICE "\
 SELECT * FROM statsinfo.devicestats()"
@@ -432,8 +785,13 @@ WHERE \
 GROUP BY \
 	c.oid"
 
-/* column */
-
+/*
+ * column
+ *
+ * With pg_statsinfo.collect_column_rotation = N, only the tables whose oid
+ * modulo N matches the rotation counter $2 of the agent modulo N are
+ * collected, so that all of the tables are collected every N snapshots.
+ */
 #define SQL_SELECT_COLUMN "\
 SELECT \
 	a.attrelid, \
@@ -463,12 +821,20 @@ FROM \
 		a.attrelid = s.starelid AND NOT s.stainherit \
 	LEFT JOIN pg_namespace n ON \
 		c.relnamespace = n.oid \
+	CROSS JOIN \
+	(SELECT \
+		pg_catalog.max(setting::bigint) AS slices \
+	 FROM pg_settings \
+	 WHERE name = 'pg_statsinfo.collect_column_rotation') r \
 WHERE \
 	a.attnum > 0 \
 AND \
 	c.relkind IN ('r', 't') \
 AND \
-	n.nspname <> ALL (('{' || $1 || '}')::text[])"
+	n.nspname <> ALL (('{' || $1 || '}')::text[]) \
+AND \
+	(coalesce(r.slices, 1) <= 1 OR \
+	 a.attrelid::bigint % r.slices = $2::bigint % r.slices)"
 
 /* index */
 #define SQL_SELECT_INDEX "\
@@ -503,6 +869,172 @@ WHERE \
 	c.relkind IN ('r', 't') AND \
 	n.nspname <> ALL (('{' || $1 || '}')::text[])"
 
+/*
+ * leaf partitions rolled up into their root partitioned table. The most
+ * active leaves of each root are kept individually.
+ */
+#define SQL_SELECT_ROLLUP_LEAVES "\
+SELECT \
+	l.relid, \
+	l.root \
+FROM \
+	(SELECT \
+		p.relid, \
+		p.root, \
+		pg_catalog.row_number() OVER (PARTITION BY p.root ORDER BY \
+			pg_catalog.pg_stat_get_tuples_inserted(p.relid) + \
+			pg_catalog.pg_stat_get_tuples_updated(p.relid) + \
+			pg_catalog.pg_stat_get_tuples_deleted(p.relid) + \
+			pg_catalog.pg_stat_get_numscans(p.relid) DESC) AS rank \
+	 FROM \
+		(SELECT \
+			c.oid AS relid, \
+			pg_catalog.pg_partition_root(c.oid) AS root \
+		 FROM \
+			pg_class c \
+		 WHERE \
+			c.relispartition AND c.relkind = 'r') p \
+		JOIN pg_class rc ON rc.oid = p.root \
+		JOIN pg_namespace rn ON rn.oid = rc.relnamespace \
+	 WHERE \
+		rn.nspname || '.' || rc.relname LIKE ANY (pg_catalog.regexp_split_to_array( \
+			pg_catalog.current_setting('" GUC_PREFIX ".partition_rollup'), '\\s*,\\s*'))) l \
+WHERE \
+	l.rank > pg_catalog.current_setting('" GUC_PREFIX ".partition_rollup_keep')::integer"
+
+/*
+ * The leaves and their TOAST tables are decided once per snapshot, and kept
+ * in a session variable as an array of {relid, root}, so that the queries of
+ * tables, indexes and columns roll up the same leaves.
+ */
+#define SQL_ROLLUP_LEAVES_GUC	"statsinfo.rollup_leaves"
+
+#define SQL_SELECT_ROLLUP_LEAF_SET "\
+WITH l AS ( \
+	" SQL_SELECT_ROLLUP_LEAVES " \
+) \
+SELECT \
+	COALESCE(pg_catalog.array_agg(ARRAY[r.relid, r.root]), '{}')::text \
+FROM \
+	(SELECT l.relid, l.root FROM l \
+	 UNION ALL \
+	 SELECT c.reltoastrelid, l.root FROM l JOIN pg_class c ON c.oid = l.relid \
+	 WHERE c.reltoastrelid <> 0) r"
+
+#define SQL_SET_ROLLUP_LEAVES "\
+SELECT pg_catalog.set_config('" SQL_ROLLUP_LEAVES_GUC "', $1, false)"
+
+#define SQL_SET_ROLLUP_LEAVES_NEW "\
+SELECT pg_catalog.set_config('" SQL_ROLLUP_LEAVES_GUC "', \
+	(" SQL_SELECT_ROLLUP_LEAF_SET "), false)"
+
+#define SQL_ROLLUP_LEAVES "\
+SELECT \
+	s.leaves[i][1] AS relid, \
+	s.leaves[i][2] AS root \
+FROM \
+	(SELECT pg_catalog.current_setting('" SQL_ROLLUP_LEAVES_GUC "')::oid[] AS leaves) s, \
+	pg_catalog.generate_subscripts(s.leaves, 1) AS i"
+
+/*
+ * statistics of tables with the rolled up leaves summed into the root. The
+ * size of the root includes the TOAST tables of the leaves.
+ */
+#define SQL_SELECT_TABLE_ROLLUP(tables) "\
+WITH t ( \
+	relid, relnamespace, reltablespace, relname, reltoastrelid, \
+	reltoastidxid, relkind, relpages, reltuples, reloptions, size, \
+	seq_scan, seq_tup_read, idx_scan, idx_tup_fetch, n_tup_ins, \
+	n_tup_upd, n_tup_del, n_tup_hot_upd, n_live_tup, n_dead_tup, \
+	n_mod_since_analyze, heap_blks_read, heap_blks_hit, idx_blks_read, \
+	idx_blks_hit, toast_blks_read, toast_blks_hit, tidx_blks_read, \
+	tidx_blks_hit, last_vacuum, last_autovacuum, last_analyze, \
+	last_autoanalyze) AS ( \
+	" tables " \
+), r AS ( \
+	" SQL_ROLLUP_LEAVES " \
+) \
+SELECT t.* FROM t WHERE t.relid NOT IN (SELECT relid FROM r) \
+UNION ALL \
+SELECT \
+	c.oid, \
+	c.relnamespace, \
+	c.reltablespace, \
+	c.relname, \
+	c.reltoastrelid, \
+	NULL::oid, \
+	c.relkind, \
+	a.relpages, \
+	a.reltuples, \
+	c.reloptions, \
+	a.size, \
+	a.seq_scan, \
+	a.seq_tup_read, \
+	a.idx_scan, \
+	a.idx_tup_fetch, \
+	a.n_tup_ins, \
+	a.n_tup_upd, \
+	a.n_tup_del, \
+	a.n_tup_hot_upd, \
+	a.n_live_tup, \
+	a.n_dead_tup, \
+	a.n_mod_since_analyze, \
+	a.heap_blks_read, \
+	a.heap_blks_hit, \
+	a.idx_blks_read, \
+	a.idx_blks_hit, \
+	a.toast_blks_read, \
+	a.toast_blks_hit, \
+	a.tidx_blks_read, \
+	a.tidx_blks_hit, \
+	a.last_vacuum, \
+	a.last_autovacuum, \
+	a.last_analyze, \
+	a.last_autoanalyze \
+FROM \
+	(SELECT \
+		r.root, \
+		pg_catalog.sum(t.relpages) FILTER (WHERE t.relkind <> 't')::integer AS relpages, \
+		pg_catalog.sum(pg_catalog.greatest(t.reltuples, 0)) FILTER (WHERE t.relkind <> 't')::real AS reltuples, \
+		pg_catalog.sum(t.size)::bigint AS size, \
+		pg_catalog.sum(t.seq_scan) FILTER (WHERE t.relkind <> 't')::bigint AS seq_scan, \
+		pg_catalog.sum(t.seq_tup_read) FILTER (WHERE t.relkind <> 't')::bigint AS seq_tup_read, \
+		pg_catalog.sum(t.idx_scan) FILTER (WHERE t.relkind <> 't')::bigint AS idx_scan, \
+		pg_catalog.sum(t.idx_tup_fetch) FILTER (WHERE t.relkind <> 't')::bigint AS idx_tup_fetch, \
+		pg_catalog.sum(t.n_tup_ins) FILTER (WHERE t.relkind <> 't')::bigint AS n_tup_ins, \
+		pg_catalog.sum(t.n_tup_upd) FILTER (WHERE t.relkind <> 't')::bigint AS n_tup_upd, \
+		pg_catalog.sum(t.n_tup_del) FILTER (WHERE t.relkind <> 't')::bigint AS n_tup_del, \
+		pg_catalog.sum(t.n_tup_hot_upd) FILTER (WHERE t.relkind <> 't')::bigint AS n_tup_hot_upd, \
+		pg_catalog.sum(t.n_live_tup) FILTER (WHERE t.relkind <> 't')::bigint AS n_live_tup, \
+		pg_catalog.sum(t.n_dead_tup) FILTER (WHERE t.relkind <> 't')::bigint AS n_dead_tup, \
+		pg_catalog.sum(t.n_mod_since_analyze) FILTER (WHERE t.relkind <> 't')::bigint AS n_mod_since_analyze, \
+		pg_catalog.sum(t.heap_blks_read) FILTER (WHERE t.relkind <> 't')::bigint AS heap_blks_read, \
+		pg_catalog.sum(t.heap_blks_hit) FILTER (WHERE t.relkind <> 't')::bigint AS heap_blks_hit, \
+		pg_catalog.sum(t.idx_blks_read) FILTER (WHERE t.relkind <> 't')::bigint AS idx_blks_read, \
+		pg_catalog.sum(t.idx_blks_hit) FILTER (WHERE t.relkind <> 't')::bigint AS idx_blks_hit, \
+		pg_catalog.sum(t.toast_blks_read) FILTER (WHERE t.relkind <> 't')::bigint AS toast_blks_read, \
+		pg_catalog.sum(t.toast_blks_hit) FILTER (WHERE t.relkind <> 't')::bigint AS toast_blks_hit, \
+		pg_catalog.sum(t.tidx_blks_read) FILTER (WHERE t.relkind <> 't')::bigint AS tidx_blks_read, \
+		pg_catalog.sum(t.tidx_blks_hit) FILTER (WHERE t.relkind <> 't')::bigint AS tidx_blks_hit, \
+		pg_catalog.max(t.last_vacuum) FILTER (WHERE t.relkind <> 't') AS last_vacuum, \
+		pg_catalog.max(t.last_autovacuum) FILTER (WHERE t.relkind <> 't') AS last_autovacuum, \
+		pg_catalog.max(t.last_analyze) FILTER (WHERE t.relkind <> 't') AS last_analyze, \
+		pg_catalog.max(t.last_autoanalyze) FILTER (WHERE t.relkind <> 't') AS last_autoanalyze \
+	 FROM \
+		t JOIN r ON r.relid = t.relid \
+	 GROUP BY \
+		r.root) a \
+	JOIN pg_class c ON c.oid = a.root"
+
+/* statistics of indexes and columns except for the rolled up leaves */
+#define SQL_SELECT_INDEX_ROLLUP(indexes) "\
+SELECT i.* FROM (" indexes ") i \
+WHERE i.relid NOT IN (SELECT relid FROM (" SQL_ROLLUP_LEAVES ") r)"
+
+#define SQL_SELECT_COLUMN_ROLLUP(columns) "\
+SELECT a.* FROM (" columns ") a \
+WHERE a.attrelid NOT IN (SELECT relid FROM (" SQL_ROLLUP_LEAVES ") r)"
+
 /* inherits */
 #define SQL_SELECT_INHERITS "\
 SELECT \
@@ -516,22 +1048,31 @@ FROM \
 WHERE \
 	n.nspname <> ALL (('{' || $1 || '}')::text[])"
 
-/* function */
+/* function, only the definitions which are written when changed */
 #define SQL_SELECT_FUNCTION "\
 SELECT \
 	s.funcid, \
 	n.oid AS nspid, \
 	s.funcname, \
-	pg_catalog.pg_get_function_arguments(funcid) AS argtypes, \
-	s.calls, \
-	s.total_time, \
-	s.self_time \
+	pg_catalog.pg_get_function_arguments(funcid) AS argtypes \
 FROM \
 	pg_stat_user_functions s JOIN \
 	pg_namespace n ON s.schemaname = n.nspname \
 WHERE \
 	n.nspname <> ALL (('{' || $1 || '}')::text[])"
 
+/* counters of the functions above */
+#define SQL_SELECT_STAT_FUNCTION "\
+SELECT \
+	s.funcid, \
+	s.calls, \
+	s.total_time, \
+	s.self_time \
+FROM \
+	pg_stat_user_functions s \
+WHERE \
+	s.schemaname <> ALL (('{' || $1 || '}')::text[])"
+
 /* wait sampling profile */
 #define SQL_SELECT_WAIT_SAMPLING_PROFILE	"SELECT * FROM statsinfo.wait_sampling_profile()"
 
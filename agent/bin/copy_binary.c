@@ -0,0 +1,727 @@
+/*
+ * copy_binary.c : COPY FROM STDIN in the binary format
+ *
+ * Copyright (c) 2009-2025, NIPPON TELEGRAPH AND TELEPHONE CORPORATION
+ */
+
+#include "pg_statsinfod.h"
+
+#include "catalog/pg_type_d.h"
+#include "port/pg_bswap.h"
+
+#include "writer_sql.h"
+
+#define COPY_BINARY_SIGNATURE		"PGCOPY\n\377\r\n"
+#define COPY_BINARY_SIGNATURE_LEN	11
+
+/* days between 0000-03-01 and 2000-01-01 (the epoch of date and timestamp) */
+#define POSTGRES_EPOCH_DAYS			730425
+#define USECS_PER_SEC				INT64CONST(1000000)
+
+/* column types of a repository table */
+typedef struct CopyTypes
+{
+	char	   *relname;
+	int			ncols;
+	Oid		   *types;
+} CopyTypes;
+
+/* cache of column types, valid while the connection is the same */
+static PGconn  *copy_types_conn = NULL;
+static List	   *copy_types = NIL;
+
+static CopyTypes *get_copy_types(PGconn *conn, const char *relname);
+static void free_copy_types(CopyTypes *ct);
+static bool is_supported_type(Oid type);
+static bool encode_row(StringInfo buf, CopyTypes *ct, PGresult *src, int row,
+					   const char **values, int nprefix, const char *snap_date,
+					   int part_key_position);
+static bool encode_value(StringInfo buf, Oid type, const char *value);
+static bool encode_date(StringInfo buf, const char *value);
+static bool encode_timestamp(StringInfo buf, const char *value, bool tz);
+static bool encode_char(StringInfo buf, const char *value);
+static bool encode_text_array(StringInfo buf, const char *value);
+static bool encode_int2vector(StringInfo buf, const char *value);
+static bool parse_date(const char **p, int64 *days);
+static void append_int16(StringInfo buf, int16 value);
+static void append_int32(StringInfo buf, int32 value);
+static void append_int64(StringInfo buf, int64 value);
+static void append_field(StringInfo buf, const char *data, int32 len);
+
+/*
+ * copy_binary - write the rows of 'src' with COPY ... (FORMAT binary).
+ *
+ * 'sql' is the text format COPY command of the target table. Values are
+ * encoded from their text representation into the binary format of the
+ * repository column types, which are resolved once per connection. All of
+ * the rows are checked to be encodable before the COPY starts, and then they
+ * are encoded again and sent every copy_chunk_size kilobytes, so that only
+ * a chunk of them is kept in memory.
+ *
+ * Returns COPY_BINARY_UNSUPPORTED without sending anything when some of the
+ * columns or values cannot be encoded, and then the caller should use the
+ * text format.
+ */
+CopyBinaryResult
+copy_binary(PGconn *conn,
+			const char *sql,
+			PGresult *src,
+			const char *snapid,
+			const char *dbid,
+			const char *snap_date,
+			int part_key_position)
+{
+	char			relname[NAMEDATALEN * 2 + 2];
+	const char	   *p;
+	CopyTypes	   *ct;
+	StringInfoData	buf;
+	StringInfoData	query;
+	PGresult	   *res;
+	const char	  **values;
+	int				nprefix;
+	int				chunk_size;
+	int				rows;
+	int				r;
+	int				i;
+	bool			ok = true;
+
+	/* extract the table name from "COPY <relname> FROM ..." */
+	if (pg_strncasecmp(sql, "COPY ", 5) != 0)
+		return COPY_BINARY_UNSUPPORTED;
+	sql += 5;
+	if ((p = strchr(sql, ' ')) == NULL || p - sql >= sizeof(relname))
+		return COPY_BINARY_UNSUPPORTED;
+	memcpy(relname, sql, p - sql);
+	relname[p - sql] = '\0';
+
+	nprefix = 1 + (dbid ? 1 : 0);
+	ct = get_copy_types(conn, relname);
+	if (ct == NULL ||
+		ct->ncols != nprefix + PQnfields(src) + (snap_date ? 1 : 0))
+		return COPY_BINARY_UNSUPPORTED;
+
+	for (i = 0; i < ct->ncols; i++)
+	{
+		if (!is_supported_type(ct->types[i]))
+			return COPY_BINARY_UNSUPPORTED;
+	}
+
+	values = pgut_newarray(const char *, ct->ncols);
+	values[0] = snapid;
+	if (dbid)
+		values[1] = dbid;
+	initStringInfo(&buf);
+
+	/*
+	 * Try to encode each of the rows first, so that a value which cannot be
+	 * encoded leads to the text format before anything is sent.
+	 */
+	rows = PQntuples(src);
+	for (r = 0; r < rows; r++)
+	{
+		resetStringInfo(&buf);
+		if (!encode_row(&buf, ct, src, r, values, nprefix, snap_date,
+						part_key_position))
+		{
+			termStringInfo(&buf);
+			free(values);
+			return COPY_BINARY_UNSUPPORTED;
+		}
+	}
+
+	initStringInfo(&query);
+	appendStringInfo(&query, SQL_COPY_BINARY, relname);
+	res = pgut_execute(conn, query.data, 0, NULL);
+	termStringInfo(&query);
+	if (PQresultStatus(res) != PGRES_COPY_IN)
+	{
+		PQclear(res);
+		termStringInfo(&buf);
+		free(values);
+		return COPY_BINARY_FAILED;
+	}
+	PQclear(res);
+
+	/* header: signature, flags and header extension length */
+	resetStringInfo(&buf);
+	appendBinaryStringInfo(&buf, COPY_BINARY_SIGNATURE, COPY_BINARY_SIGNATURE_LEN);
+	append_int32(&buf, 0);
+	append_int32(&buf, 0);
+
+	chunk_size = Max(copy_chunk_size, 1) * 1024;
+	for (r = 0; r < rows && ok; r++)
+	{
+		encode_row(&buf, ct, src, r, values, nprefix, snap_date,
+				   part_key_position);
+		if (buf.len >= chunk_size)
+		{
+			if (PQputCopyData(conn, buf.data, buf.len) != 1)
+				ok = false;
+			resetStringInfo(&buf);
+		}
+	}
+
+	/* trailer */
+	append_int16(&buf, -1);
+	if (ok && PQputCopyData(conn, buf.data, buf.len) != 1)
+		ok = false;
+	termStringInfo(&buf);
+	free(values);
+
+	if (PQputCopyEnd(conn, ok ? NULL : "could not send the data") != 1)
+		ok = false;
+
+	/* the result of the COPY */
+	while ((res = PQgetResult(conn)) != NULL)
+	{
+		if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		{
+			if (ok)
+				elog(WARNING, "COPY failed: %s", PQerrorMessage(conn));
+			ok = false;
+		}
+		PQclear(res);
+	}
+
+	return ok ? COPY_BINARY_OK : COPY_BINARY_FAILED;
+}
+
+/*
+ * copy_binary_reset - forget the cached column types
+ */
+void
+copy_binary_reset(void)
+{
+	list_destroy(copy_types, free_copy_types);
+	copy_types = NIL;
+	copy_types_conn = NULL;
+}
+
+static CopyTypes *
+get_copy_types(PGconn *conn, const char *relname)
+{
+	ListCell   *cell;
+	CopyTypes  *ct;
+	PGresult   *res;
+	const char *params[1];
+	int			i;
+
+	if (conn != copy_types_conn)
+	{
+		copy_binary_reset();
+		copy_types_conn = conn;
+	}
+
+	foreach(cell, copy_types)
+	{
+		ct = (CopyTypes *) lfirst(cell);
+		if (strcmp(ct->relname, relname) == 0)
+			return ct->ncols > 0 ? ct : NULL;
+	}
+
+	params[0] = relname;
+	res = pgut_execute(conn, SQL_SELECT_COPY_TYPES, 1, params);
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		PQclear(res);
+		return NULL;
+	}
+
+	/* an unknown table is cached with no columns */
+	ct = pgut_new(CopyTypes);
+	ct->relname = pgut_strdup(relname);
+	ct->ncols = PQntuples(res);
+	ct->types = pgut_newarray(Oid, Max(ct->ncols, 1));
+	for (i = 0; i < ct->ncols; i++)
+		ct->types[i] = (Oid) strtoul(PQgetvalue(res, i, 0), NULL, 10);
+	PQclear(res);
+
+	copy_types = lappend(copy_types, ct);
+
+	return ct->ncols > 0 ? ct : NULL;
+}
+
+static void
+free_copy_types(CopyTypes *ct)
+{
+	if (ct)
+	{
+		free(ct->relname);
+		free(ct->types);
+		free(ct);
+	}
+}
+
+static bool
+is_supported_type(Oid type)
+{
+	switch (type)
+	{
+		case BOOLOID:
+		case CHAROID:
+		case NAMEOID:
+		case INT8OID:
+		case INT2OID:
+		case INT4OID:
+		case TEXTOID:
+		case OIDOID:
+		case FLOAT4OID:
+		case FLOAT8OID:
+		case VARCHAROID:
+		case DATEOID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+		case TEXTARRAYOID:
+		case INT2VECTOROID:
+			return true;
+		default:
+			return false;
+	}
+}
+
+/*
+ * encode_row - append a tuple of the row of 'src'. 'values' has room for all
+ * of the columns, and the first 'nprefix' of them are already filled.
+ */
+static bool
+encode_row(StringInfo buf,
+		   CopyTypes *ct,
+		   PGresult *src,
+		   int row,
+		   const char **values,
+		   int nprefix,
+		   const char *snap_date,
+		   int part_key_position)
+{
+	int		cols = PQnfields(src);
+	int		c;
+	int		i;
+
+	/* same order as the text format */
+	i = nprefix;
+	for (c = 0; c < cols; c++)
+	{
+		if (c == part_key_position && snap_date)
+			values[i++] = snap_date;
+		values[i++] = PQgetisnull(src, row, c) ? NULL : PQgetvalue(src, row, c);
+	}
+
+	append_int16(buf, ct->ncols);
+	for (i = 0; i < ct->ncols; i++)
+	{
+		if (!encode_value(buf, ct->types[i], values[i]))
+		{
+			elog(DEBUG2, "could not encode \"%s\" for column %d of %s",
+				 values[i], i + 1, ct->relname);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * encode_value - append a field in the binary format of 'type'
+ */
+static bool
+encode_value(StringInfo buf, Oid type, const char *value)
+{
+	if (value == NULL)
+	{
+		append_int32(buf, -1);
+		return true;
+	}
+
+	switch (type)
+	{
+		case BOOLOID:
+		{
+			bool	b;
+			char	c;
+
+			if (!parse_bool(value, &b))
+				return false;
+			c = b ? 1 : 0;
+			append_field(buf, &c, 1);
+			return true;
+		}
+		case CHAROID:
+			return encode_char(buf, value);
+		case NAMEOID:
+		case TEXTOID:
+		case VARCHAROID:
+			append_field(buf, value, strlen(value));
+			return true;
+		case INT2OID:
+		{
+			int32	i;
+
+			if (!parse_int32(value, &i) || i < PG_INT16_MIN || i > PG_INT16_MAX)
+				return false;
+			append_int32(buf, sizeof(int16));
+			append_int16(buf, (int16) i);
+			return true;
+		}
+		case INT4OID:
+		{
+			int32	i;
+
+			if (!parse_int32(value, &i))
+				return false;
+			append_int32(buf, sizeof(int32));
+			append_int32(buf, i);
+			return true;
+		}
+		case OIDOID:
+		{
+			uint32	u;
+
+			if (!parse_uint32(value, &u))
+				return false;
+			append_int32(buf, sizeof(uint32));
+			append_int32(buf, (int32) u);
+			return true;
+		}
+		case INT8OID:
+		{
+			int64	i;
+
+			if (!parse_int64(value, &i))
+				return false;
+			append_int32(buf, sizeof(int64));
+			append_int64(buf, i);
+			return true;
+		}
+		case FLOAT4OID:
+		{
+			union { float4 f; int32 i; } u;
+			char   *end;
+
+			errno = 0;
+			u.f = strtof(value, &end);
+			if (end == value || *end != '\0' || errno == ERANGE)
+				return false;
+			append_int32(buf, sizeof(float4));
+			append_int32(buf, u.i);
+			return true;
+		}
+		case FLOAT8OID:
+		{
+			union { float8 f; int64 i; } u;
+			char   *end;
+
+			errno = 0;
+			u.f = strtod(value, &end);
+			if (end == value || *end != '\0' || errno == ERANGE)
+				return false;
+			append_int32(buf, sizeof(float8));
+			append_int64(buf, u.i);
+			return true;
+		}
+		case DATEOID:
+			return encode_date(buf, value);
+		case TIMESTAMPOID:
+			return encode_timestamp(buf, value, false);
+		case TIMESTAMPTZOID:
+			return encode_timestamp(buf, value, true);
+		case TEXTARRAYOID:
+			return encode_text_array(buf, value);
+		case INT2VECTOROID:
+			return encode_int2vector(buf, value);
+		default:
+			return false;
+	}
+}
+
+/* date in the ISO format: YYYY-MM-DD */
+static bool
+encode_date(StringInfo buf, const char *value)
+{
+	int64	days;
+
+	if (!parse_date(&value, &days) || *value != '\0')
+		return false;
+
+	append_int32(buf, sizeof(int32));
+	append_int32(buf, (int32) days);
+	return true;
+}
+
+/*
+ * timestamp in the ISO format: YYYY-MM-DD HH:MI:SS[.FFFFFF][+-TZ[:MI[:SS]]]
+ * Collector connections always use DateStyle ISO. A timestamptz without the
+ * offset is in the TimeZone of the repository session, which is left to the
+ * text format.
+ */
+static bool
+encode_timestamp(StringInfo buf, const char *value, bool tz)
+{
+	const char *p = value;
+	int64		days;
+	int64		usecs;
+	int			hour, min, sec;
+	int			n;
+
+	if (strcmp(value, "infinity") == 0 || strcmp(value, "-infinity") == 0)
+	{
+		append_int32(buf, sizeof(int64));
+		append_int64(buf, value[0] == '-' ? PG_INT64_MIN : PG_INT64_MAX);
+		return true;
+	}
+
+	if (!parse_date(&p, &days))
+		return false;
+	if (sscanf(p, " %2d:%2d:%2d%n", &hour, &min, &sec, &n) != 3)
+		return false;
+	p += n;
+
+	usecs = ((days * 24 + hour) * 60 + min) * 60 + sec;
+	usecs *= USECS_PER_SEC;
+
+	/* fractional seconds */
+	if (*p == '.')
+	{
+		int64	scale = USECS_PER_SEC;
+
+		for (p++; isdigit((unsigned char) *p); p++)
+		{
+			scale /= 10;
+			usecs += (*p - '0') * scale;
+		}
+	}
+
+	/* time zone offset */
+	if (tz && *p != '+' && *p != '-')
+		return false;
+	if (tz)
+	{
+		int		sign = (*p == '+' ? 1 : -1);
+		int		offset[3] = {0, 0, 0};
+		int		i;
+
+		for (p++, i = 0; i < 3; i++)
+		{
+			if (!isdigit((unsigned char) p[0]) || !isdigit((unsigned char) p[1]))
+				return false;
+			offset[i] = (p[0] - '0') * 10 + (p[1] - '0');
+			p += 2;
+			if (*p != ':')
+				break;
+			p++;
+		}
+		usecs -= sign * ((offset[0] * 60 + offset[1]) * 60 + offset[2]) *
+				 USECS_PER_SEC;
+	}
+
+	if (*p != '\0')
+		return false;	/* BC or unknown format */
+
+	append_int32(buf, sizeof(int64));
+	append_int64(buf, usecs);
+	return true;
+}
+
+/* "char" is output as is, or as \ooo for non-ASCII characters */
+static bool
+encode_char(StringInfo buf, const char *value)
+{
+	char	c;
+
+	if (value[0] == '\0')
+	{
+		append_field(buf, value, 0);
+		return true;
+	}
+	else if (value[0] == '\\' && strlen(value) == 4)
+		c = (char) strtol(value + 1, NULL, 8);
+	else if (value[1] == '\0')
+		c = value[0];
+	else
+		return false;
+
+	append_field(buf, &c, 1);
+	return true;
+}
+
+/* one-dimensional text[] such as {a=1,"b c",NULL} */
+static bool
+encode_text_array(StringInfo buf, const char *value)
+{
+	StringInfoData	elems;
+	StringInfoData	elem;
+	const char	   *p = value;
+	int				nelems = 0;
+	bool			hasnull = false;
+	bool			ok = false;
+
+	if (*p++ != '{')
+		return false;
+
+	initStringInfo(&elems);
+	initStringInfo(&elem);
+
+	while (*p != '}')
+	{
+		resetStringInfo(&elem);
+
+		if (*p == '"')
+		{
+			for (p++; *p != '"'; p++)
+			{
+				if (*p == '\\')
+					p++;
+				if (*p == '\0')
+					goto done;
+				appendStringInfoChar(&elem, *p);
+			}
+			p++;
+			append_field(&elems, elem.data, elem.len);
+		}
+		else
+		{
+			for (; *p != ',' && *p != '}'; p++)
+			{
+				if (*p == '\0' || *p == '{' || *p == '"')
+					goto done;
+				appendStringInfoChar(&elem, *p);
+			}
+
+			if (pg_strcasecmp(elem.data, "NULL") == 0)
+			{
+				append_int32(&elems, -1);
+				hasnull = true;
+			}
+			else
+				append_field(&elems, elem.data, elem.len);
+		}
+		nelems++;
+
+		if (*p == ',')
+			p++;
+		else if (*p != '}')
+			goto done;
+	}
+
+	if (p[1] != '\0')
+		goto done;
+
+	/* ndim, flags, element type, then dimension and lower bound */
+	append_int32(buf, 12 + (nelems > 0 ? 8 : 0) + elems.len);
+	append_int32(buf, nelems > 0 ? 1 : 0);
+	append_int32(buf, hasnull ? 1 : 0);
+	append_int32(buf, TEXTOID);
+	if (nelems > 0)
+	{
+		append_int32(buf, nelems);
+		append_int32(buf, 1);
+	}
+	appendBinaryStringInfo(buf, elems.data, elems.len);
+	ok = true;
+
+done:
+	termStringInfo(&elems);
+	termStringInfo(&elem);
+	return ok;
+}
+
+/* int2vector such as "1 2 3", which is an int2 array starting at zero */
+static bool
+encode_int2vector(StringInfo buf, const char *value)
+{
+	StringInfoData	elems;
+	const char	   *p = value;
+	int				nelems = 0;
+
+	initStringInfo(&elems);
+	for (;;)
+	{
+		char   *end;
+		long	i;
+
+		while (*p == ' ')
+			p++;
+		if (*p == '\0')
+			break;
+
+		i = strtol(p, &end, 10);
+		if (end == p || i < PG_INT16_MIN || i > PG_INT16_MAX)
+		{
+			termStringInfo(&elems);
+			return false;
+		}
+		append_int32(&elems, sizeof(int16));
+		append_int16(&elems, (int16) i);
+		nelems++;
+		p = end;
+	}
+
+	append_int32(buf, 20 + elems.len);
+	append_int32(buf, 1);
+	append_int32(buf, 0);
+	append_int32(buf, INT2OID);
+	append_int32(buf, nelems);
+	append_int32(buf, 0);
+	appendBinaryStringInfo(buf, elems.data, elems.len);
+	termStringInfo(&elems);
+
+	return true;
+}
+
+/*
+ * parse_date - parse YYYY-MM-DD into days since 2000-01-01 and advance *p
+ */
+static bool
+parse_date(const char **p, int64 *days)
+{
+	int		year, month, day;
+	int		n;
+	int64	era;
+	int		yoe, doy;
+
+	if (sscanf(*p, "%d-%2d-%2d%n", &year, &month, &day, &n) != 3 ||
+		month < 1 || month > 12 || day < 1 || day > 31)
+		return false;
+	*p += n;
+
+	/* days from civil, counting years from March */
+	if (month <= 2)
+		year--;
+	era = (year >= 0 ? year : year - 399) / 400;
+	yoe = year - era * 400;
+	doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+	*days = era * 146097 + yoe * 365 + yoe / 4 - yoe / 100 + doy -
+			POSTGRES_EPOCH_DAYS;
+
+	return true;
+}
+
+static void
+append_int16(StringInfo buf, int16 value)
+{
+	uint16	n = pg_hton16((uint16) value);
+
+	appendBinaryStringInfo(buf, (char *) &n, sizeof(n));
+}
+
+static void
+append_int32(StringInfo buf, int32 value)
+{
+	uint32	n = pg_hton32((uint32) value);
+
+	appendBinaryStringInfo(buf, (char *) &n, sizeof(n));
+}
+
+static void
+append_int64(StringInfo buf, int64 value)
+{
+	uint64	n = pg_hton64((uint64) value);
+
+	appendBinaryStringInfo(buf, (char *) &n, sizeof(n));
+}
+
+static void
+append_field(StringInfo buf, const char *data, int32 len)
+{
+	append_int32(buf, len);
+	appendBinaryStringInfo(buf, data, len);
+}
@@ -39,11 +39,33 @@ pid_t			sil_pid;				/* pg_statsinfo launcher's pid */
 char		   *data_directory;
 char		   *excluded_dbnames;
 char		   *excluded_schemas;
+char		   *partition_rollup;
 char		   *stat_statements_max;
+bool			stat_statements_delta;
+char		   *stat_statements_top;
 char		   *stat_statements_exclude_users;
+char		   *buffercache_max;
+char		   *walinspect_max_size;
+int				copy_chunk_size;
+bool			snapshot_streaming;
+int				snapshot_chunk_rows;
+bool			snapshot_skip_idle;
+int				snapshot_budget;
 int				sampling_interval;
 int				wait_sampling_interval;
 int				snapshot_interval;
+int				snapshot_parallelism;
+int				connection_pool_size;
+int				connection_pool_idle_timeout;
+int				snapshot_jitter;
+int				repository_write_slots;
+int				mini_snapshot_interval;
+int				escalation_interval;
+int				escalation_duration;
+int				escalation_waiting_sessions;
+int				escalation_replication_lag;
+int				escalation_cpu_usage;
+bool			escalation_on_alert;
 int				enable_maintenance;
 time_t			maintenance_time;
 int				repository_keepday;
@@ -170,12 +192,34 @@ static struct ParamMap PARAM_MAP[] =
 	{"sil_pid", assign_int, &sil_pid},
 	{GUC_PREFIX ".excluded_dbnames", assign_string, &excluded_dbnames},
 	{GUC_PREFIX ".excluded_schemas", assign_string, &excluded_schemas},
+	{GUC_PREFIX ".partition_rollup", assign_string, &partition_rollup},
 	{GUC_PREFIX ".stat_statements_max", assign_string, &stat_statements_max},
+	{GUC_PREFIX ".stat_statements_delta", assign_bool, &stat_statements_delta},
+	{GUC_PREFIX ".stat_statements_top", assign_string, &stat_statements_top},
 	{GUC_PREFIX ".stat_statements_exclude_users", assign_string, &stat_statements_exclude_users},
+	{GUC_PREFIX ".buffercache_max", assign_string, &buffercache_max},
+	{GUC_PREFIX ".walinspect_max_size", assign_string, &walinspect_max_size},
+	{GUC_PREFIX ".copy_chunk_size", assign_int, &copy_chunk_size},
+	{GUC_PREFIX ".snapshot_streaming", assign_bool, &snapshot_streaming},
+	{GUC_PREFIX ".snapshot_chunk_rows", assign_int, &snapshot_chunk_rows},
+	{GUC_PREFIX ".snapshot_skip_idle", assign_bool, &snapshot_skip_idle},
+	{GUC_PREFIX ".snapshot_budget", assign_int, &snapshot_budget},
 	{GUC_PREFIX ".repository_server", assign_string, &repository_server},
 	{GUC_PREFIX ".sampling_interval", assign_int, &sampling_interval},
 	{GUC_PREFIX ".wait_sampling_interval", assign_int, &wait_sampling_interval},
 	{GUC_PREFIX ".snapshot_interval", assign_int, &snapshot_interval},
+	{GUC_PREFIX ".snapshot_parallelism", assign_int, &snapshot_parallelism},
+	{GUC_PREFIX ".connection_pool_size", assign_int, &connection_pool_size},
+	{GUC_PREFIX ".connection_pool_idle_timeout", assign_int, &connection_pool_idle_timeout},
+	{GUC_PREFIX ".snapshot_jitter", assign_int, &snapshot_jitter},
+	{GUC_PREFIX ".repository_write_slots", assign_int, &repository_write_slots},
+	{GUC_PREFIX ".mini_snapshot_interval", assign_int, &mini_snapshot_interval},
+	{GUC_PREFIX ".escalation_interval", assign_int, &escalation_interval},
+	{GUC_PREFIX ".escalation_duration", assign_int, &escalation_duration},
+	{GUC_PREFIX ".escalation_waiting_sessions", assign_int, &escalation_waiting_sessions},
+	{GUC_PREFIX ".escalation_replication_lag", assign_int, &escalation_replication_lag},
+	{GUC_PREFIX ".escalation_cpu_usage", assign_int, &escalation_cpu_usage},
+	{GUC_PREFIX ".escalation_on_alert", assign_bool, &escalation_on_alert},
 	{GUC_PREFIX ".syslog_line_prefix", assign_string, &syslog_line_prefix},
 	{GUC_PREFIX ".syslog_min_messages", assign_elevel, &syslog_min_messages},
 	{GUC_PREFIX ".textlog_min_messages", assign_elevel, &textlog_min_messages},
@@ -475,8 +519,7 @@ do_connect(PGconn **conn, const char *info, const char *schema)
 	if (PQstatus(*conn) == CONNECTION_OK)
 	{
 		/* adjust setting parameters */
-		pgut_command(*conn,
-			"SET search_path = 'pg_catalog', 'public'", 0, NULL);
+		pgut_command(*conn, SESSION_SETTINGS_SQL, 0, NULL);
 
 		/* install required schema if requested */
 		if (ensure_schema(*conn, schema))
@@ -22,14 +22,19 @@
 ///#define USE_DAEMON				/* become daemon? */
 
 #define DB_MAX_RETRY		10		/* max retry count for database operations */
+#define PIPELINE_WINDOW		1000	/* max number of queries in flight in a pipeline */
 #define LOGTIME_LEN			40		/* buffer size for timestamp */
 #define LOGCODE_LEN			6		/* buffer size for sqlcode */
 #define SECS_PER_DAY		86400	/* seconds per day */
 
+/* settings of the sessions of the agent, applied by do_connect() */
+#define SESSION_SETTINGS_SQL \
+	"SET search_path = 'pg_catalog', 'public'; SET DateStyle = 'ISO'"
+
 #define STATSINFO_CONTROL_FILE		"pg_statsinfo.control"
-#define STATSINFO_CONTROL_VERSION	170000
+#define STATSINFO_CONTROL_VERSION	170500
 
-#define STATSREPO_SCHEMA_VERSION	170000
+#define STATSREPO_SCHEMA_VERSION	172200
 
 /* number of columns of csvlog */
 #define CSV_COLS			26
@@ -67,7 +72,8 @@ typedef enum WriterQueueType
 	QUEUE_AUTOVACUUM,
 	QUEUE_MAINTENANCE,
 	QUEUE_LOGSTORE,
-	QUEUE_HWINFO
+	QUEUE_HWINFO,
+	QUEUE_INSTANCE_TS
 } WriterQueueType;
 
 /*
@@ -99,11 +105,33 @@ extern pid_t		sil_pid;
 extern char		   *data_directory;
 extern char		   *excluded_dbnames;
 extern char		   *excluded_schemas;
+extern char		   *partition_rollup;
 extern char		   *stat_statements_max;
+extern bool			stat_statements_delta;
+extern char		   *stat_statements_top;
 extern char		   *stat_statements_exclude_users;
+extern char		   *buffercache_max;
+extern char		   *walinspect_max_size;
+extern int			copy_chunk_size;
+extern bool			snapshot_streaming;
+extern int			snapshot_chunk_rows;
+extern bool			snapshot_skip_idle;
+extern int			snapshot_budget;
 extern int			sampling_interval;
 extern int			wait_sampling_interval;
 extern int			snapshot_interval;
+extern int			snapshot_parallelism;
+extern int			connection_pool_size;
+extern int			connection_pool_idle_timeout;
+extern int			snapshot_jitter;
+extern int			repository_write_slots;
+extern int			mini_snapshot_interval;
+extern int			escalation_interval;
+extern int			escalation_duration;
+extern int			escalation_waiting_sessions;
+extern int			escalation_replication_lag;
+extern int			escalation_cpu_usage;
+extern bool			escalation_on_alert;
 extern int		    enable_maintenance;
 extern time_t		maintenance_time;
 extern int			repository_keepday;
@@ -188,6 +216,7 @@ extern volatile time_t	collector_reload_time;
 extern volatile char   *snapshot_requested;
 extern volatile char   *maintenance_requested;
 extern volatile char   *postmaster_start_time;
+extern volatile time_t	last_alert_time;
 
 /* collector_wait_sampling.c */
 extern pthread_mutex_t	reset_lock;
@@ -266,12 +295,19 @@ typedef struct tim {
 extern void collector_init(void);
 extern void *collector_main(void *arg);
 extern PGconn *collector_connect(const char *db);
+extern PGconn *collector_connect_db(PGconn **conn, const char *db);
+extern PGconn *collector_pool_get(const char *db);
+extern void collector_pool_release(PGconn *conn);
+extern void collector_pool_expire(time_t now);
+extern void collector_pool_counters(int64 *hits, int64 *misses,
+									int64 *reconnects);
 /* collector_wait_sampling.c */
 extern void collector_wait_sampling_init(void);
 extern void *collector_wait_sampling_main(void *arg);
 extern PGconn *collector_wait_sampling_connect(const char *db);
 /* snapshot.c */
-extern QueueItem *get_snapshot(char *comment);
+extern QueueItem *get_snapshot(char *comment, const char *escalation);
+extern QueueItem *get_instance_ts(void);
 extern void readopt_from_file(FILE *fp);
 extern void readopt_from_db(PGresult *res);
 
@@ -318,11 +354,26 @@ extern bool is_autovacuum_cancel_request(int elevel, const char *message);
 extern bool parse_autovacuum_cancel(const Log *log);
 extern bool parse_autovacuum_cancel_request(const Log *log);
 
+/* copy_binary.c */
+typedef enum CopyBinaryResult
+{
+	COPY_BINARY_OK,
+	COPY_BINARY_FAILED,
+	COPY_BINARY_UNSUPPORTED		/* use the text format instead */
+} CopyBinaryResult;
+
+extern CopyBinaryResult copy_binary(PGconn *conn, const char *sql,
+				PGresult *src, const char *snapid, const char *dbid,
+				const char *snap_date, int part_key_position);
+extern void copy_binary_reset(void);
+
 /* writer.c */
+extern volatile int64	writer_instid;
 extern void writer_init(void);
 extern void *writer_main(void *arg);
 extern void writer_send(QueueItem *item);
 extern bool writer_has_queue(WriterQueueType type);
+extern bool writer_put(PGconn *conn, const char *sql, int nParams, const char **params);
 /* maintenance.c */
 extern void maintenance_snapshot(time_t repository_keepday);
 extern void maintenance_repolog(time_t repolog_keepday);
@@ -53,6 +53,12 @@ CREATE TABLE statsrepo.snapshot
 	exec_time				interval,
 	snapshot_increase_size	bigint,
 	xid_current				xid8,
+	skipped					text,
+	escalation				text,
+	pool_hits				bigint,
+	pool_misses				bigint,
+	pool_reconnects			bigint,
+	wal_unavailable			boolean,
 	PRIMARY KEY (snapid),
 	FOREIGN KEY (instid) REFERENCES statsrepo.instance (instid) ON DELETE CASCADE
 );
@@ -97,6 +103,8 @@ CREATE TABLE statsrepo.database
 	deadlocks			bigint,
 	blk_read_time		double precision,
 	blk_write_time		double precision,
+	carried				bigint,
+	streamed			timestamptz,
 	PRIMARY KEY (snapid, dbid),
 	FOREIGN KEY (snapid) REFERENCES statsrepo.snapshot (snapid) ON DELETE CASCADE
 );
@@ -153,8 +161,7 @@ CREATE TABLE statsrepo.table
 	last_autoanalyze	timestamptz,
 	PRIMARY KEY (snapid, dbid, tbl),
 	FOREIGN KEY (snapid) REFERENCES statsrepo.snapshot (snapid) ON DELETE CASCADE,
-	FOREIGN KEY (snapid, dbid) REFERENCES statsrepo.database (snapid, dbid),
-	FOREIGN KEY (snapid, dbid, nsp) REFERENCES statsrepo.schema (snapid, dbid, nsp)
+	FOREIGN KEY (snapid, dbid) REFERENCES statsrepo.database (snapid, dbid)
 );
 
 CREATE TABLE statsrepo.index
@@ -207,6 +214,7 @@ CREATE TABLE statsrepo.column
 	FOREIGN KEY (snapid) REFERENCES statsrepo.snapshot (snapid) ON DELETE CASCADE,
 	FOREIGN KEY (snapid, dbid) REFERENCES statsrepo.database (snapid, dbid)
 );
+CREATE INDEX statsrepo_column_idx ON statsrepo.column(dbid, tbl, snapid);
 
 CREATE TABLE statsrepo.activity
 (
@@ -232,6 +240,25 @@ CREATE TABLE statsrepo.xact
 	FOREIGN KEY (snapid) REFERENCES statsrepo.snapshot (snapid) ON DELETE CASCADE
 );
 
+CREATE TABLE statsrepo.backend_memory
+(
+	snapid			bigint,
+	pid				integer,
+	backend_start	timestamptz,
+	backend_type	text,
+	dbid			oid,
+	userid			oid,
+	queryid			bigint,
+	rss				bigint,
+	anon			bigint,
+	swap			bigint,
+	peak_time		timestamptz,
+	contexts_logged	boolean,
+	query			text,
+	PRIMARY KEY (snapid, pid, backend_start),
+	FOREIGN KEY (snapid) REFERENCES statsrepo.snapshot (snapid) ON DELETE CASCADE
+);
+
 CREATE TABLE statsrepo.setting
 (
 	snapid			bigint,
@@ -269,7 +296,7 @@ CREATE TABLE statsrepo.statement
 	dbid				oid,
 	userid				oid,
 	queryid				bigint,
-	query				text,
+	query_hash			bigint,
 	plans				bigint,
 	total_plan_time		double precision,
 	calls				bigint,
@@ -291,10 +318,22 @@ CREATE TABLE statsrepo.statement
 	local_blk_write_time	double precision,
 	temp_blk_read_time	double precision,
 	temp_blk_write_time	double precision,
+	toplevel			boolean,
 	FOREIGN KEY (snapid) REFERENCES statsrepo.snapshot (snapid) ON DELETE CASCADE,
 	FOREIGN KEY (snapid, dbid) REFERENCES statsrepo.database (snapid, dbid)
 );
 CREATE INDEX statsrepo_statement_idx ON statsrepo.statement(snapid, dbid);
+CREATE INDEX statsrepo_statement_queryid_idx ON statsrepo.statement(queryid, dbid, userid, snapid);
+
+CREATE TABLE statsrepo.query_text
+(
+	dbid				oid,
+	userid				oid,
+	queryid				bigint,
+	hash				bigint,
+	query				text,
+	PRIMARY KEY (queryid, dbid, userid, hash)
+);
 
 CREATE TABLE statsrepo.plan
 (
@@ -303,7 +342,7 @@ CREATE TABLE statsrepo.plan
 	userid					oid,
 	queryid					bigint,
 	planid					bigint,
-	plan					text,
+	plan_hash				bigint,
 	calls					bigint,
 	total_time				double precision,
 	rows					bigint,
@@ -330,6 +369,14 @@ CREATE TABLE statsrepo.plan
 );
 CREATE INDEX statsrepo_plan_idx ON statsrepo.plan(snapid, dbid);
 
+CREATE TABLE statsrepo.plan_text
+(
+	planid					bigint,
+	hash					bigint,
+	plan					text,
+	PRIMARY KEY (planid, hash)
+);
+
 CREATE TABLE statsrepo.function
 (
 	snapid			bigint,
@@ -338,13 +385,39 @@ CREATE TABLE statsrepo.function
 	nsp				oid,
 	funcname		name,
 	argtypes		text,
+	FOREIGN KEY (snapid) REFERENCES statsrepo.snapshot (snapid) ON DELETE CASCADE,
+	FOREIGN KEY (snapid, dbid) REFERENCES statsrepo.database (snapid, dbid)
+);
+CREATE INDEX statsrepo_function_idx ON statsrepo.function(snapid, dbid);
+
+-- counters of the functions, written in every snapshot while the
+-- definitions in statsrepo.function are written only when changed
+CREATE TABLE statsrepo.stat_function
+(
+	snapid			bigint,
+	dbid			oid,
+	funcid			oid,
 	calls			bigint,
 	total_time		double precision,
 	self_time		double precision,
 	FOREIGN KEY (snapid) REFERENCES statsrepo.snapshot (snapid) ON DELETE CASCADE,
 	FOREIGN KEY (snapid, dbid) REFERENCES statsrepo.database (snapid, dbid)
 );
-CREATE INDEX statsrepo_function_idx ON statsrepo.function(snapid, dbid);
+CREATE INDEX statsrepo_stat_function_idx ON statsrepo.stat_function(snapid, dbid);
+
+-- setting, role, schema, inherits and function are written only when they
+-- change, and each version is in effect from first_snapid to last_snapid.
+CREATE TABLE statsrepo.version
+(
+	instid			bigint,
+	dbid			oid,			-- 0 for setting and role
+	kind			name,			-- name of the table
+	first_snapid	bigint,			-- snapid of the rows
+	last_snapid		bigint,
+	PRIMARY KEY (first_snapid, dbid, kind),
+	FOREIGN KEY (first_snapid) REFERENCES statsrepo.snapshot (snapid) ON DELETE CASCADE
+);
+CREATE INDEX statsrepo_version_idx ON statsrepo.version(instid, dbid, kind, first_snapid);
 
 CREATE TABLE statsrepo.autovacuum
 (
@@ -452,6 +525,26 @@ CREATE TABLE statsrepo.checkpoint
 );
 CREATE INDEX statsrepo_checkpoint_idx ON statsrepo.checkpoint(instid, start);
 
+CREATE TABLE statsrepo.progress
+(
+	snapid			bigint,
+	pid				integer,
+	command			text,
+	dbid			oid,
+	relid			oid,
+	start			timestamptz,
+	finish			timestamptz,
+	phase_no		integer,
+	phase			text,
+	phase_start		timestamptz,
+	phase_end		timestamptz,
+	blocks_total	bigint,
+	blocks_start	bigint,
+	blocks_end		bigint,
+	FOREIGN KEY (snapid) REFERENCES statsrepo.snapshot (snapid) ON DELETE CASCADE
+);
+CREATE INDEX statsrepo_progress_idx ON statsrepo.progress(snapid);
+
 CREATE TABLE statsrepo.cpu
 (
 	snapid				bigint,
@@ -556,6 +649,8 @@ CREATE TABLE statsrepo.lock
 	duration			interval,
 	blockee_query		text,
 	blocker_query		text,
+	waitstart			timestamptz,
+	samples				integer,
 	FOREIGN KEY (snapid) REFERENCES statsrepo.snapshot (snapid) ON DELETE CASCADE
 );
 
@@ -568,6 +663,28 @@ CREATE TABLE statsrepo.bgwriter
 	FOREIGN KEY (snapid) REFERENCES statsrepo.snapshot (snapid) ON DELETE CASCADE
 );
 
+CREATE TABLE statsrepo.buffercache
+(
+	snapid					bigint,
+	dbid					oid,
+	tbs						oid,
+	relfilenode				oid,
+	forknumber				smallint,
+	nspname					name,
+	relname					name,
+	buffers					bigint,
+	dirty					bigint,
+	pinned					bigint,
+	usagecount_0			bigint,
+	usagecount_1			bigint,
+	usagecount_2			bigint,
+	usagecount_3			bigint,
+	usagecount_4			bigint,
+	usagecount_5			bigint,
+	FOREIGN KEY (snapid) REFERENCES statsrepo.snapshot (snapid) ON DELETE CASCADE
+);
+CREATE INDEX statsrepo_buffercache_idx ON statsrepo.buffercache(snapid);
+
 CREATE TABLE statsrepo.replication
 (
 	snapid				bigint,
@@ -613,6 +730,37 @@ CREATE TABLE statsrepo.replication_slots
 	FOREIGN KEY (snapid) REFERENCES statsrepo.snapshot (snapid) ON DELETE CASCADE
 );
 
+CREATE TABLE statsrepo.replication_lag
+(
+	snapid				bigint,
+	procpid				integer,
+	application_name	text,
+	samples				integer,
+	write_lag_min		interval,
+	write_lag_max		interval,
+	write_lag_p99		interval,
+	flush_lag_min		interval,
+	flush_lag_max		interval,
+	flush_lag_p99		interval,
+	replay_lag_min		interval,
+	replay_lag_max		interval,
+	replay_lag_p99		interval,
+	FOREIGN KEY (snapid) REFERENCES statsrepo.snapshot (snapid) ON DELETE CASCADE
+);
+CREATE INDEX statsrepo_replication_lag_idx ON statsrepo.replication_lag(snapid);
+
+CREATE TABLE statsrepo.replication_slot_retention
+(
+	snapid					bigint,
+	slot_name				name,
+	samples					integer,
+	retained_min			bigint,
+	retained_max			bigint,
+	retained_p99			bigint,
+	FOREIGN KEY (snapid) REFERENCES statsrepo.snapshot (snapid) ON DELETE CASCADE
+);
+CREATE INDEX statsrepo_replication_slot_retention_idx ON statsrepo.replication_slot_retention(snapid);
+
 CREATE TABLE statsrepo.stat_replication_slots
 (
 	snapid					bigint,
@@ -732,6 +880,21 @@ CREATE TABLE statsrepo.xlog
 	FOREIGN KEY (snapid) REFERENCES statsrepo.snapshot (snapid) ON DELETE CASCADE
 );
 
+CREATE TABLE statsrepo.wal_composition
+(
+	snapid				bigint,
+	start_lsn			pg_lsn,
+	end_lsn				pg_lsn,
+	resource_manager	text,
+	record_type			text,
+	count				bigint,
+	record_size			bigint,
+	fpi_size			bigint,
+	combined_size		bigint,
+	FOREIGN KEY (snapid) REFERENCES statsrepo.snapshot (snapid) ON DELETE CASCADE
+);
+CREATE INDEX statsrepo_wal_composition_idx ON statsrepo.wal_composition(snapid);
+
 CREATE TABLE statsrepo.alert_message
 (
 	snapid		bigint,
@@ -784,6 +947,31 @@ CREATE TABLE statsrepo.log
 	FOREIGN KEY (instid) REFERENCES statsrepo.instance (instid) ON DELETE CASCADE
 );
 
+CREATE TABLE statsrepo.instance_ts
+(
+	instid				bigint,
+	timestamp			timestamptz,
+	xact_commit			bigint,
+	xact_rollback		bigint,
+	blks_read			bigint,
+	blks_hit			bigint,
+	wal_bytes			numeric,
+	io_reads			bigint,
+	io_writes			bigint,
+	io_extends			bigint,
+	io_fsyncs			bigint,
+	buffers_clean		bigint,
+	buffers_alloc		bigint,
+	checkpoints_timed	bigint,
+	checkpoints_req		bigint,
+	buffers_checkpoint	bigint,
+	active				integer,
+	idle_in_xact		integer,
+	waiting				integer,
+	FOREIGN KEY (instid) REFERENCES statsrepo.instance (instid) ON DELETE CASCADE
+);
+CREATE INDEX statsrepo_instance_ts_idx ON statsrepo.instance_ts(instid, timestamp);
+
 CREATE TABLE statsrepo.rusage
 (
     snapid           bigint,
@@ -849,9 +1037,141 @@ CREATE TABLE statsrepo.ht_info
 );
 
 
+-- version_snapid(snapid, dbid, kind) - snapid of the version of the table
+-- which is in effect in the specified snapshot.
+CREATE FUNCTION statsrepo.version_snapid(bigint, oid, name) RETURNS bigint AS
+$$
+	SELECT COALESCE(
+		(SELECT v.first_snapid
+		   FROM statsrepo.version v, statsrepo.snapshot s
+		  WHERE s.snapid = $1
+		    AND v.instid = s.instid
+		    AND v.dbid = $2
+		    AND v.kind = $3
+		    AND $1 BETWEEN v.first_snapid AND v.last_snapid), $1);
+$$
+LANGUAGE sql STABLE;
+
+-- column_snapids(snapid) - snapid of the latest column statistics of each
+-- table collected by the specified snapshot, which may be an earlier one when
+-- pg_statsinfo.collect_column_rotation is more than 1.
+CREATE FUNCTION statsrepo.column_snapids(
+	IN snapid_end	bigint,
+	OUT dbid	oid,
+	OUT tbl		oid,
+	OUT snapid	bigint
+) RETURNS SETOF record AS
+$$
+DECLARE
+	val_rotation	integer;
+	val_instid		bigint;
+	val_base		bigint;
+	val_lower		bigint;
+BEGIN
+	SELECT t.setting::integer INTO val_rotation
+	  FROM statsrepo.setting t
+	 WHERE t.snapid = statsrepo.version_snapid($1, 0, 'setting')
+	   AND t.name = 'pg_statsinfo.collect_column_rotation';
+
+	IF COALESCE(val_rotation, 1) <= 1 THEN
+		RETURN QUERY
+			SELECT DISTINCT c.dbid, c.tbl, c.snapid
+			  FROM statsrepo.database d, statsrepo.column c
+			 WHERE d.snapid = $1
+			   AND c.snapid = COALESCE(d.carried, d.snapid)
+			   AND c.dbid = d.dbid;
+		RETURN;
+	END IF;
+
+	/*
+	 * Every table is collected once in val_rotation snapshots with columns,
+	 * so search only back to the val_rotation-th of them before the oldest
+	 * statistics of the databases.
+	 */
+	SELECT s.instid INTO val_instid FROM statsrepo.snapshot s WHERE s.snapid = $1;
+	SELECT pg_catalog.min(COALESCE(d.carried, d.snapid)) INTO val_base
+	  FROM statsrepo.database d
+	 WHERE d.snapid = $1;
+	SELECT s.snapid INTO val_lower
+	  FROM statsrepo.snapshot s
+	 WHERE s.instid = val_instid
+	   AND s.snapid <= COALESCE(val_base, $1)
+	   AND EXISTS (SELECT 1 FROM statsrepo.column c WHERE c.snapid = s.snapid)
+	 ORDER BY s.snapid DESC
+	OFFSET val_rotation - 1 LIMIT 1;
+
+	RETURN QUERY
+		SELECT DISTINCT ON (c.dbid, c.tbl) c.dbid, c.tbl, c.snapid
+		  FROM statsrepo.column c, statsrepo.snapshot s
+		 WHERE s.snapid = c.snapid
+		   AND s.instid = val_instid
+		   AND c.snapid BETWEEN COALESCE(val_lower, 0) AND $1
+		 ORDER BY c.dbid, c.tbl, c.snapid DESC;
+END;
+$$
+LANGUAGE plpgsql STABLE;
+
+-- rebase_versions(snapids) - move the versions written in the snapshots
+-- to be deleted to the next snapshot in which they are in effect.
+CREATE FUNCTION statsrepo.rebase_versions(bigint[]) RETURNS void AS
+$$
+DECLARE
+	v		record;
+	base	bigint;
+BEGIN
+	FOR v IN SELECT * FROM statsrepo.version WHERE first_snapid = ANY ($1) LOOP
+		SELECT pg_catalog.min(s.snapid) INTO base
+		  FROM statsrepo.snapshot s
+		 WHERE s.instid = v.instid
+		   AND s.snapid > v.first_snapid
+		   AND s.snapid <= v.last_snapid
+		   AND s.snapid <> ALL ($1)
+		   AND (v.dbid = 0 OR EXISTS
+				(SELECT 1 FROM statsrepo.database d
+				  WHERE d.snapid = s.snapid AND d.dbid = v.dbid));
+		CONTINUE WHEN base IS NULL;
+
+		IF v.dbid = 0 THEN
+			EXECUTE pg_catalog.format(
+				'UPDATE statsrepo.%I SET snapid = $1 WHERE snapid = $2', v.kind)
+				USING base, v.first_snapid;
+		ELSE
+			EXECUTE pg_catalog.format(
+				'UPDATE statsrepo.%I SET snapid = $1 WHERE snapid = $2 AND dbid = $3', v.kind)
+				USING base, v.first_snapid, v.dbid;
+		END IF;
+
+		UPDATE statsrepo.version SET first_snapid = base
+		 WHERE first_snapid = v.first_snapid AND dbid = v.dbid AND kind = v.kind;
+	END LOOP;
+END;
+$$
+LANGUAGE plpgsql;
+
+-- try_write_slot(slots, instid) - take the first free one of the write slot
+-- advisory locks, starting at the slot of the instance. Returns the slot, or
+-- NULL if all of them are taken.
+CREATE FUNCTION statsrepo.try_write_slot(integer, bigint) RETURNS integer AS
+$$
+DECLARE
+	slot	integer;
+BEGIN
+	FOR i IN 0 .. $1 - 1 LOOP
+		slot := (($2 + i) % $1)::integer;
+		IF pg_catalog.pg_try_advisory_xact_lock(
+				pg_catalog.hashtext('statsrepo.write_slot'), slot) THEN
+			RETURN slot;
+		END IF;
+	END LOOP;
+	RETURN NULL;
+END;
+$$
+LANGUAGE plpgsql VOLATILE STRICT;
+
 -- del_snapshot(snapid) - delete the specified snapshot.
 CREATE FUNCTION statsrepo.del_snapshot(bigint) RETURNS void AS
 $$
+	SELECT statsrepo.rebase_versions(ARRAY[$1]);
 	DELETE FROM statsrepo.snapshot WHERE snapid = $1;
 $$
 LANGUAGE sql;
@@ -859,12 +1179,21 @@ LANGUAGE sql;
 -- del_snapshot(time) - delete snapshots older than the specified timestamp.
 CREATE FUNCTION statsrepo.del_snapshot(timestamptz) RETURNS void AS
 $$
+	SELECT statsrepo.rebase_versions(
+		ARRAY(SELECT snapid FROM statsrepo.snapshot WHERE time < $1));
 	DELETE FROM statsrepo.snapshot WHERE time < $1;
 	DELETE FROM statsrepo.autovacuum WHERE start < (SELECT pg_catalog.min(time) FROM statsrepo.snapshot);
 	DELETE FROM statsrepo.autoanalyze WHERE start < (SELECT pg_catalog.min(time) FROM statsrepo.snapshot);
 	DELETE FROM statsrepo.checkpoint WHERE start < (SELECT pg_catalog.min(time) FROM statsrepo.snapshot);
 	DELETE FROM statsrepo.autovacuum_cancel WHERE timestamp < (SELECT pg_catalog.min(time) FROM statsrepo.snapshot);
 	DELETE FROM statsrepo.autoanalyze_cancel WHERE timestamp < (SELECT pg_catalog.min(time) FROM statsrepo.snapshot);
+	DELETE FROM statsrepo.query_text q WHERE NOT EXISTS
+		(SELECT 1 FROM statsrepo.statement s
+		  WHERE s.queryid = q.queryid AND s.dbid = q.dbid
+			AND s.userid = q.userid AND s.query_hash = q.hash);
+	DELETE FROM statsrepo.plan_text t WHERE NOT EXISTS
+		(SELECT 1 FROM statsrepo.plan p
+		  WHERE p.planid = t.planid AND p.plan_hash = t.hash);
 $$
 LANGUAGE sql;
 
@@ -881,7 +1210,7 @@ LANGUAGE sql;
 
 -- get_version() - version of statsrepo schema
 CREATE FUNCTION statsrepo.get_version() RETURNS text AS
-'SELECT CAST(''170000'' AS TEXT)'
+'SELECT CAST(''172200'' AS TEXT)'
 LANGUAGE sql IMMUTABLE;
 
 -- tps() - transaction per seconds
@@ -992,7 +1321,7 @@ CREATE AGGREGATE statsrepo.array_accum(anycompatiblearray)
 
 -- tables - pre-JOINed tables
 CREATE VIEW statsrepo.tables AS
-  SELECT t.snapid,
+  SELECT d.snapid,
          d.name AS database,
          s.name AS schema,
          t.name AS table,
@@ -1029,19 +1358,20 @@ CREATE VIEW statsrepo.tables AS
          t.last_autovacuum,
          t.last_analyze,
          t.last_autoanalyze,
-         t.relpages
+         t.relpages,
+         t.snapid AS base_snapid
   FROM statsrepo.database d,
        statsrepo.schema s,
        statsrepo.table t
- WHERE d.snapid = t.snapid
-   AND s.snapid = t.snapid
+ WHERE t.snapid = COALESCE(d.carried, d.snapid)
+   AND s.snapid = statsrepo.version_snapid(t.snapid, t.dbid, 'schema')
    AND s.nsp = t.nsp
    AND d.dbid = t.dbid
    AND s.dbid = t.dbid;
 
 -- indexes - pre-JOINed indexes
 CREATE VIEW statsrepo.indexes AS
-  SELECT i.snapid,
+  SELECT d.snapid,
          d.name AS database,
          s.name AS schema,
          t.name AS table,
@@ -1064,13 +1394,14 @@ CREATE VIEW statsrepo.indexes AS
          i.idx_tup_read,
          i.idx_tup_fetch,
          i.idx_blks_read,
-         i.idx_blks_hit
+         i.idx_blks_hit,
+         i.snapid AS base_snapid
     FROM statsrepo.database d,
          statsrepo.schema s,
          statsrepo.table t,
          statsrepo.index i
-   WHERE d.snapid = i.snapid
-     AND s.snapid = i.snapid
+   WHERE i.snapid = COALESCE(d.carried, d.snapid)
+     AND s.snapid = statsrepo.version_snapid(i.snapid, i.dbid, 'schema')
      AND t.snapid = i.snapid
      AND i.tbl = t.tbl
      AND t.nsp = s.nsp
@@ -1601,7 +1932,7 @@ FROM
 		(SELECT snapid, setting 
 			FROM statsrepo.setting WHERE name = 'pg_statsinfo.sampling_interval'
 		) set
-		ON a.snapid = set.snapid
+		ON statsrepo.version_snapid(a.snapid, 0, 'setting') = set.snapid
 	WHERE
 	a.snapid BETWEEN $1 AND $2
 	AND s.instid = (SELECT instid FROM statsrepo.snapshot WHERE snapid = $2)
@@ -1746,6 +2077,43 @@ $$
 $$
 LANGUAGE sql;
 
+-- generate information that corresponds to 'WAL Composition'
+CREATE FUNCTION statsrepo.get_wal_composition(
+	IN snapid_begin			bigint,
+	IN snapid_end			bigint,
+	OUT resource_manager	text,
+	OUT record_type			text,
+	OUT count				numeric,
+	OUT record_size			numeric,
+	OUT fpi_size			numeric,
+	OUT combined_size		numeric,
+	OUT combined_ratio		numeric
+) RETURNS SETOF record AS
+$$
+	SELECT
+		w.resource_manager,
+		w.record_type,
+		pg_catalog.sum(w.count),
+		pg_catalog.round(pg_catalog.sum(w.record_size) / 1024 / 1024, 3),
+		pg_catalog.round(pg_catalog.sum(w.fpi_size) / 1024 / 1024, 3),
+		pg_catalog.round(pg_catalog.sum(w.combined_size) / 1024 / 1024, 3),
+		pg_catalog.round(100 * statsrepo.div(pg_catalog.sum(w.combined_size),
+			pg_catalog.sum(pg_catalog.sum(w.combined_size)) OVER ()), 1)
+	FROM
+		statsrepo.wal_composition w,
+		statsrepo.snapshot s
+	WHERE
+		w.snapid > $1 AND w.snapid <= $2
+		AND w.snapid = s.snapid
+		AND s.instid = (SELECT instid FROM statsrepo.snapshot WHERE snapid = $2)
+	GROUP BY
+		w.resource_manager,
+		w.record_type
+	ORDER BY
+		pg_catalog.sum(w.combined_size) DESC;
+$$
+LANGUAGE sql;
+
 -- generate information that corresponds to 'I/O Statistics' for pg_stats_reporter
 CREATE FUNCTION statsrepo.get_stat_io(
 	IN snapid_begin			bigint,
@@ -1869,6 +2237,77 @@ $$
 $$
 LANGUAGE sql;
 
+-- generate information that corresponds to 'Instance Activity Tendency'
+CREATE FUNCTION statsrepo.get_instance_ts_tendency(
+	IN snapid_begin			bigint,
+	IN snapid_end			bigint,
+	OUT "timestamp"			text,
+	OUT xact_commit			numeric,
+	OUT xact_rollback		numeric,
+	OUT blks_read			numeric,
+	OUT blks_hit_ratio		numeric,
+	OUT wal_bytes			numeric,
+	OUT io_reads			numeric,
+	OUT io_writes			numeric,
+	OUT buffers_clean		numeric,
+	OUT buffers_alloc		numeric,
+	OUT checkpoints			bigint,
+	OUT buffers_checkpoint	numeric,
+	OUT active				integer,
+	OUT idle_in_xact		integer,
+	OUT waiting				integer
+) RETURNS SETOF record AS
+$$
+	SELECT
+		pg_catalog.to_char(t.timestamp, 'YYYY-MM-DD HH24:MI:SS'),
+		statsrepo.tps(GREATEST(t.xact_commit - t.prev_xact_commit, 0), t.duration),
+		statsrepo.tps(GREATEST(t.xact_rollback - t.prev_xact_rollback, 0), t.duration),
+		statsrepo.tps(GREATEST(t.blks_read - t.prev_blks_read, 0), t.duration),
+		(100 * statsrepo.div(GREATEST(t.blks_hit - t.prev_blks_hit, 0),
+			GREATEST(t.blks_hit - t.prev_blks_hit, 0) +
+			GREATEST(t.blks_read - t.prev_blks_read, 0)))::numeric(5,1),
+		(statsrepo.tps(GREATEST(t.wal_bytes - t.prev_wal_bytes, 0), t.duration) / 1024 / 1024)::numeric(30, 3),
+		statsrepo.tps(GREATEST(t.io_reads - t.prev_io_reads, 0), t.duration),
+		statsrepo.tps(GREATEST(t.io_writes - t.prev_io_writes, 0), t.duration),
+		statsrepo.tps(GREATEST(t.buffers_clean - t.prev_buffers_clean, 0), t.duration),
+		statsrepo.tps(GREATEST(t.buffers_alloc - t.prev_buffers_alloc, 0), t.duration),
+		GREATEST(t.checkpoints - t.prev_checkpoints, 0),
+		statsrepo.tps(GREATEST(t.buffers_checkpoint - t.prev_buffers_checkpoint, 0), t.duration),
+		t.active,
+		t.idle_in_xact,
+		t.waiting
+	FROM
+	(
+		SELECT
+			ts.*,
+			ts.checkpoints_timed + ts.checkpoints_req AS checkpoints,
+			ts.timestamp - pg_catalog.lag(ts.timestamp) OVER w AS duration,
+			pg_catalog.lag(ts.xact_commit) OVER w AS prev_xact_commit,
+			pg_catalog.lag(ts.xact_rollback) OVER w AS prev_xact_rollback,
+			pg_catalog.lag(ts.blks_read) OVER w AS prev_blks_read,
+			pg_catalog.lag(ts.blks_hit) OVER w AS prev_blks_hit,
+			pg_catalog.lag(ts.wal_bytes) OVER w AS prev_wal_bytes,
+			pg_catalog.lag(ts.io_reads) OVER w AS prev_io_reads,
+			pg_catalog.lag(ts.io_writes) OVER w AS prev_io_writes,
+			pg_catalog.lag(ts.buffers_clean) OVER w AS prev_buffers_clean,
+			pg_catalog.lag(ts.buffers_alloc) OVER w AS prev_buffers_alloc,
+			pg_catalog.lag(ts.checkpoints_timed + ts.checkpoints_req) OVER w AS prev_checkpoints,
+			pg_catalog.lag(ts.buffers_checkpoint) OVER w AS prev_buffers_checkpoint
+		 FROM
+			statsrepo.instance_ts ts
+		 WHERE
+			ts.instid = (SELECT instid FROM statsrepo.snapshot WHERE snapid = $2)
+			AND ts.timestamp BETWEEN (SELECT time FROM statsrepo.snapshot WHERE snapid = $1)
+								 AND (SELECT time FROM statsrepo.snapshot WHERE snapid = $2)
+		 WINDOW w AS (ORDER BY ts.timestamp)
+	) t
+	WHERE
+		t.duration IS NOT NULL
+	ORDER BY
+		t.timestamp;
+$$
+LANGUAGE sql;
+
 -- generate information that corresponds to 'CPU Usage'
 CREATE FUNCTION statsrepo.get_cpu_usage_tendency(
 	IN snapid_begin	bigint,
@@ -2187,6 +2626,53 @@ $$
 $$
 LANGUAGE sql;
 
+-- generate information that corresponds to 'Backend Memory Peaks'
+CREATE FUNCTION statsrepo.get_backend_memory(
+	IN snapid_begin		bigint,
+	IN snapid_end		bigint,
+	OUT pid				integer,
+	OUT backend_type	text,
+	OUT datname			name,
+	OUT peak_time		timestamp,
+	OUT rss				numeric,
+	OUT anon			numeric,
+	OUT swap			numeric,
+	OUT queryid			bigint,
+	OUT contexts_logged	boolean,
+	OUT query			text
+) RETURNS SETOF record AS
+$$
+	SELECT
+		m.pid,
+		m.backend_type,
+		d.name,
+		m.peak_time::timestamp(0),
+		(m.rss::float / 1024 / 1024)::numeric(30, 2),
+		(m.anon::float / 1024 / 1024)::numeric(30, 2),
+		(m.swap::float / 1024 / 1024)::numeric(30, 2),
+		m.queryid,
+		m.contexts_logged,
+		m.query
+	FROM
+		(SELECT DISTINCT ON (b.pid, b.backend_start)
+			b.*
+		 FROM
+			statsrepo.backend_memory b,
+			statsrepo.snapshot s
+		 WHERE
+			b.snapid BETWEEN $1 AND $2
+			AND b.snapid = s.snapid
+			AND s.instid = (SELECT instid FROM statsrepo.snapshot WHERE snapid = $2)
+		 ORDER BY
+			b.pid,
+			b.backend_start,
+			b.anon DESC) m
+		LEFT JOIN statsrepo.database d ON d.snapid = m.snapid AND d.dbid = m.dbid
+	ORDER BY
+		m.anon DESC;
+$$
+LANGUAGE sql;
+
 -- generate information that corresponds to 'Disk Usage per Tablespace'
 CREATE FUNCTION statsrepo.get_disk_usage_tablespace(
 	IN snapid_begin		bigint,
@@ -2237,7 +2723,7 @@ $$
 		statsrepo.sub(e.toast_blks_read, b.toast_blks_read) +
 			statsrepo.sub(e.tidx_blks_read, b.tidx_blks_read)
 	FROM
-		statsrepo.tables e LEFT JOIN statsrepo.table b
+		statsrepo.tables e LEFT JOIN statsrepo.tables b
 			ON e.tbl = b.tbl AND e.nsp = b.nsp AND e.dbid = b.dbid AND b.snapid = $1
 	WHERE
 		e.snapid = $2
@@ -2312,7 +2798,7 @@ $$
 			statsrepo.sub(e.n_tup_hot_upd, b.n_tup_hot_upd),
 			statsrepo.sub(e.n_tup_upd, b.n_tup_upd)) * 100)::numeric(30,1)
 	FROM
-		statsrepo.tables e LEFT JOIN statsrepo.table b
+		statsrepo.tables e LEFT JOIN statsrepo.tables b
 			ON e.tbl = b.tbl AND e.nsp = b.nsp AND e.dbid = b.dbid AND b.snapid = $1
 	WHERE
 		e.snapid = $2
@@ -2360,7 +2846,7 @@ $$
 			statsrepo.sub(e.toast_blks_read, b.toast_blks_read) +
 			statsrepo.sub(e.tidx_blks_read, b.tidx_blks_read)) * 100)::numeric(30,1)
 	FROM
-		statsrepo.tables e LEFT JOIN statsrepo.table b
+		statsrepo.tables e LEFT JOIN statsrepo.tables b
 			ON e.tbl = b.tbl AND e.nsp = b.nsp AND e.dbid = b.dbid AND b.snapid = $1
 	WHERE
 		e.snapid = $2
@@ -2413,14 +2899,18 @@ $$
 		 	LEFT JOIN statsrepo.instance i ON s.instid = i.instid
 		 	LEFT JOIN
 		 		(SELECT
-		 			snapid, dbid, tbl, (pg_catalog.sum(avg_width)::integer + 7) & ~7 AS width
+		 			c.dbid, c.tbl, (pg_catalog.sum(c.avg_width)::integer + 7) & ~7 AS width
 				 FROM
-				 	statsrepo."column" 
+				 	statsrepo."column" c,
+				 	statsrepo.column_snapids($2) cs
 				 WHERE
-				 	attnum > 0
+				 	c.snapid = cs.snapid
+				 	AND c.dbid = cs.dbid
+				 	AND c.tbl = cs.tbl
+				 	AND c.attnum > 0
 				 GROUP BY
-				 	snapid, dbid, tbl) stat 
-			ON t.snapid=stat.snapid AND t.dbid=stat.dbid AND t.tbl=stat.tbl
+				 	c.dbid, c.tbl) stat 
+			ON t.dbid=stat.dbid AND t.tbl=stat.tbl
 			LEFT JOIN
 				(SELECT
 					snapid, dbid, nsp, tbl, size
@@ -2428,7 +2918,7 @@ $$
 				 	statsrepo.tables ) tt 
 			ON t.snapid=tt.snapid AND t.dbid=tt.dbid AND t.toastrelid=tt.tbl
 		 WHERE
-		 	t.relkind = 'r'
+		 	t.relkind IN ('r', 'p')
 		 	AND t.schema NOT IN ('pg_catalog', 'information_schema', 'statsrepo')
 		 	AND t.snapid = $2
 	) fill
@@ -2458,10 +2948,14 @@ $$
 		c.correlation::numeric(5,3)
 	FROM
 		statsrepo.indexes i,
+		statsrepo.column_snapids($2) cs,
 		statsrepo.column c
 	WHERE
-		c.snapid = $2
-		AND i.snapid = c.snapid
+		i.snapid = $2
+		AND cs.dbid = i.dbid
+		AND cs.tbl = i.tbl
+		AND c.snapid = cs.snapid
+		AND c.dbid = i.dbid
 		AND i.tbl = c.tbl
 		AND c.attnum = ANY (i.indkey)
 		AND i.schema NOT IN ('pg_catalog', 'pg_toast', 'information_schema')
@@ -2966,6 +3460,61 @@ $$
 $$
 LANGUAGE sql;
 
+-- generate information that corresponds to 'Maintenance Progress Phases'
+CREATE FUNCTION statsrepo.get_progress_phases(
+	IN snapid_begin		bigint,
+	IN snapid_end		bigint,
+	OUT command			text,
+	OUT datname			name,
+	OUT nspname			name,
+	OUT relname			name,
+	OUT phase			text,
+	OUT "count"			bigint,
+	OUT total_duration	numeric,
+	OUT max_duration	numeric,
+	OUT blocks_per_sec	numeric
+) RETURNS SETOF record AS
+$$
+	SELECT
+		p.command,
+		t.database,
+		t.schema,
+		CASE WHEN t.table IS NOT NULL THEN t.table ELSE CAST('OID:[' || p.relid || ']' AS name) END,
+		p.phase,
+		pg_catalog.count(*),
+		pg_catalog.round(pg_catalog.sum(p.duration)::numeric, 3),
+		pg_catalog.round(pg_catalog.max(p.duration)::numeric, 3),
+		pg_catalog.round((pg_catalog.sum(p.blocks) / NULLIF(pg_catalog.sum(p.duration), 0))::numeric, 1)
+	FROM
+		(SELECT
+			snapid,
+			command,
+			dbid,
+			relid,
+			phase,
+			-- a phase lasts until the next phase begins
+			extract(epoch FROM COALESCE(
+				pg_catalog.lead(phase_start) OVER w, phase_end) - phase_start) AS duration,
+			pg_catalog.greatest(blocks_end - blocks_start, 0) AS blocks
+		 FROM
+			statsrepo.progress
+		 WHERE
+			snapid > $1 AND snapid <= $2
+		 WINDOW w AS (PARTITION BY snapid, pid, start ORDER BY phase_no)) p
+		JOIN statsrepo.snapshot s ON
+			s.snapid = p.snapid
+			AND s.instid = (SELECT instid FROM statsrepo.snapshot WHERE snapid = $2)
+		LEFT JOIN statsrepo.tables t ON
+			t.snapid = p.snapid
+			AND t.dbid = p.dbid
+			AND t.tbl = p.relid
+	GROUP BY
+		p.command, t.database, t.schema, t.table, p.relid, p.phase
+	ORDER BY
+		pg_catalog.sum(p.duration) DESC;
+$$
+LANGUAGE sql;
+
 -- generate information that corresponds to 'Analyze I/O Summary'  for pg_stats_reporter
 CREATE FUNCTION statsrepo.get_autoanalyze_activity2(
         IN snapid_begin                 bigint,
@@ -3047,7 +3596,7 @@ $$
 				t.nsp,
 				t.tbl
 			FROM
-				statsrepo.table t,
+				statsrepo.tables t,
 				statsrepo.snapshot s
 			WHERE
 				t.snapid = s.snapid
@@ -3090,7 +3639,7 @@ $$
 		fe.funcid,
 		d.name,
 		s.name,
-		fe.funcname,
+		f.funcname,
 		statsrepo.sub(fe.calls, fb.calls),
 		statsrepo.sub(fe.total_time, fb.total_time)::numeric(30, 3),
 		statsrepo.sub(fe.self_time, fb.self_time)::numeric(30, 3),
@@ -3098,17 +3647,24 @@ $$
 			statsrepo.sub(fe.total_time, fb.total_time)::numeric,
 			statsrepo.sub(fe.calls, fb.calls))
 	FROM
-		statsrepo.function fe LEFT JOIN statsrepo.function fb
-			ON fb.snapid = $1 AND fb.dbid = fe.dbid AND fb.nsp = fe.nsp AND fb.funcid = fe.funcid,
-		statsrepo.database d,
-		statsrepo.schema s
+		statsrepo.database d
+		JOIN statsrepo.stat_function fe
+			ON fe.snapid = COALESCE(d.carried, d.snapid)
+			AND fe.dbid = d.dbid
+		JOIN statsrepo.function f
+			ON f.snapid = statsrepo.version_snapid(
+				COALESCE(d.carried, d.snapid), d.dbid, 'function')
+			AND f.dbid = fe.dbid AND f.funcid = fe.funcid
+		JOIN statsrepo.schema s
+			ON s.snapid = statsrepo.version_snapid(
+				COALESCE(d.carried, d.snapid), d.dbid, 'schema')
+			AND s.dbid = f.dbid AND s.nsp = f.nsp
+		LEFT JOIN (statsrepo.database db JOIN statsrepo.stat_function fb
+			ON fb.snapid = COALESCE(db.carried, db.snapid)
+			AND fb.dbid = db.dbid)
+			ON db.snapid = $1 AND fb.dbid = fe.dbid AND fb.funcid = fe.funcid
 	WHERE
-		fe.snapid = $2
-		AND d.snapid = $2
-		AND s.snapid = $2
-		AND d.dbid = fe.dbid
-		AND s.dbid = fe.dbid
-		AND s.nsp = fe.nsp
+		d.snapid = $2
 	ORDER BY
 		6 DESC,
 		7 DESC,
@@ -3187,12 +3743,15 @@ $$
 		 		s.dbid,
 		 		s.userid,
 		 		s.queryid,
-		 		pg_catalog.max(s.query) AS query,
+		 		pg_catalog.max(q.query) AS query,
 				$1 AS first,
 				pg_catalog.max(s.snapid) AS last
 			 FROM
 			 	statsrepo.statement s
 				JOIN statsrepo.snapshot ss ON (ss.snapid = s.snapid)
+				LEFT JOIN statsrepo.query_text q ON
+					(q.queryid = s.queryid AND q.dbid = s.dbid AND
+					 q.userid = s.userid AND q.hash = s.query_hash)
 			 WHERE
 			 	s.snapid >= $1 AND s.snapid <= $2
 				AND ss.instid = (SELECT instid FROM statsrepo.snapshot ss1 WHERE ss1.snapid = $2)
@@ -3201,16 +3760,28 @@ $$
 				s.userid,
 				s.queryid
 			) AS reg
-		LEFT JOIN statsrepo.statement st1 ON
-			(st1.dbid = reg.dbid AND st1.userid = reg.userid AND
-			 st1.queryid = reg.queryid AND st1.snapid = reg.first)
+		LEFT JOIN LATERAL
+			(SELECT
+				s.*
+			 FROM
+				statsrepo.statement s
+				JOIN statsrepo.snapshot ss ON (ss.snapid = s.snapid)
+			 WHERE
+				s.dbid = reg.dbid AND s.userid = reg.userid AND
+				s.queryid = reg.queryid AND s.snapid <= reg.first
+				AND ss.instid = (SELECT instid FROM statsrepo.snapshot ss1 WHERE ss1.snapid = $2)
+			 ORDER BY
+				s.snapid DESC
+			 LIMIT 1
+			) AS st1 ON true
 		JOIN statsrepo.statement st2 ON
 			(st2.dbid = reg.dbid AND st2.userid = reg.userid AND
 			 st2.queryid = reg.queryid AND st2.snapid = reg.last)
 		JOIN statsrepo.database db ON
 			(db.snapid = reg.first AND db.dbid = reg.dbid)
 		JOIN statsrepo.role rol ON
-			(rol.snapid = reg.first AND rol.userid = reg.userid)
+			(rol.snapid = statsrepo.version_snapid(reg.first, 0, 'role') AND
+			 rol.userid = reg.userid)
 	) AS t1
 	WHERE
 		t1.calls > 0 and t1.total_exec_time > 0
@@ -3342,7 +3913,8 @@ $$
 		JOIN statsrepo.database db ON
 			(db.snapid = reg.first AND db.dbid = reg.dbid)
 		JOIN statsrepo.role rol ON
-			(rol.snapid = reg.first AND rol.userid = reg.userid)
+			(rol.snapid = statsrepo.version_snapid(reg.first, 0, 'role') AND
+			 rol.userid = reg.userid)
 	) AS t1
 	WHERE
 		t1.calls > 0 and t1.total_time > 0
@@ -3448,20 +4020,24 @@ $$
 		JOIN statsrepo.database db ON
 			(db.snapid = reg.last AND db.dbid = reg.dbid)
 		JOIN statsrepo.role rol ON
-			(rol.snapid = reg.last AND rol.userid = reg.userid)
+			(rol.snapid = statsrepo.version_snapid(reg.last, 0, 'role') AND
+			 rol.userid = reg.userid)
 		JOIN
-			(SELECT queryid,
-					dbid,
-					userid,
-					pg_catalog.max(query) AS query
+			(SELECT s.queryid,
+					s.dbid,
+					s.userid,
+					pg_catalog.max(q.query) AS query
 			 FROM
 			 	statsrepo.statement s
 				JOIN statsrepo.snapshot ss ON (ss.snapid = s.snapid)
+				LEFT JOIN statsrepo.query_text q ON
+					(q.queryid = s.queryid AND q.dbid = s.dbid AND
+					 q.userid = s.userid AND q.hash = s.query_hash)
 			 WHERE
 			 	s.snapid >= $1 AND s.snapid <= $2
 				AND ss.instid = (SELECT instid FROM statsrepo.snapshot WHERE snapid = $2)
 			 GROUP BY
-			 	queryid, dbid, userid
+			 	s.queryid, s.dbid, s.userid
 			) AS st ON
 				st.queryid = reg.queryid AND
 				st.dbid = reg.dbid AND
@@ -3629,6 +4205,57 @@ $$
 $$
 LANGUAGE sql;
 
+-- generate information that corresponds to 'Shared Buffers Residency'
+CREATE FUNCTION statsrepo.get_buffercache(
+	IN snapid_begin			bigint,
+	IN snapid_end			bigint,
+	OUT datname				name,
+	OUT nspname				name,
+	OUT relname				name,
+	OUT fork				text,
+	OUT buffers_avg			numeric,
+	OUT buffers_max			bigint,
+	OUT size_avg			numeric,
+	OUT dirty_ratio			numeric,
+	OUT usage_low_ratio		numeric,
+	OUT usage_mid_ratio		numeric,
+	OUT usage_high_ratio	numeric
+) RETURNS SETOF record AS
+$$
+	SELECT
+		CASE WHEN b.dbid = 0 THEN CAST('(shared)' AS name) ELSE d.name END,
+		b.nspname,
+		CASE WHEN b.relname IS NOT NULL THEN b.relname ELSE CAST('FILENODE:[' || b.relfilenode || ']' AS name) END,
+		CASE b.forknumber WHEN 0 THEN 'main' WHEN 1 THEN 'fsm' WHEN 2 THEN 'vm' WHEN 3 THEN 'init' END,
+		pg_catalog.round(pg_catalog.avg(b.buffers), 1),
+		pg_catalog.max(b.buffers),
+		pg_catalog.round(pg_catalog.avg(b.buffers) * pg_catalog.max(i.page_size) / 1024 / 1024, 3),
+		pg_catalog.round(100 * statsrepo.div(pg_catalog.sum(b.dirty), pg_catalog.sum(b.buffers)), 1),
+		pg_catalog.round(100 * statsrepo.div(pg_catalog.sum(b.usagecount_0 + b.usagecount_1), pg_catalog.sum(b.buffers)), 1),
+		pg_catalog.round(100 * statsrepo.div(pg_catalog.sum(b.usagecount_2 + b.usagecount_3), pg_catalog.sum(b.buffers)), 1),
+		pg_catalog.round(100 * statsrepo.div(pg_catalog.sum(b.usagecount_4 + b.usagecount_5), pg_catalog.sum(b.buffers)), 1)
+	FROM
+		statsrepo.buffercache b
+		LEFT JOIN statsrepo.database d ON d.snapid = b.snapid AND d.dbid = b.dbid,
+		statsrepo.snapshot s,
+		statsrepo.instance i
+	WHERE
+		b.snapid BETWEEN $1 AND $2
+		AND b.snapid = s.snapid
+		AND s.instid = i.instid
+		AND s.instid = (SELECT instid FROM statsrepo.snapshot WHERE snapid = $2)
+	GROUP BY
+		b.dbid,
+		d.name,
+		b.nspname,
+		b.relname,
+		b.relfilenode,
+		b.forknumber
+	ORDER BY
+		5 DESC;
+$$
+LANGUAGE sql;
+
 -- generate information that corresponds to 'Replication Delays'
 CREATE FUNCTION statsrepo.get_replication_delays(
 	IN snapid_begin			bigint,
@@ -3743,6 +4370,75 @@ $$
 $$
 LANGUAGE sql;
 
+-- generate information that corresponds to 'Replication Lag Samples'
+CREATE FUNCTION statsrepo.get_replication_lag(
+	IN snapid_begin			bigint,
+	IN snapid_end			bigint,
+	OUT application_name	text,
+	OUT procpid				integer,
+	OUT samples				bigint,
+	OUT write_lag_max		interval,
+	OUT flush_lag_max		interval,
+	OUT replay_lag_min		interval,
+	OUT replay_lag_p99		interval,
+	OUT replay_lag_max		interval
+) RETURNS SETOF record AS
+$$
+	SELECT
+		l.application_name,
+		l.procpid,
+		pg_catalog.sum(l.samples),
+		pg_catalog.max(l.write_lag_max),
+		pg_catalog.max(l.flush_lag_max),
+		pg_catalog.min(l.replay_lag_min),
+		pg_catalog.max(l.replay_lag_p99),
+		pg_catalog.max(l.replay_lag_max)
+	FROM
+		statsrepo.replication_lag l,
+		statsrepo.snapshot s
+	WHERE
+		l.snapid > $1 AND l.snapid <= $2
+		AND l.snapid = s.snapid
+		AND s.instid = (SELECT instid FROM statsrepo.snapshot WHERE snapid = $2)
+	GROUP BY
+		l.application_name,
+		l.procpid
+	ORDER BY
+		pg_catalog.max(l.replay_lag_max) DESC;
+$$
+LANGUAGE sql;
+
+-- generate information that corresponds to 'Replication Slot WAL Retention'
+CREATE FUNCTION statsrepo.get_replication_slot_retention(
+	IN snapid_begin			bigint,
+	IN snapid_end			bigint,
+	OUT slot_name			name,
+	OUT samples				bigint,
+	OUT retained_min		bigint,
+	OUT retained_p99		bigint,
+	OUT retained_max		bigint
+) RETURNS SETOF record AS
+$$
+	SELECT
+		r.slot_name,
+		pg_catalog.sum(r.samples),
+		pg_catalog.min(r.retained_min),
+		pg_catalog.max(r.retained_p99),
+		pg_catalog.max(r.retained_max)
+	FROM
+		statsrepo.replication_slot_retention r,
+		statsrepo.snapshot s
+	WHERE
+		r.snapid > $1 AND r.snapid <= $2
+		AND r.snapid = s.snapid
+		AND s.instid = (SELECT instid FROM statsrepo.snapshot WHERE snapid = $2)
+	GROUP BY
+		r.slot_name
+	ORDER BY
+		pg_catalog.max(r.retained_max) DESC;
+$$
+LANGUAGE sql;
+
 -- generate information that corresponds to 'Setting Parameters'
 CREATE FUNCTION statsrepo.get_setting_parameters(
 	IN snapid_begin	bigint,
@@ -3763,9 +4459,11 @@ $$
 		coalesce(se.unit, sb.unit),
 		coalesce(se.source, sb.source)
 	FROM
-		(SELECT * FROM statsrepo.setting WHERE snapid = $1) AS sb
+		(SELECT * FROM statsrepo.setting
+		  WHERE snapid = statsrepo.version_snapid($1, 0, 'setting')) AS sb
 	FULL JOIN
-		(SELECT * FROM statsrepo.setting WHERE snapid = $2) AS se
+		(SELECT * FROM statsrepo.setting
+		  WHERE snapid = statsrepo.version_snapid($2, 0, 'setting')) AS se
 		ON sb.name = se.name
 	ORDER BY
 		1;
@@ -3799,19 +4497,20 @@ $$
 		statsrepo.sub(e.idx_scan, b.idx_scan)
 	FROM
 		statsrepo.tables e LEFT JOIN
-		statsrepo.table b
+		statsrepo.tables b
 			ON e.tbl = b.tbl AND e.nsp = b.nsp AND e.dbid = b.dbid AND b.snapid = $1
 		LEFT JOIN 
 		(SELECT
-		dbid,
-		tbl,
+		col.dbid,
+		col.tbl,
 		pg_catalog.count(*) AS "columns"
 		FROM
-		statsrepo.column
+		statsrepo.column col,
+		statsrepo.column_snapids($2) cs
 		WHERE
-		snapid = $2
+		col.snapid = cs.snapid AND col.dbid = cs.dbid AND col.tbl = cs.tbl
 		GROUP BY
-		dbid, tbl) AS c
+		col.dbid, col.tbl) AS c
 		ON e.tbl = c.tbl AND e.dbid = c.dbid
 	WHERE
 		e.snapid = $2
@@ -3855,7 +4554,7 @@ $$
 		statsrepo.sub(e.idx_blks_hit, b.idx_blks_hit),
 		(pg_catalog.regexp_matches(e.indexdef, E'.*USING[^\\(]+\\((.*)\\)'))[1]
 	FROM
-		statsrepo.indexes e LEFT JOIN statsrepo.index b
+		statsrepo.indexes e LEFT JOIN statsrepo.indexes b
 			ON e.idx = b.idx AND e.tbl = b.tbl AND e.dbid = b.dbid AND b.snapid = $1
 	WHERE
 		e.snapid = $2
@@ -4343,6 +5042,19 @@ BEGIN
 END;
 $$ LANGUAGE plpgsql;
 
+-- function to create partition-tables for mini-snapshot
+CREATE FUNCTION statsrepo.create_instance_ts_partition(timestamptz) RETURNS void AS
+$$
+DECLARE
+BEGIN
+	LOCK TABLE statsrepo.instance IN SHARE UPDATE EXCLUSIVE MODE;
+
+	SET client_min_messages = warning;
+	PERFORM statsrepo.partition_new('statsrepo.instance_ts', CAST($1 AS DATE), 'CAST (timestamp AS DATE)');
+	RESET client_min_messages;
+END;
+$$ LANGUAGE plpgsql;
+
 -- function to insert partition-table for snapshot
 CREATE FUNCTION statsrepo.partition_snapshot_insert() RETURNS TRIGGER AS
 $$
@@ -4354,7 +5066,7 @@ BEGIN
 END;
 $$ LANGUAGE plpgsql;
 
--- function to insert partition-table for log
+-- function to insert partition-table for log and mini-snapshot
 CREATE FUNCTION statsrepo.partition_repolog_insert() RETURNS TRIGGER AS
 $$
 DECLARE
@@ -4370,6 +5082,7 @@ CREATE TRIGGER partition_insert_table BEFORE INSERT ON statsrepo.table FOR EACH
 CREATE TRIGGER partition_insert_index BEFORE INSERT ON statsrepo.index FOR EACH ROW EXECUTE PROCEDURE statsrepo.partition_snapshot_insert();
 CREATE TRIGGER partition_insert_column BEFORE INSERT ON statsrepo.column FOR EACH ROW EXECUTE PROCEDURE statsrepo.partition_snapshot_insert();
 CREATE TRIGGER partition_insert_log BEFORE INSERT ON statsrepo.log FOR EACH ROW EXECUTE PROCEDURE statsrepo.partition_repolog_insert();
+CREATE TRIGGER partition_insert_instance_ts BEFORE INSERT ON statsrepo.instance_ts FOR EACH ROW EXECUTE PROCEDURE statsrepo.partition_repolog_insert();
 
 -- del_snapshot2(time) - delete snapshots older than the specified timestamp.
 CREATE FUNCTION statsrepo.del_snapshot2(timestamptz) RETURNS void AS
@@ -4379,6 +5092,7 @@ $$
 	SELECT statsrepo.partition_drop(CAST($1 AS DATE), 'statsrepo.table');
 	SELECT statsrepo.partition_drop(CAST($1 AS DATE), 'statsrepo.index');
 	SELECT statsrepo.partition_drop(CAST($1 AS DATE), 'statsrepo.column');
+	SELECT statsrepo.partition_drop(CAST($1 AS DATE), 'statsrepo.instance_ts');
 
 	/*
 	 * Note:
@@ -179,12 +179,17 @@ BEGIN
 		pg_catalog.avg((c.total_exec_time - coalesce(p.total_exec_time, 0)) / (c.calls - coalesce(p.calls, 0))),
 		pg_catalog.max((c.total_exec_time - coalesce(p.total_exec_time, 0)) / (c.calls - coalesce(p.calls, 0)))
 	INTO val_res_avg, val_res_max
-	FROM (SELECT dbid, userid, total_exec_time, calls, query
+	FROM (SELECT dbid, userid, queryid, total_exec_time, calls, query_hash
 			FROM statsrepo.statement WHERE snapid = $1.snapid) AS c
-		 LEFT OUTER JOIN
-		 (SELECT dbid, userid, total_exec_time, calls, query
-		 	FROM statsrepo.statement WHERE snapid = $2.snapid) AS p
-		 ON c.dbid = p.dbid AND c.userid = p.userid AND c.query = p.query
+		 LEFT OUTER JOIN LATERAL
+		 (SELECT s.total_exec_time, s.calls
+		 	FROM statsrepo.statement s
+				 JOIN statsrepo.snapshot ss ON ss.snapid = s.snapid
+		   WHERE s.dbid = c.dbid AND s.userid = c.userid
+			 AND s.queryid = c.queryid AND s.query_hash = c.query_hash
+			 AND s.snapid <= $2.snapid AND ss.instid = $2.instid
+		   ORDER BY s.snapid DESC LIMIT 1) AS p
+		 ON true
 	WHERE c.calls <> coalesce(p.calls, 0);
 
 	-- alert if average of the query-response-time is higher than threshold.
@@ -243,14 +248,18 @@ BEGIN
 			(100 * pg_catalog.abs(c.correlation))::numeric(5,2)
 		FROM
 			statsrepo.indexes i,
+			statsrepo.column_snapids($1.snapid) cs,
 			statsrepo.column c
 		WHERE
-			i.snapid = c.snapid
+			cs.dbid = i.dbid
+			AND cs.tbl = i.tbl
+			AND c.snapid = cs.snapid
+			AND c.dbid = i.dbid
 			AND i.tbl = c.tbl
 			AND i.isclustered = true
 			AND c.attnum = i.indkey[0]
 			AND c.correlation IS NOT NULL
-			AND c.snapid = $1.snapid
+			AND i.snapid = $1.snapid
 	LOOP
 		IF $2.correlation_percent >= 0 AND val_correlation_pct < $2.correlation_percent THEN
 			RETURN NEXT 'correlation of the clustered table fell below threshold in snapshot ''' ||
@@ -699,6 +699,187 @@ pgut_wait(int num, PGconn *connections[], struct timeval *timeout)
 	return -1;
 }
 
+/*
+ * Pipeline mode. Queries are queued with pgut_pipeline_send() and flushed
+ * with pgut_pipeline_sync(), then their results are read in the same order
+ * with pgut_pipeline_result(). The connection is non-blocking while in the
+ * pipeline so that sending never waits for the server to read its results.
+ */
+bool
+pgut_pipeline_begin(PGconn *conn)
+{
+	if (conn == NULL)
+	{
+		ereport(ERROR,
+			(errcode(E_PG_COMMAND),
+			 errmsg("not connected")));
+		return false;
+	}
+
+	if (PQenterPipelineMode(conn) != 1 || PQsetnonblocking(conn, 1) != 0)
+	{
+		ereport(ERROR,
+			(errcode(E_PG_COMMAND),
+			 errmsg("could not enter pipeline mode: %s", PQerrorMessage(conn))));
+		PQexitPipelineMode(conn);
+		return false;
+	}
+
+	return true;
+}
+
+bool
+pgut_pipeline_send(PGconn *conn, const char *query, int nParams, const char **params)
+{
+	CHECK_FOR_INTERRUPTS();
+
+	/* write query to elog if debug */
+	if (pgut_echo)
+		echo_query(query, nParams, params);
+
+	/* simple query protocol is not allowed in pipeline mode */
+	if (PQsendQueryParams(conn, query, nParams, NULL, params, NULL, NULL, 0) != 1)
+	{
+		ereport(ERROR,
+			(errcode(E_PG_COMMAND),
+			 errmsg("query failed: %s", PQerrorMessage(conn)),
+			 errdetail("query was: %s", query)));
+		return false;
+	}
+
+	return true;
+}
+
+bool
+pgut_pipeline_sync(PGconn *conn)
+{
+	if (PQpipelineSync(conn) != 1)
+	{
+		ereport(ERROR,
+			(errcode(E_PG_COMMAND),
+			 errmsg("could not send pipeline sync: %s", PQerrorMessage(conn))));
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * Returns the result of the next query, or the PGRES_PIPELINE_SYNC result
+ * of the next sync point. Queries skipped after an error in the same sync
+ * group are reported as PGRES_PIPELINE_ABORTED.
+ */
+PGresult *
+pgut_pipeline_result(PGconn *conn, const char *query)
+{
+	PGresult   *res;
+	PGresult   *extra;
+
+	CHECK_FOR_INTERRUPTS();
+
+	if ((res = PQgetResult(conn)) == NULL)
+	{
+		ereport(ERROR,
+			(errcode(E_PG_COMMAND),
+			 errmsg("query failed: %s", PQerrorMessage(conn)),
+			 errdetail("query was: %s", query)));
+		return NULL;
+	}
+
+	switch (PQresultStatus(res))
+	{
+		case PGRES_PIPELINE_SYNC:
+			return res;		/* not followed by NULL */
+		case PGRES_TUPLES_OK:
+		case PGRES_COMMAND_OK:
+		case PGRES_PIPELINE_ABORTED:
+			break;
+		default:
+			ereport(ERROR,
+				(errcode(E_PG_COMMAND),
+				 errmsg("query failed: %s", PQerrorMessage(conn)),
+				 errdetail("query was: %s", query)));
+			break;
+	}
+
+	/* consume the end of the query */
+	while ((extra = PQgetResult(conn)) != NULL)
+		PQclear(extra);
+
+	return res;
+}
+
+/*
+ * Sends a sync point and reads the results of the last 'num' queries.
+ * Returns true if all of them succeeded.
+ */
+bool
+pgut_pipeline_check(PGconn *conn, int num, const char *query)
+{
+	PGresult   *res;
+	bool		ok = true;
+	int			i;
+
+	if (!pgut_pipeline_sync(conn))
+		return false;
+
+	for (i = 0; i < num; i++)
+	{
+		if ((res = pgut_pipeline_result(conn, query)) == NULL)
+			return false;
+
+		switch (PQresultStatus(res))
+		{
+			case PGRES_TUPLES_OK:
+			case PGRES_COMMAND_OK:
+				break;
+			default:
+				ok = false;
+				break;
+		}
+		PQclear(res);
+	}
+
+	/* consume the sync point */
+	if ((res = pgut_pipeline_result(conn, "SYNC")) == NULL)
+		return false;
+	PQclear(res);
+
+	return ok;
+}
+
+/*
+ * Discards the remaining results and leaves pipeline mode. Queries which
+ * have not been followed by a sync point yet are flushed with a new one.
+ */
+void
+pgut_pipeline_end(PGconn *conn)
+{
+	int		nulls = 0;
+
+	if (conn == NULL)
+		return;
+
+	PQpipelineSync(conn);
+	while (PQexitPipelineMode(conn) != 1 && PQstatus(conn) == CONNECTION_OK)
+	{
+		PGresult   *res;
+
+		/* two NULLs in a row means that no results are queued */
+		if ((res = PQgetResult(conn)) == NULL)
+		{
+			if (++nulls > 1)
+				break;
+			continue;
+		}
+
+		nulls = 0;
+		PQclear(res);
+	}
+
+	PQsetnonblocking(conn, 0);
+}
+
 /*
  * CHECK_FOR_INTERRUPTS - Ctrl+C pressed?
  */
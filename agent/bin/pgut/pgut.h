@@ -68,6 +68,12 @@ extern bool pgut_commit(PGconn *conn);
 extern void pgut_rollback(PGconn *conn);
 extern bool pgut_send(PGconn* conn, const char *query, int nParams, const char **params);
 extern int pgut_wait(int num, PGconn *connections[], struct timeval *timeout);
+extern bool pgut_pipeline_begin(PGconn *conn);
+extern bool pgut_pipeline_send(PGconn *conn, const char *query, int nParams, const char **params);
+extern bool pgut_pipeline_sync(PGconn *conn);
+extern PGresult *pgut_pipeline_result(PGconn *conn, const char *query);
+extern bool pgut_pipeline_check(PGconn *conn, int num, const char *query);
+extern void pgut_pipeline_end(PGconn *conn);
 
 /*
  * memory allocators
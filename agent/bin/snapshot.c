@@ -38,6 +38,17 @@ typedef struct Snap
 	List		*dbsnaps;		/* a list of per database snapshot */
 	char		*start;			/* start timestamp */
 	bool		 alert_logging;	/* alert logging */
+	bool		 stream;		/* stream relation statistics on writing */
+	List		*spills;		/* Spill of column and index statistics */
+	bool		 streamed;		/* relation statistics have been streamed */
+	bool		*idle;			/* per database, skipped as unchanged */
+	StringInfoData skipped;		/* stages skipped by snapshot_budget */
+	bool		 wal_unavailable;	/* WAL since the previous snapshot could
+									 * not be read with pg_walinspect */
+	char		*escalation;	/* trigger of a lightweight snapshot, or NULL */
+	char		 rotation[32];	/* slice of collect_column_rotation */
+	int64		 pool[3];		/* pooled connections reused, newly connected
+								 * and replaced since the previous snapshot */
 } Snap;
 
 /* cpustats data */
@@ -49,7 +60,194 @@ typedef struct CPUstats
 	int64	 iowait;
 } CPUstats;
 
+/* steps of the per-database collection */
+typedef enum DbStep
+{
+	DB_PREPARE,			/* set the timeout, take the fingerprint and probes */
+	DB_BEGIN,			/* begin the transaction for database_gets */
+	DB_GETS,			/* run database_gets[nget] */
+	DB_COMMIT,			/* commit the transaction */
+	DB_COLUMN,			/* collect column statistics */
+	DB_INDEX,			/* collect index statistics */
+	DB_DONE
+} DbStep;
+
+/* per database results */
+typedef struct DbResult
+{
+	const char	*dbid;
+	char		*fingerprint;	/* fingerprint of the statistics, or NULL */
+	char		*leaves;		/* leaves of partition_rollup, or NULL */
+	bool		 idle;			/* unchanged since the previous snapshot */
+	List		*dbsnap;		/* results of database_gets, or NIL */
+	List		*pending;		/* results in the current transaction */
+	PGresult	*column;		/* column statistics, or NULL */
+	PGresult	*index;			/* index statistics, or NULL */
+	bool		 chunk_column;	/* column statistics are read in chunks */
+	bool		 chunk_index;	/* index statistics are read in chunks */
+	int			 retry;			/* number of failed attempts */
+	bool		 deferred;		/* not collected for snapshot_budget */
+	bool		 column_deferred;
+	bool		 index_deferred;
+	bool		 canceled;		/* last attempt hit statement_timeout */
+	bool		 timed_out;		/* given up for snapshot_budget */
+	bool		 failed;		/* given up for errors */
+} DbResult;
+
+/* a connection which collects one database at a time */
+typedef struct DbSlot
+{
+	PGconn		*conn;
+	int			 db;			/* row number in dbnames, or -1 if idle */
+	DbStep		 step;			/* step in progress */
+	PGresult	*res;			/* result of the step read so far */
+	int			 nget;			/* position in gets for DB_GETS */
+	const char	**gets;
+	const char	*sql_column;
+	const char	*sql_index;
+	bool		 collect_column;
+	bool		 collect_index;
+	const char	*rotation;		/* slice of collect_column_rotation */
+	bool		 stream;		/* leave relations to stream_relations() */
+	bool		 chunk;			/* leave columns and indexes to collect_chunks() */
+} DbSlot;
+
+/* a query sent by do_pipeline() */
+typedef struct PipelineQuery
+{
+	const char	 *sql;
+	int			  nParams;
+	const char	**params;
+	bool		  sync;			/* end of an implicit transaction */
+	PGresult	 *res;			/* result if succeeded, or NULL */
+} PipelineQuery;
+
+/* capability probes sent along with the instance statistics */
+typedef enum Probe
+{
+	PROBE_PG_STAT_STATEMENTS,
+	PROBE_PG_STORE_PLANS,
+	PROBE_RUSAGE,
+	PROBE_PG_BUFFERCACHE,
+	PROBE_PG_WALINSPECT,
+	NUM_PROBES
+} Probe;
+
+/*
+ * column or index statistics of a database read in chunks, which are kept in
+ * a temporary file in the text COPY format without snapid, dbid and
+ * snap_date, so that the agent holds only one chunk in memory.
+ */
+typedef struct Spill
+{
+	int			 db;			/* row number in dbnames */
+	const char	*sql;			/* SQL_COPY_TABLE, _COLUMN or _INDEX */
+	FILE		*file;
+	char		*streamed;		/* time the streamed rows were read, or NULL */
+} Spill;
+
+/* fingerprint of a database collected by the previous snapshots */
+typedef struct Fingerprint
+{
+	char		*dbid;
+	char		*value;			/* SQL_SELECT_FINGERPRINT, or NULL */
+	char		 date[11];		/* date of the collection, YYYY-MM-DD */
+} Fingerprint;
+
+/* hash of the metadata written last, to write a new version only on change */
+typedef struct Version
+{
+	char		*dbid;			/* "0" for setting and role */
+	const char	*kind;			/* name of the repository table */
+	uint64		 hash;
+	bool		 valid;			/* hash is in the repository */
+	uint64		 pending;		/* hash written in the current transaction */
+	bool		 has_pending;
+} Version;
+
+/* counters of a statement collected last, for stat_statements_delta */
+typedef struct StatementCounter
+{
+	Oid			dbid;
+	Oid			userid;
+	int64		queryid;
+	bool		toplevel;
+	int64		calls;
+	char		total_exec_time[32];	/* as returned by the server */
+	int64		io;
+} StatementCounter;
+
+/* query text known to be in statsrepo.query_text */
+typedef struct QueryTextKey
+{
+	Oid			dbid;
+	Oid			userid;
+	int64		queryid;
+	int64		hash;
+} QueryTextKey;
+
+/* plan text known to be in statsrepo.plan_text */
+typedef struct KnownPlan
+{
+	int64		planid;
+	int64		hash;
+	char		date[11];		/* date of the snapshot referring to it */
+	uint64		used;			/* for LRU replacement */
+} KnownPlan;
+
+/* mini-snapshot of the instance-level counters */
+typedef struct InstanceTs
+{
+	QueueItem	 base;
+
+	PGresult	*counters;		/* SQL_SELECT_INSTANCE_TS */
+} InstanceTs;
+
+/* name of the prepared SQL_SELECT_INSTANCE_TS */
+#define INSTANCE_TS_STATEMENT	"statsinfo_instance_ts"
+
+/* number of entries in known_plans */
+#define KNOWN_PLANS_MAX		1024
+
+/* position of the table statistics in database_gets and the like */
+#define DATABASE_GETS_TABLE	1
+
+/* rows read at a time by streaming when snapshot_chunk_rows is 0 */
+#define STREAM_CHUNK_ROWS	1000
+
+/*
+ *	statsrepo.table/column/index has columns as snapid, dbid, xx, xx, date, ....
+ *	If we perform COPY  to these tables, must care about partition key column(date).
+ *	For now, these tables has date column at attnum = 5.
+ *	And in do_put_copy() snapid and dbid would be always set.
+ *	So, when the data to be copied is extracted from the resultSet and added to the buffer,
+ *	snap_date should be inserted at the position of this constant.
+ */
+#define PART_KEY_POSITION 2
+
 static CPUstats	 prev_cpustats = {0, 0, 0, 0};
+static PGconn	*stream_conn = NULL;	/* used by the writer for streaming */
+static List		*fingerprints = NIL;	/* Fingerprint of each database */
+static List		*versions = NIL;		/* Version used by the writer */
+static StatementCounter *stmt_counters = NULL;	/* sorted by the key */
+static int		 stmt_ncounters = 0;
+static char		 stmt_counters_date[11];	/* date of the full collection */
+static pthread_mutex_t stmt_counters_lock = PTHREAD_MUTEX_INITIALIZER;
+static QueryTextKey *query_texts = NULL;	/* sorted, used by the writer */
+static int		 nquery_texts = 0;
+static QueryTextKey *pending_texts = NULL;	/* written in the transaction */
+static int		 npending_texts = 0;
+static char		 query_texts_date[11];	/* date query_texts is confirmed */
+static KnownPlan known_plans[KNOWN_PLANS_MAX];	/* shared by the threads */
+static int		 nknown_plans = 0;
+static uint64	 known_plans_clock = 0;
+static pthread_mutex_t known_plans_lock = PTHREAD_MUTEX_INITIALIZER;
+static char		*prev_wal_location = NULL;
+static int64	 prev_pool[3] = {0, 0, 0};
+static PGconn	*instance_ts_conn = NULL;	/* has INSTANCE_TS_STATEMENT */
+static char		 instance_ts_date[11];	/* date of the last partition */
+static int64	 snapshot_deadline = 0;	/* in ms, or 0 without budget */
+static int64	 column_rotation = 0;	/* number of full snapshots taken */
 
 static const char *instance_gets[] =
 {
@@ -72,10 +270,30 @@ static const char *instance_gets[] =
 	SQL_SELECT_XLOG,
 	SQL_SELECT_ARCHIVE,
 	SQL_SELECT_REPLICATION_SLOTS,
+	SQL_SELECT_REPLICATION_LAG,
+	SQL_SELECT_REPLICATION_SLOT_RETENTION,
+	SQL_SELECT_PROGRESS,
 	SQL_SELECT_WAIT_SAMPLING_PROFILE,
 /*	SQL_SELECT_STATEMENT,	*/
 /*	SQL_SELECT_PLAN,	*/
 /*	SQL_SELECT_RUSAGE,	*/
+/*	SQL_SELECT_BUFFERCACHE,	*/
+/*	SQL_SELECT_WAL_COMPOSITION,	*/
+/*	SQL_SELECT_BACKEND_MEMORY,	*/
+	NULL
+};
+
+/*
+ * instance_gets which drain the samples of the library. Each of them runs as
+ * a separated transaction, so that a failure of another query does not lose
+ * the samples already removed from the shared memory.
+ */
+static const char *instance_drains[] =
+{
+	SQL_SELECT_LOCK,
+	SQL_SELECT_REPLICATION_LAG,
+	SQL_SELECT_REPLICATION_SLOT_RETENTION,
+	SQL_SELECT_PROGRESS,
 	NULL
 };
 
@@ -100,29 +318,102 @@ static const char *instance_puts[] =
 	SQL_INSERT_XLOG,
 	SQL_INSERT_ARCHIVE,
 	SQL_INSERT_REPLICATION_SLOTS,
+	SQL_INSERT_REPLICATION_LAG,
+	SQL_INSERT_REPLICATION_SLOT_RETENTION,
+	SQL_INSERT_PROGRESS,
 	SQL_INSERT_WAIT_SAMPLING_PROFILE,
 	SQL_INSERT_STATEMENT,
 	SQL_INSERT_HT_INFO,
 	SQL_INSERT_PLAN,
 	SQL_INSERT_RUSAGE,
+	SQL_INSERT_BUFFERCACHE,
+	SQL_INSERT_WAL_COMPOSITION,
+	SQL_INSERT_BACKEND_MEMORY,
 	NULL
 };
 
+static const char *instance_probes[] =
+{
+	SQL_PROBE_PG_STAT_STATEMENTS,
+	SQL_PROBE_PG_STORE_PLANS,
+	SQL_PROBE_RUSAGE,
+	SQL_PROBE_PG_BUFFERCACHE,
+	SQL_PROBE_PG_WALINSPECT
+};
+
 static const char *database_gets[] =
 {
 	SQL_SELECT_SCHEMA,
 	SQL_SELECT_TABLE,
 	SQL_SELECT_INHERITS,
 	SQL_SELECT_FUNCTION,
+	SQL_SELECT_STAT_FUNCTION,
+	NULL
+};
+
+/* same as database_gets, but tables are collected by the library */
+static const char *database_bulk_gets[] =
+{
+	SQL_SELECT_SCHEMA,
+	SQL_SELECT_TABLE_BULK,
+	SQL_SELECT_INHERITS,
+	SQL_SELECT_FUNCTION,
+	SQL_SELECT_STAT_FUNCTION,
+	NULL
+};
+
+/* same as above, but leaf partitions are rolled up */
+static const char *database_rollup_gets[] =
+{
+	SQL_SELECT_SCHEMA,
+	SQL_SELECT_TABLE_ROLLUP(SQL_SELECT_TABLE),
+	SQL_SELECT_INHERITS,
+	SQL_SELECT_FUNCTION,
+	SQL_SELECT_STAT_FUNCTION,
+	NULL
+};
+
+static const char *database_bulk_rollup_gets[] =
+{
+	SQL_SELECT_SCHEMA,
+	SQL_SELECT_TABLE_ROLLUP(SQL_SELECT_TABLE_BULK),
+	SQL_SELECT_INHERITS,
+	SQL_SELECT_FUNCTION,
+	SQL_SELECT_STAT_FUNCTION,
+	NULL
+};
+
+/* tables, columns and indexes are streamed by the writer */
+static const char *database_stream_gets[] =
+{
+	SQL_SELECT_SCHEMA,
+	SQL_SELECT_INHERITS,
+	SQL_SELECT_FUNCTION,
+	SQL_SELECT_STAT_FUNCTION,
 	NULL
 };
 
+/* metadata written only when changed, and the repository tables */
+static const struct
+{
+	const char *sql;
+	const char *kind;
+} version_puts[] =
+{
+	{ SQL_INSERT_SETTING, "setting" },
+	{ SQL_INSERT_ROLE, "role" },
+	{ SQL_COPY_SCHEMA, "schema" },
+	{ SQL_COPY_INHERITS, "inherits" },
+	{ SQL_COPY_FUNCTION, "function" }
+};
+
 static const char *database_puts[] =
 {
 	SQL_COPY_SCHEMA,
 	SQL_COPY_TABLE,
 	SQL_COPY_INHERITS,
 	SQL_COPY_FUNCTION,
+	SQL_COPY_STAT_FUNCTION,
 	SQL_COPY_COLUMN,
 	SQL_COPY_INDEX,
 	NULL
@@ -130,8 +421,14 @@ static const char *database_puts[] =
 
 static void Snap_free(Snap *snap);
 static bool Snap_exec(Snap *snap, PGconn *conn, const char *instid);
-static List *do_gets(PGconn *conn, const char *sql[],
-					 int nParams, const char **params);
+static bool acquire_write_slot(PGconn *conn, const char *instid);
+static void pool_usage(int64 usage[3]);
+static void InstanceTs_free(InstanceTs *ts);
+static bool InstanceTs_exec(InstanceTs *ts, PGconn *conn, const char *instid);
+static int pipeline_add(PipelineQuery *queries, int *num, const char *sql,
+						int nParams, const char **params, bool sync);
+static bool do_pipeline(PGconn *conn, PipelineQuery *queries, int num);
+static bool is_instance_drain(const char *sql);
 static PGresult *do_get(PGconn *conn, const char *sql,
 						int nParams, const char **params);
 static bool do_puts(PGconn *conn, const char *sql[], List *src,
@@ -140,33 +437,85 @@ static bool do_put(PGconn *conn, const char *sql, PGresult *src,
 				   const char *snapid, const char *dbid);
 static bool do_put_copy(PGconn *conn, const char *sql, PGresult *src,
 				   const char *snapid, const char *dbid, const char *snap_date);
-static bool has_pg_stat_statements(PGconn *conn);
-static bool has_pg_store_plans(PGconn *conn);
 static bool has_statsrepo_alert(PGconn *conn);
-static bool is_rusage_enabled(PGconn *conn);
-static bool is_collect_column_enabled(PGconn *conn);
-static bool is_collect_index_enabled(PGconn *conn);
+static bool has_relation_stats(PGconn *conn);
+static void destroy_PGresult_list(List *list);
+static void collect_databases(Snap *snap);
+static void db_slot_run(DbSlot *slot, DbResult *result, const char *db);
+static bool db_slot_connect(DbSlot *slot, DbResult *result, const char *db);
+static void db_slot_prepared(DbSlot *slot, DbResult *result, PGresult *res);
+static bool partition_rollup_enabled(void);
+static const char **relation_queries(bool bulk, const char **sql_column,
+									const char **sql_index);
+static void probe_collect(PGconn *conn, bool *collect_column,
+						  bool *collect_index);
+static bool stream_relations(Snap *snap, int db, List **spills);
+static Spill *stream_spill(PGconn *src, int db, const char *sql, int nParams,
+						   const char **params, const char *copy_sql);
+static bool db_slot_send(DbSlot *slot, DbResult *result);
+static bool db_slot_ready(DbSlot *slot);
+static bool db_slot_receive(DbSlot *slot, DbResult *result);
+static bool db_slot_failed(DbSlot *slot, DbResult *result);
+static void collect_chunks(Snap *snap, DbResult *results);
+static bool collect_chunk_rows(Snap *snap, int db, const char *leaves,
+							   const char *copy_sql);
+static FILE *spill_query(PGconn *conn, const char *sql, int nParams,
+						 const char **params, int chunk_rows);
+static bool spill_rows(FILE *file, PGresult *res);
+static bool spill_read_line(FILE *file, StringInfo line);
+static bool write_spill(PGconn *conn, Spill *spill, const char *snapid,
+						const char *dbid, const char *snap_date);
+static Fingerprint *get_fingerprint(const char *dbid);
+static const char *version_kind(const char *sql);
+static bool version_unchanged(PGconn *conn, const char *kind, PGresult *res,
+							  const char *snapid, const char *dbid);
+static bool version_insert(PGconn *conn, const char *kind,
+						   const char *snapid, const char *dbid);
+static void version_end(bool commit);
+static uint64 hash_result(PGresult *res);
+static void query_text_expire(const char *start);
+static bool do_put_statement(PGconn *conn, PGresult *src, const char *snapid);
+static void query_text_end(bool commit);
+static int	query_text_cmp(const void *a, const void *b);
+static void known_plans_params(const char *start, StringInfo planids,
+							   StringInfo hashes);
+static void known_plans_add(PGresult *res, const char *start);
+static int64 current_ms(void);
+static bool budget_exceeded(void);
+static const char *budget_timeout(char *timeout, size_t size);
+static bool budget_set_timeout(PGconn *conn);
+static void budget_skipped(Snap *snap, const char *db, const char *stage,
+						   const char *reason);
+static void statement_counters_params(const char *start, StringInfo arrays);
+static void statement_counters_update(PGresult *res, const char *start);
+static int	statement_counter_cmp(const void *a, const void *b);
 
 
 QueueItem *
-get_snapshot(char *comment)
+get_snapshot(char *comment, const char *escalation)
 {
 	PGconn		*conn = NULL;
 	PGresult	*activity = NULL;
 	PGresult	*long_xact = NULL;
+	PGresult	*backend_memory = NULL;
 	PGresult	*cpuinfo = NULL;
+	PGresult	*gets[lengthof(instance_gets)];
+	bool		 committed = false;
 	Snap		*snap;
 	int64		 cpu_user;
 	int64		 cpu_system;
 	int64		 cpu_idle;
 	int64		 cpu_iowait;
-	int			 r;
-	int			 rows;
+	char		*wal_location = NULL;
+	bool		 probes[NUM_PROBES];
 	int			 retry;
 
 	/* allocate a new Snap object */
 	snap = pgut_new(Snap);
 	memset(snap, 0, sizeof(*snap));
+	memset(probes, 0, sizeof(probes));
+	memset(gets, 0, sizeof(gets));
+	snap->stream = snapshot_streaming;
 
 	/*
 	 * collect instance statistics
@@ -182,77 +531,198 @@ get_snapshot(char *comment)
 		return NULL;
 	}
 
+	/*
+	 * The instance-level statistics are collected regardless of the budget.
+	 * A lightweight snapshot starts over its budget, so that the databases
+	 * are carried over from their last snapshot.
+	 */
+	initStringInfo(&snap->skipped);
+	if (escalation != NULL)
+	{
+		snap->escalation = pgut_strdup(escalation);
+		snapshot_deadline = 1;
+	}
+	else
+		snapshot_deadline = (snapshot_budget > 0 ?
+							 current_ms() + (int64) snapshot_budget * 1000 : 0);
+
+	/*
+	 * Each full snapshot collects the next slice of collect_column_rotation.
+	 * A lightweight snapshot collects no columns, so it keeps the slice.
+	 */
+	snprintf(snap->rotation, sizeof(snap->rotation), INT64_FORMAT,
+			 column_rotation);
+	if (escalation == NULL)
+		column_rotation++;
+
+	/*
+	 * All of the instance-level queries and the capability probes are sent
+	 * in one pipeline, so that they cost a single round trip.
+	 */
 	for (retry = 0;
 		 shutdown_state < SHUTDOWN_REQUESTED && retry < DB_MAX_RETRY;
 		 delay(), retry++)
 	{
+		PipelineQuery	 queries[lengthof(instance_gets) + NUM_PROBES + 7];
+		int				 nqueries = 0;
+		int				 i_activity = -1;
+		int				 i_long_xact = -1;
+		int				 i_backend_memory = -1;
+		int				 i_cpuinfo = -1;
+		int				 i_dbnames = -1;
+		int				 i_gets[lengthof(instance_gets)];
+		int				 i_begin = -1;
+		int				 i_commit = -1;
+		int				 i_probe;
+		bool			 drained;
+		const char		*cpu_params[1];
+		const char		*db_params[1];
+		char			 buf[1024];
+		int				 i;
+
 		/* connect to postgres database and ensure functions are installed */
 		if ((conn = collector_connect(NULL)) == NULL)
 			continue;
 
 		/* query activities as a separated transaction. */
 		if (activity == NULL)
-		{
-			activity = do_get(conn, SQL_SELECT_ACTIVITY, 0, NULL);
-			if (activity == NULL)
-				continue;
-		}
+			i_activity = pipeline_add(queries, &nqueries,
+									  SQL_SELECT_ACTIVITY, 0, NULL, true);
 
 		/* query long transaction as a separated transaction. */
 		if (long_xact == NULL)
-		{
-			long_xact = do_get(conn, SQL_SELECT_LONG_TRANSACTION, 0, NULL);
-			if (long_xact == NULL)
-				continue;
-		}
+			i_long_xact = pipeline_add(queries, &nqueries,
+									   SQL_SELECT_LONG_TRANSACTION, 0, NULL, true);
+
+		/* query backend memory as a separated transaction. */
+		if (backend_memory == NULL)
+			i_backend_memory = pipeline_add(queries, &nqueries,
+											SQL_SELECT_BACKEND_MEMORY, 0, NULL, true);
 
 		/* query cpuinfo as a separated transaction. */
 		if (cpuinfo == NULL)
 		{
-			const char *params[1];
-			char buf[1024];
-
 			snprintf(buf, sizeof(buf), PARAMS_FORMAT_CPUSTATS,
 				prev_cpustats.user,
 				prev_cpustats.system,
 				prev_cpustats.idle,
 				prev_cpustats.iowait);
 
-			params[0] = buf;
-			cpuinfo = do_get(conn, SQL_SELECT_CPU, 1, params);
-			if (cpuinfo == NULL)
-				continue;
+			cpu_params[0] = buf;
+			i_cpuinfo = pipeline_add(queries, &nqueries,
+									 SQL_SELECT_CPU, 1, cpu_params, true);
+		}
 
+		/* enum databases */
+		if (snap->dbnames == NULL)
+		{
+			db_params[0] = excluded_dbnames;
+			i_dbnames = pipeline_add(queries, &nqueries,
+									 SQL_SELECT_DATABASE, 1, db_params, true);
+		}
+
+		/* query each of the draining statistics as a separated transaction. */
+		for (i = 0; instance_gets[i]; i++)
+		{
+			i_gets[i] = -1;
+			if (gets[i] == NULL && is_instance_drain(instance_gets[i]))
+				i_gets[i] = pipeline_add(queries, &nqueries,
+										 instance_gets[i], 0, NULL, true);
+		}
+
+		/* query other instance-level statistics in a transaction */
+		if (!committed)
+		{
+			i_begin = pipeline_add(queries, &nqueries, "BEGIN", 0, NULL, false);
+			for (i = 0; instance_gets[i]; i++)
+			{
+				if (!is_instance_drain(instance_gets[i]))
+					i_gets[i] = pipeline_add(queries, &nqueries,
+											 instance_gets[i], 0, NULL, false);
+			}
+			i_commit = pipeline_add(queries, &nqueries, "COMMIT", 0, NULL, true);
+		}
+
+		/* check which optional statistics are available */
+		i_probe = nqueries;
+		for (i = 0; i < NUM_PROBES; i++)
+			pipeline_add(queries, &nqueries, instance_probes[i], 0, NULL, false);
+
+		do_pipeline(conn, queries, nqueries);
+
+		if (i_activity >= 0)
+			activity = queries[i_activity].res;
+		if (i_long_xact >= 0)
+			long_xact = queries[i_long_xact].res;
+		if (i_backend_memory >= 0)
+			backend_memory = queries[i_backend_memory].res;
+		if (i_dbnames >= 0)
+			snap->dbnames = queries[i_dbnames].res;
+		if (i_cpuinfo >= 0 && (cpuinfo = queries[i_cpuinfo].res) != NULL)
+		{
 			parse_int64(PQgetvalue(cpuinfo, 0, 1), &cpu_user);
 			parse_int64(PQgetvalue(cpuinfo, 0, 2), &cpu_system);
 			parse_int64(PQgetvalue(cpuinfo, 0, 3), &cpu_idle);
 			parse_int64(PQgetvalue(cpuinfo, 0, 4), &cpu_iowait);
 		}
 
-		/* enum databases */
-		if (snap->dbnames == NULL)
+		/* the statistics are valid only when the transaction has committed */
+		if (i_begin >= 0)
 		{
-			const char *params[1];
+			committed = (queries[i_commit].res != NULL);
+			for (i = 0; instance_gets[i]; i++)
+			{
+				if (i_gets[i] < 0 || is_instance_drain(instance_gets[i]))
+					continue;
+				if (committed)
+					gets[i] = queries[i_gets[i]].res;
+				else
+					PQclear(queries[i_gets[i]].res);
+			}
+			PQclear(queries[i_begin].res);
+			PQclear(queries[i_commit].res);
+			pgut_rollback(conn);
+		}
 
-			params[0] = excluded_dbnames;
-			snap->dbnames = do_get(conn, SQL_SELECT_DATABASE, 1, params);
-			if (snap->dbnames == NULL)
-				continue;
+		/* the drained samples are kept even if another query fails */
+		drained = true;
+		for (i = 0; instance_gets[i]; i++)
+		{
+			if (i_gets[i] >= 0 && is_instance_drain(instance_gets[i]))
+				gets[i] = queries[i_gets[i]].res;
+			if (is_instance_drain(instance_gets[i]) && gets[i] == NULL)
+				drained = false;
+		}
+
+		for (i = 0; i < NUM_PROBES; i++)
+		{
+			PGresult   *res = queries[i_probe + i].res;
+
+			probes[i] = (res != NULL && PQntuples(res) > 0);
+			PQclear(res);
 		}
 
-		/* query other instance-level statistics */
-		snap->instance = do_gets(conn, instance_gets, 0, NULL);
-		if (snap->instance == NIL)
+		if (activity == NULL || long_xact == NULL || backend_memory == NULL ||
+			cpuinfo == NULL || snap->dbnames == NULL || !committed || !drained)
 			continue;
 
+		/* gather the instance-level statistics in the order of instance_gets */
+		for (i = 0; instance_gets[i]; i++)
+			snap->instance = lappend(snap->instance, gets[i]);
+
 		break;	/* ok */
 	}
 
 	if (snap->instance == NIL)
 	{
+		int		i;
+
 		PQclear(activity);		/* activity has not been assigned yet */
 		PQclear(long_xact);		/* long transaction has not been assigned yet */
+		PQclear(backend_memory);	/* backend memory has not been assigned yet */
 		PQclear(cpuinfo);		/* cpuinfo has not been assigned yet */
+		for (i = 0; instance_gets[i]; i++)
+			PQclear(gets[i]);	/* gets have not been assigned yet */
 		Snap_free(snap);
 		return NULL;
 	}
@@ -265,16 +735,25 @@ get_snapshot(char *comment)
 	snap->instance = lcons(activity, snap->instance);
 
 	/* When pg_stat_statements is installed, we collect it */
-	if (has_pg_stat_statements(conn))
+	if (probes[PROBE_PG_STAT_STATEMENTS])
 	{
 		StringInfoData	 query;
+		StringInfoData	 arrays[7];
 		PGresult		*stmt;
 		PGresult		*htinfo;
-		const char		*params[] = {stat_statements_exclude_users, stat_statements_max};
+		const char		*params[10];
+		int				 i;
+
+		statement_counters_params(snap->start, arrays);
+		params[0] = stat_statements_exclude_users;
+		params[1] = stat_statements_max;
+		params[2] = stat_statements_top;
+		for (i = 0; i < lengthof(arrays); i++)
+			params[3 + i] = arrays[i].data;
 
 		initStringInfo(&query);
 		appendStringInfo(&query, SQL_SELECT_STATEMENT);
-		stmt = pgut_execute(conn, query.data, 2, params);
+		stmt = pgut_execute(conn, query.data, lengthof(params), params);
 		if (PQresultStatus(stmt) == PGRES_TUPLES_OK)
 			snap->instance = lappend(snap->instance, stmt);
 		else
@@ -284,6 +763,8 @@ get_snapshot(char *comment)
 		}
 
 		termStringInfo(&query);
+		for (i = 0; i < lengthof(arrays); i++)
+			termStringInfo(&arrays[i]);
 
 		/* 
 		 * If pg_stat_statements is installed, also collect info(dealloc and stats_reset).
@@ -317,13 +798,56 @@ get_snapshot(char *comment)
 	}
 
 	/* When pg_store_plans is installed, we collect it */
-	if (has_pg_store_plans(conn))
+	if (probes[PROBE_PG_STORE_PLANS])
+	{
+		PGresult	   *stmt;
+		StringInfoData	planids;
+		StringInfoData	hashes;
+		const char	   *params[4];
+
+		known_plans_params(snap->start, &planids, &hashes);
+		params[0] = stat_statements_exclude_users;
+		params[1] = stat_statements_max;
+		params[2] = planids.data;
+		params[3] = hashes.data;
+
+		if (budget_exceeded())
+		{
+			budget_skipped(snap, NULL, "plans", "over budget");
+			snap->instance = lappend(snap->instance, NULL);
+		}
+		else
+		{
+			bool	timeout = budget_set_timeout(conn);
+
+			pgut_command(conn, "SET pg_store_plans.plan_format TO 'raw'", 0, NULL);
+			stmt = pgut_execute(conn, SQL_SELECT_PLAN, 4, params);
+			if (PQresultStatus(stmt) == PGRES_TUPLES_OK)
+				snap->instance = lappend(snap->instance, stmt);
+			else
+			{
+				if (timeout)
+					budget_skipped(snap, NULL, "plans", "timed out");
+				PQclear(stmt);
+				snap->instance = lappend(snap->instance, NULL);
+			}
+			if (timeout)
+				pgut_command(conn, "RESET statement_timeout", 0, NULL);
+		}
+
+		termStringInfo(&planids);
+		termStringInfo(&hashes);
+	}
+	else
+		snap->instance = lappend(snap->instance, NULL);
+
+	/* When rusage is enabled, we collect it*/
+	if (probes[PROBE_RUSAGE])
 	{
 		PGresult   *stmt;
 		const char *params[] = {stat_statements_exclude_users, stat_statements_max};
 
-		pgut_command(conn, "SET pg_store_plans.plan_format TO 'raw'", 0, NULL);
-		stmt = pgut_execute(conn, SQL_SELECT_PLAN, 2, params);
+		stmt = pgut_execute(conn, SQL_SELECT_RUSAGE, 2, params);
 		if (PQresultStatus(stmt) == PGRES_TUPLES_OK)
 			snap->instance = lappend(snap->instance, stmt);
 		else
@@ -335,13 +859,23 @@ get_snapshot(char *comment)
 	else
 		snap->instance = lappend(snap->instance, NULL);
 
-	/* When rusage is enabled, we collect it*/
-	if (is_rusage_enabled(conn))
+	/*
+	 * When pg_buffercache is installed, we collect it. The scan locks every
+	 * buffer header, so skip it altogether when nothing would be recorded.
+	 */
+	if (!probes[PROBE_PG_BUFFERCACHE] || atoi(buffercache_max) <= 0)
+		snap->instance = lappend(snap->instance, NULL);
+	else if (budget_exceeded())
+	{
+		budget_skipped(snap, NULL, "buffercache", "over budget");
+		snap->instance = lappend(snap->instance, NULL);
+	}
+	else
 	{
 		PGresult   *stmt;
-		const char *params[] = {stat_statements_exclude_users, stat_statements_max};
+		const char *params[] = {buffercache_max};
 
-		stmt = pgut_execute(conn, SQL_SELECT_RUSAGE, 2, params);
+		stmt = pgut_execute(conn, SQL_SELECT_BUFFERCACHE, 1, params);
 		if (PQresultStatus(stmt) == PGRES_TUPLES_OK)
 			snap->instance = lappend(snap->instance, stmt);
 		else
@@ -350,59 +884,45 @@ get_snapshot(char *comment)
 			snap->instance = lappend(snap->instance, NULL);
 		}
 	}
-	else
-		snap->instance = lappend(snap->instance, NULL);
 
-	/* collect database statistics */
-	rows = PQntuples(snap->dbnames);
-	for (r = 0; r < rows; r++)
+	/*
+	 * When pg_walinspect is installed, we summarize the WAL generated since
+	 * the previous snapshot.
+	 */
+	if (probes[PROBE_PG_WALINSPECT])
 	{
-		const char *db = PQgetvalue(snap->dbnames, r, 1);
-		List	   *dbsnap = NIL;
-		PGresult	*dbsnap_column = NULL;
-		PGresult	*dbsnap_index = NULL;
-		const char *params[] = {excluded_schemas};
+		PGresult   *location;
+		PGresult   *stmt = NULL;
 
-		elog(DEBUG2, "snapshot (database=%s)", db);
-		for (retry = 0;
-			 shutdown_state < SHUTDOWN_REQUESTED && retry < DB_MAX_RETRY;
-			 delay(), retry++)
+		location = do_get(conn, SQL_SELECT_WAL_LOCATION, 0, NULL);
+		if (location != NULL && PQntuples(location) > 0)
 		{
-			if ((conn = collector_connect(db)) == NULL)
-				continue;
-
-			if (dbsnap == NIL)
-			{
-				dbsnap = do_gets(conn, database_gets, 1, params);
-				if (dbsnap == NIL)
-					continue;
-			}
+			wal_location = pgut_strdup(PQgetvalue(location, 0, 0));
 
-			if (is_collect_column_enabled(conn) && dbsnap_column == NULL)
+			if (prev_wal_location != NULL && atoi(walinspect_max_size) > 0)
 			{
-				dbsnap_column = do_get(conn, SQL_SELECT_COLUMN, 1, params);
-				if (dbsnap_column == NULL)
-					continue;
-			}
+				const char *params[] =
+					{prev_wal_location, wal_location, walinspect_max_size};
 
-			if (is_collect_index_enabled(conn) && dbsnap_index == NULL)
-			{
-        		dbsnap_index = do_get(conn, SQL_SELECT_INDEX, 1, params);
-				if (dbsnap_index == NULL)
-					continue;
+				/*
+				 * The location advances even if the WAL could not be read,
+				 * so that an unreadable range is not retried forever.
+				 */
+				stmt = do_get(conn, SQL_SELECT_WAL_COMPOSITION, 3, params);
+				snap->wal_unavailable = (stmt == NULL);
 			}
-			
-			break;	/* ok */
 		}
-		
-		/* if is_collect_column_enabled is false, dbsnap_column is null */
-		dbsnap = lappend(dbsnap, dbsnap_column);
+		PQclear(location);
+		snap->instance = lappend(snap->instance, stmt);
+	}
+	else
+		snap->instance = lappend(snap->instance, NULL);
 
-		/* if is_collect_index_enabled is false, dbsnap_index is null */
-		dbsnap = lappend(dbsnap, dbsnap_index);
+	/* append the backend memory sampled since the previous snapshot */
+	snap->instance = lappend(snap->instance, backend_memory);
 
-		snap->dbsnaps = lappend(snap->dbsnaps, dbsnap);
-	}
+	/* collect database statistics */
+	collect_databases(snap);
 
 	/* ok, fill other fields. */
 	snap->base.type = QUEUE_SNAPSHOT;
@@ -416,90 +936,1495 @@ get_snapshot(char *comment)
 	prev_cpustats.system = cpu_system;
 	prev_cpustats.idle = cpu_idle;
 	prev_cpustats.iowait = cpu_iowait;
+	free(prev_wal_location);
+	prev_wal_location = wal_location;
+
+	pool_usage(snap->pool);
 
 	return (QueueItem *) snap;
 }
 
+/*
+ * pool_usage - usage of the connection pool since the previous snapshot
+ */
 static void
-destroy_PGresult_list(List *list)
+pool_usage(int64 usage[3])
 {
-	list_destroy(list, PQclear);
-}
+	int64	total[3];
+	int		i;
 
-static void
-Snap_free(Snap *snap)
-{
-	if (snap)
+	collector_pool_counters(&total[0], &total[1], &total[2]);
+	for (i = 0; i < lengthof(total); i++)
 	{
-		free(snap->comment);
-		PQclear(snap->dbnames);
-		destroy_PGresult_list(snap->instance);
-		list_destroy(snap->dbsnaps, destroy_PGresult_list);
-		if (snap->start != NULL)
-			free(snap->start);
-		free(snap);
+		usage[i] = total[i] - prev_pool[i];
+		prev_pool[i] = total[i];
 	}
 }
 
 /*
- * insert statstics into the repository server
+ * acquire_write_slot - take one of repository_write_slots advisory locks, or
+ * wait for the slot of the instance if all of them are taken. The lock is
+ * released at the end of the transaction.
  */
 static bool
-Snap_exec(Snap *snap, PGconn *conn, const char *instid)
+acquire_write_slot(PGconn *conn, const char *instid)
 {
-	PGresult   *snapid_date_res = NULL;
-	const char *params[4];
-	const char *snapid;
-	const char *snap_date;
-	ListCell   *db;
-	int			i;
-	PGresult   *repo_size = NULL;
-	PGresult   *alerts = NULL;
-	PGresult   *update_res = NULL;
-	char	   *end = NULL;
-
-	elog(DEBUG2, "write (snapshot)");
-
-	/*
-	 * create partition tables
-	 */
-	params[0] = snap->start;
-	if (pgut_command(conn,
-		SQL_CREATE_SNAPSHOT_PARTITION, 1, params) != PGRES_TUPLES_OK)
-		goto error;
-	if (pgut_command(conn,
-		SQL_CREATE_REPOLOG_PARTITION, 1, params) != PGRES_TUPLES_OK)
-		goto error;
+	char		slots[16];
+	const char *params[2];
+	PGresult   *res;
+	bool		acquired;
 
-	if (pgut_command(conn, "BEGIN", 0, NULL) != PGRES_COMMAND_OK)
-		goto error;
+	snprintf(slots, sizeof(slots), "%d", repository_write_slots);
+	params[0] = slots;
+	params[1] = instid;
 
-	/* exclusive control for don't run concurrently with the maintenance */
-	if (pgut_command(conn,
-		"LOCK TABLE statsrepo.instance IN SHARE MODE", 0, NULL) != PGRES_COMMAND_OK)
-		goto error;
+	res = pgut_execute(conn, SQL_TRY_WRITE_SLOT, 2, params);
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		PQclear(res);
+		return false;
+	}
+	acquired = !PQgetisnull(res, 0, 0);
+	PQclear(res);
 
-	/*
-	 * get statsrepo schema relation total size
-	 */
-	repo_size = do_get(conn, SQL_SELECT_REPOSIZE, 0, NULL);
-	if (repo_size == NULL)
-		goto error;
+	if (acquired)
+		return true;
 
-	params[0] = instid;
-	params[1] = snap->start;
-	params[2] = snap->comment;
-	snapid_date_res = pgut_execute(conn, SQL_NEW_SNAPSHOT, 3, params);
-	if (PQntuples(snapid_date_res) == 0 || PQnfields(snapid_date_res) != 2)
-		goto error;
+	elog(DEBUG2, "waiting for a write slot of the repository");
+	return pgut_command(conn, SQL_WAIT_WRITE_SLOT, 2, params) == PGRES_TUPLES_OK;
+}
 
-	snapid = PQgetvalue(snapid_date_res, 0, 0);
-	snap_date = PQgetvalue(snapid_date_res, 0, 1);
+/*
+ * get_instance_ts - take a mini-snapshot. Only the instance-level counters
+ * are read with a single statement, which is prepared once per connection.
+ */
+QueueItem *
+get_instance_ts(void)
+{
+	PGconn		*conn;
+	PGresult	*res;
+	InstanceTs	*ts;
 
-	if (!do_put(conn, SQL_INSERT_DATABASE, snap->dbnames, snapid, NULL))
-		goto error;
+	if ((conn = collector_connect(NULL)) == NULL)
+		return NULL;
 
-	if (!do_puts(conn, instance_puts, snap->instance, snapid, NULL, NULL))
+	if (conn != instance_ts_conn)
+	{
+		res = PQprepare(conn, INSTANCE_TS_STATEMENT,
+						SQL_SELECT_INSTANCE_TS, 0, NULL);
+		if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		{
+			elog(WARNING, "query failed: %s", PQerrorMessage(conn));
+			PQclear(res);
+			return NULL;
+		}
+		PQclear(res);
+		instance_ts_conn = conn;
+	}
+
+	res = PQexecPrepared(conn, INSTANCE_TS_STATEMENT, 0, NULL, NULL, NULL, 0);
+	if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) != 1)
+	{
+		const char *sqlstate = PQresultErrorField(res, PG_DIAG_SQLSTATE);
+
+		elog(WARNING, "query failed: %s", PQerrorMessage(conn));
+
+		/* prepare again if the connection has been replaced */
+		if (sqlstate != NULL && strcmp(sqlstate, "26000") == 0)
+			instance_ts_conn = NULL;
+		PQclear(res);
+		return NULL;
+	}
+
+	ts = pgut_new(InstanceTs);
+	memset(ts, 0, sizeof(*ts));
+	ts->base.type = QUEUE_INSTANCE_TS;
+	ts->base.free = (QueueItemFree) InstanceTs_free;
+	ts->base.exec = (QueueItemExec) InstanceTs_exec;
+	ts->counters = res;
+
+	return (QueueItem *) ts;
+}
+
+static void
+InstanceTs_free(InstanceTs *ts)
+{
+	if (ts)
+	{
+		PQclear(ts->counters);
+		free(ts);
+	}
+}
+
+/*
+ * InstanceTs_exec - write a mini-snapshot with COPY. The daily partition is
+ * created when the date of the counters changes.
+ */
+static bool
+InstanceTs_exec(InstanceTs *ts, PGconn *conn, const char *instid)
+{
+	const char *timestamp = PQgetvalue(ts->counters, 0, 0);
+
+	if (strncmp(instance_ts_date, timestamp, 10) != 0)
+	{
+		if (pgut_command(conn, SQL_CREATE_INSTANCE_TS_PARTITION,
+						 1, &timestamp) != PGRES_TUPLES_OK)
+			return false;
+		strlcpy(instance_ts_date, timestamp, sizeof(instance_ts_date));
+	}
+
+	/* the instance ID takes the place of the snapshot ID */
+	if (!do_put_copy(conn, SQL_COPY_INSTANCE_TS, ts->counters,
+					 instid, NULL, NULL))
+	{
+		/* the partition may be of another date in the repository */
+		instance_ts_date[0] = '\0';
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * collect_databases - collect per database statistics
+ *
+ * Up to snapshot_parallelism databases are collected at once, each over its
+ * own connection. Queries are sent asynchronously and the results are read
+ * from whichever connection becomes ready first. Every database is retried
+ * DB_MAX_RETRY times as a whole, and results which have been collected
+ * already are kept over the retries.
+ */
+static void
+collect_databases(Snap *snap)
+{
+	int			 ndbs = PQntuples(snap->dbnames);
+	int			 nslots;
+	int			 next = 0;
+	int			 i;
+	DbSlot		*slots;
+	DbResult	*results;
+	PGconn		**conns;
+
+	if (ndbs == 0)
+		return;
+
+	nslots = Min(Max(snapshot_parallelism, 1), ndbs);
+	slots = pgut_newarray(DbSlot, nslots);
+	memset(slots, 0, sizeof(DbSlot) * nslots);
+	results = pgut_newarray(DbResult, ndbs);
+	memset(results, 0, sizeof(DbResult) * ndbs);
+	conns = pgut_newarray(PGconn *, nslots);
+	snap->idle = pgut_newarray(bool, ndbs);
+	memset(snap->idle, 0, sizeof(bool) * ndbs);
+
+	for (i = 0; i < ndbs; i++)
+	{
+		Fingerprint	*fp = get_fingerprint(PQgetvalue(snap->dbnames, i, 0));
+
+		results[i].dbid = fp->dbid;
+
+		/* collect every database at least once a day */
+		if (fp->value != NULL && strncmp(fp->date, snap->start, 10) != 0)
+		{
+			free(fp->value);
+			fp->value = NULL;
+		}
+	}
+
+	for (i = 0; i < nslots; i++)
+	{
+		slots[i].db = -1;
+		slots[i].rotation = snap->rotation;
+		slots[i].stream = snap->stream;
+		slots[i].chunk = (snapshot_chunk_rows > 0 && !snap->stream);
+	}
+
+	for (;;)
+	{
+		int		nactive = 0;
+
+		/* assign databases to idle connections */
+		for (i = 0; i < nslots; i++)
+		{
+			DbSlot	*slot = &slots[i];
+
+			while (slot->db < 0 && next < ndbs &&
+				   shutdown_state < SHUTDOWN_REQUESTED)
+			{
+				const char *db = PQgetvalue(snap->dbnames, next, 1);
+
+				elog(DEBUG2, "snapshot (database=%s)", db);
+				slot->db = next++;
+				slot->step = DB_PREPARE;
+				db_slot_run(slot, &results[slot->db], db);
+			}
+
+			conns[i] = (slot->db >= 0 ? slot->conn : NULL);
+			if (conns[i] != NULL)
+				nactive++;
+		}
+
+		if (nactive == 0)
+			break;	/* all databases are done */
+
+		if ((i = pgut_wait(nslots, conns, NULL)) < 0)
+			break;	/* interrupted */
+
+		if (!db_slot_ready(&slots[i]))
+			continue;	/* the rest of the result has not arrived yet */
+
+		/* move to the next step, or retry the database on failure */
+		if (db_slot_receive(&slots[i], &results[slots[i].db]) ||
+			db_slot_failed(&slots[i], &results[slots[i].db]))
+			db_slot_run(&slots[i], &results[slots[i].db],
+						PQgetvalue(snap->dbnames, slots[i].db, 1));
+	}
+
+	/* append the results in the order of dbnames */
+	for (i = 0; i < ndbs; i++)
+	{
+		List		*dbsnap = results[i].dbsnap;
+		Fingerprint	*fp = get_fingerprint(results[i].dbid);
+		const char	*db = PQgetvalue(snap->dbnames, i, 1);
+
+		destroy_PGresult_list(results[i].pending);
+
+		if (results[i].deferred)
+			budget_skipped(snap, db, "tables", "over budget");
+		if (results[i].column_deferred)
+			budget_skipped(snap, db, "columns", "over budget");
+		if (results[i].index_deferred)
+			budget_skipped(snap, db, "indexes", "over budget");
+		if (results[i].timed_out)
+		{
+			elog(WARNING, "snapshot of database \"%s\" timed out", db);
+			budget_skipped(snap, db, NULL, "timed out");
+		}
+		if (results[i].failed)
+		{
+			elog(WARNING, "snapshot of database \"%s\" failed after %d attempts",
+				 db, results[i].retry);
+			budget_skipped(snap, db, NULL, "failed");
+		}
+
+		/* remember the fingerprint only when the database is collected */
+		if (results[i].idle)
+			snap->idle[i] = true;
+		else
+		{
+			free(fp->value);
+			fp->value = NULL;
+			if (dbsnap != NIL && results[i].fingerprint != NULL)
+			{
+				fp->value = results[i].fingerprint;
+				results[i].fingerprint = NULL;
+				strlcpy(fp->date, snap->start, sizeof(fp->date));
+			}
+		}
+		free(results[i].fingerprint);
+
+		/*
+		 * keep the position of the streamed table statistics, which is
+		 * DATABASE_GETS_TABLE right after the schemas
+		 */
+		if (snap->stream && dbsnap != NIL)
+		{
+			PGresult   *schema = (PGresult *) linitial(dbsnap);
+
+			dbsnap = lcons(schema, lcons(NULL, list_delete_first(dbsnap)));
+		}
+
+		/* if collect_column is disabled, column is null */
+		dbsnap = lappend(dbsnap, results[i].column);
+
+		/* if collect_index is disabled, index is null */
+		dbsnap = lappend(dbsnap, results[i].index);
+
+		snap->dbsnaps = lappend(snap->dbsnaps, dbsnap);
+	}
+
+	/* the connections left by an interruption */
+	for (i = 0; i < nslots; i++)
+	{
+		PQclear(slots[i].res);
+		collector_pool_release(slots[i].conn);
+	}
+
+	if (slots[0].chunk)
+		collect_chunks(snap, results);
+
+	for (i = 0; i < ndbs; i++)
+		free(results[i].leaves);
+	free(slots);
+	free(results);
+	free(conns);
+}
+
+/*
+ * db_slot_run - send the next query of the database, connecting to it if
+ * needed. The slot becomes idle when the database is done or given up.
+ */
+static void
+db_slot_run(DbSlot *slot, DbResult *result, const char *db)
+{
+	while (slot->db >= 0)
+	{
+		/* (re)connect at the beginning of every attempt */
+		if (slot->step == DB_PREPARE && !db_slot_connect(slot, result, db))
+		{
+			if (!db_slot_failed(slot, result))
+				return;
+			continue;
+		}
+
+		if (db_slot_send(slot, result))
+			return;	/* wait for the result */
+
+		if (slot->step == DB_DONE)
+		{
+			collector_pool_release(slot->conn);
+			slot->conn = NULL;
+			slot->db = -1;
+			return;
+		}
+
+		if (!db_slot_failed(slot, result))
+			return;
+	}
+}
+
+/*
+ * db_slot_connect - connect to the database, unless it is left to the last
+ * collected statistics for the budget.
+ */
+static bool
+db_slot_connect(DbSlot *slot, DbResult *result, const char *db)
+{
+	/* refer to the last collected statistics when over the budget */
+	if (result->dbsnap == NIL && budget_exceeded())
+	{
+		result->idle = true;
+		result->deferred = true;
+		return true;
+	}
+
+	/* a retry keeps the connection to the database */
+	if (slot->conn == NULL && (slot->conn = collector_pool_get(db)) == NULL)
+		return false;
+
+	return true;
+}
+
+/*
+ * db_slot_prepared - decide the queries of the database with the result of
+ * SQL_SELECT_DB_PREPARE. The database is skipped if its fingerprint is the
+ * same as the one when it was collected last.
+ */
+static void
+db_slot_prepared(DbSlot *slot, DbResult *result, PGresult *res)
+{
+	Fingerprint *fp = get_fingerprint(result->dbid);
+
+	free(result->fingerprint);
+	result->fingerprint = NULL;
+	if (!PQgetisnull(res, 0, 1))
+		result->fingerprint = pgut_strdup(PQgetvalue(res, 0, 1));
+
+	/* the leaves are kept through the retries of the database */
+	if (result->leaves == NULL && !PQgetisnull(res, 0, 5))
+		result->leaves = pgut_strdup(PQgetvalue(res, 0, 5));
+
+	result->idle = (result->fingerprint != NULL && fp->value != NULL &&
+					strcmp(result->fingerprint, fp->value) == 0);
+	if (result->idle)
+	{
+		elog(DEBUG2, "snapshot (database=%s is idle)", PQdb(slot->conn));
+		return;
+	}
+
+	slot->step = DB_BEGIN;
+
+	/* tables, columns and indexes are streamed by the writer */
+	if (slot->stream)
+	{
+		slot->gets = database_stream_gets;
+		slot->collect_column = false;
+		slot->collect_index = false;
+		return;
+	}
+
+	slot->collect_column = (strcmp(PQgetvalue(res, 0, 3), "t") == 0);
+	slot->collect_index = (strcmp(PQgetvalue(res, 0, 4), "t") == 0);
+
+	/* columns and indexes are read in chunks by collect_chunks() */
+	if (slot->chunk)
+	{
+		result->chunk_column = slot->collect_column;
+		result->chunk_index = slot->collect_index;
+		slot->collect_column = false;
+		slot->collect_index = false;
+	}
+
+	/* whether the functions of has_relation_stats() are installed */
+	slot->gets = relation_queries(strcmp(PQgetvalue(res, 0, 2), "t") == 0,
+								  &slot->sql_column, &slot->sql_index);
+}
+
+/*
+ * current_ms - milliseconds since the epoch
+ */
+static int64
+current_ms(void)
+{
+	struct timeval	tv;
+
+	gettimeofday(&tv, NULL);
+	return (int64) tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+/*
+ * budget_exceeded - return true if the snapshot has used up snapshot_budget
+ */
+static bool
+budget_exceeded(void)
+{
+	return snapshot_deadline > 0 && current_ms() >= snapshot_deadline;
+}
+
+/*
+ * budget_timeout - format the rest of the budget as statement_timeout, or
+ * return NULL if there is no budget.
+ */
+static const char *
+budget_timeout(char *timeout, size_t size)
+{
+	if (snapshot_deadline <= 0)
+		return NULL;
+
+	snprintf(timeout, size, INT64_FORMAT,
+			 Max(snapshot_deadline - current_ms(), 1));
+	return timeout;
+}
+
+/*
+ * budget_set_timeout - limit the statements on the connection to the rest of
+ * the budget. Returns true if statement_timeout has been set.
+ */
+static bool
+budget_set_timeout(PGconn *conn)
+{
+	char		timeout[32];
+	const char *params[1];
+
+	if ((params[0] = budget_timeout(timeout, sizeof(timeout))) == NULL)
+		return false;
+
+	return pgut_command(conn,
+		"SELECT pg_catalog.set_config('statement_timeout', $1, false)",
+		1, params) == PGRES_TUPLES_OK;
+}
+
+/*
+ * budget_skipped - record a stage skipped for snapshot_budget, such as
+ * "db01 columns: over budget".
+ */
+static void
+budget_skipped(Snap *snap, const char *db, const char *stage,
+			   const char *reason)
+{
+	/* lightweight snapshots skip them by design */
+	if (snap->escalation != NULL)
+		return;
+
+	if (snap->skipped.len > 0)
+		appendStringInfoString(&snap->skipped, ", ");
+	if (db != NULL)
+		appendStringInfoString(&snap->skipped, db);
+	if (db != NULL && stage != NULL)
+		appendStringInfoChar(&snap->skipped, ' ');
+	if (stage != NULL)
+		appendStringInfoString(&snap->skipped, stage);
+	appendStringInfo(&snap->skipped, ": %s", reason);
+}
+
+/*
+ * get_fingerprint - return the fingerprint entry of the database
+ */
+static Fingerprint *
+get_fingerprint(const char *dbid)
+{
+	ListCell	*cell;
+	Fingerprint	*fp;
+
+	foreach(cell, fingerprints)
+	{
+		fp = (Fingerprint *) lfirst(cell);
+		if (strcmp(fp->dbid, dbid) == 0)
+			return fp;
+	}
+
+	fp = pgut_new(Fingerprint);
+	memset(fp, 0, sizeof(*fp));
+	fp->dbid = pgut_strdup(dbid);
+	fingerprints = lappend(fingerprints, fp);
+
+	return fp;
+}
+
+/*
+ * statement_counters_params - build the array literals of the counters of the
+ * statements collected last, which are parameters $4 .. $10 of
+ * SQL_SELECT_STATEMENT. They are empty to collect all of the statements when
+ * stat_statements_delta is off, and at the first snapshot of a day.
+ */
+static void
+statement_counters_params(const char *start, StringInfo arrays)
+{
+	int		i;
+
+	pthread_mutex_lock(&stmt_counters_lock);
+	if (!stat_statements_delta ||
+		strncmp(stmt_counters_date, start, 10) != 0)
+	{
+		free(stmt_counters);
+		stmt_counters = NULL;
+		stmt_ncounters = 0;
+		strlcpy(stmt_counters_date, start, sizeof(stmt_counters_date));
+	}
+
+	for (i = 0; i < 7; i++)
+	{
+		initStringInfo(&arrays[i]);
+		appendStringInfoChar(&arrays[i], '{');
+	}
+
+	for (i = 0; i < stmt_ncounters; i++)
+	{
+		StatementCounter   *c = &stmt_counters[i];
+		const char		   *sep = (i > 0 ? "," : "");
+
+		appendStringInfo(&arrays[0], "%s%u", sep, c->dbid);
+		appendStringInfo(&arrays[1], "%s%u", sep, c->userid);
+		appendStringInfo(&arrays[2], "%s" INT64_FORMAT, sep, c->queryid);
+		appendStringInfo(&arrays[3], "%s%s", sep, c->toplevel ? "t" : "f");
+		appendStringInfo(&arrays[4], "%s" INT64_FORMAT, sep, c->calls);
+		appendStringInfo(&arrays[5], "%s%s", sep, c->total_exec_time);
+		appendStringInfo(&arrays[6], "%s" INT64_FORMAT, sep, c->io);
+	}
+	pthread_mutex_unlock(&stmt_counters_lock);
+
+	for (i = 0; i < 7; i++)
+		appendStringInfoChar(&arrays[i], '}');
+}
+
+/*
+ * statement_counters_update - remember the counters of the statements written
+ * into the repository. The statements not collected this time keep their
+ * counters, so that they are collected when they are in the top ones later.
+ * Called by the writer after the snapshot has committed.
+ */
+static void
+statement_counters_update(PGresult *res, const char *start)
+{
+	int		nrows = PQntuples(res);
+	int		nsorted;
+	int		i;
+
+	if (!stat_statements_delta || nrows == 0)
+		return;
+
+	pthread_mutex_lock(&stmt_counters_lock);
+
+	/* the counters have been reset for a new day since the collection */
+	if (strncmp(stmt_counters_date, start, 10) != 0)
+	{
+		pthread_mutex_unlock(&stmt_counters_lock);
+		return;
+	}
+
+	nsorted = stmt_ncounters;
+
+	stmt_counters = pgut_realloc(stmt_counters,
+		sizeof(StatementCounter) * (stmt_ncounters + nrows));
+
+	for (i = 0; i < nrows; i++)
+	{
+		StatementCounter	key;
+		StatementCounter   *c;
+		int64				io;
+		int					j;
+		/* shared, local and temp blocks read and written */
+		static const int	io_cols[] = {10, 12, 14, 16, 17, 18};
+
+		memset(&key, 0, sizeof(key));
+		parse_uint32(PQgetvalue(res, i, 0), &key.dbid);
+		parse_uint32(PQgetvalue(res, i, 1), &key.userid);
+		parse_int64(PQgetvalue(res, i, 2), &key.queryid);
+		parse_bool(PQgetvalue(res, i, 25), &key.toplevel);
+
+		c = bsearch(&key, stmt_counters, nsorted,
+					sizeof(StatementCounter), statement_counter_cmp);
+		if (c == NULL)
+		{
+			c = &stmt_counters[stmt_ncounters++];
+			*c = key;
+		}
+
+		parse_int64(PQgetvalue(res, i, 6), &c->calls);
+		strlcpy(c->total_exec_time, PQgetvalue(res, i, 7),
+				sizeof(c->total_exec_time));
+		c->io = 0;
+		for (j = 0; j < lengthof(io_cols); j++)
+		{
+			if (parse_int64(PQgetvalue(res, i, io_cols[j]), &io))
+				c->io += io;
+		}
+	}
+
+	if (stmt_ncounters > nsorted)
+		qsort(stmt_counters, stmt_ncounters,
+			  sizeof(StatementCounter), statement_counter_cmp);
+	pthread_mutex_unlock(&stmt_counters_lock);
+}
+
+static int
+statement_counter_cmp(const void *a, const void *b)
+{
+	const StatementCounter *ca = (const StatementCounter *) a;
+	const StatementCounter *cb = (const StatementCounter *) b;
+
+	if (ca->dbid != cb->dbid)
+		return ca->dbid < cb->dbid ? -1 : 1;
+	if (ca->userid != cb->userid)
+		return ca->userid < cb->userid ? -1 : 1;
+	if (ca->queryid != cb->queryid)
+		return ca->queryid < cb->queryid ? -1 : 1;
+	if (ca->toplevel != cb->toplevel)
+		return ca->toplevel ? 1 : -1;
+	return 0;
+}
+
+/*
+ * known_plans_params - build the array literals of the plans whose texts are
+ * known to be in the repository, which are parameters $3 and $4 of
+ * SQL_SELECT_PLAN. Only the plans referred to by the snapshots of the same
+ * day are used, because the texts not referred to are deleted by the
+ * maintenance.
+ */
+static void
+known_plans_params(const char *start, StringInfo planids, StringInfo hashes)
+{
+	int		i;
+	bool	first = true;
+
+	initStringInfo(planids);
+	initStringInfo(hashes);
+	appendStringInfoChar(planids, '{');
+	appendStringInfoChar(hashes, '{');
+
+	pthread_mutex_lock(&known_plans_lock);
+	for (i = 0; i < nknown_plans; i++)
+	{
+		if (strncmp(known_plans[i].date, start, 10) != 0)
+			continue;
+
+		appendStringInfo(planids, "%s" INT64_FORMAT,
+						 first ? "" : ",", known_plans[i].planid);
+		appendStringInfo(hashes, "%s" INT64_FORMAT,
+						 first ? "" : ",", known_plans[i].hash);
+		first = false;
+	}
+	pthread_mutex_unlock(&known_plans_lock);
+
+	appendStringInfoChar(planids, '}');
+	appendStringInfoChar(hashes, '}');
+}
+
+/*
+ * known_plans_add - remember the plans in the committed snapshot. The least
+ * recently used one is replaced when known_plans is full.
+ */
+static void
+known_plans_add(PGresult *res, const char *start)
+{
+	int		rows = PQntuples(res);
+	int		r;
+
+	pthread_mutex_lock(&known_plans_lock);
+	for (r = 0; r < rows; r++)
+	{
+		KnownPlan  *plan = NULL;
+		int64		planid;
+		int64		hash;
+		int			i;
+
+		if (!parse_int64(PQgetvalue(res, r, 3), &planid) ||
+			!parse_int64(PQgetvalue(res, r, 4), &hash))
+			continue;
+
+		for (i = 0; i < nknown_plans; i++)
+		{
+			if (known_plans[i].planid == planid && known_plans[i].hash == hash)
+			{
+				plan = &known_plans[i];
+				break;
+			}
+		}
+
+		if (plan == NULL && nknown_plans < KNOWN_PLANS_MAX)
+			plan = &known_plans[nknown_plans++];
+		else if (plan == NULL)
+		{
+			plan = &known_plans[0];
+			for (i = 1; i < nknown_plans; i++)
+			{
+				if (known_plans[i].used < plan->used)
+					plan = &known_plans[i];
+			}
+		}
+
+		plan->planid = planid;
+		plan->hash = hash;
+		strlcpy(plan->date, start, sizeof(plan->date));
+		plan->used = ++known_plans_clock;
+	}
+	pthread_mutex_unlock(&known_plans_lock);
+}
+
+/*
+ * partition_rollup_enabled - true if some leaf partitions are rolled up
+ */
+static bool
+partition_rollup_enabled(void)
+{
+	return (partition_rollup && partition_rollup[0]);
+}
+
+/*
+ * relation_queries - choose the queries for tables, columns and indexes.
+ * 'bulk' tells whether the functions of has_relation_stats() are
+ * installed. Returns the database_gets to use, whose query for tables is at
+ * DATABASE_GETS_TABLE.
+ */
+static const char **
+relation_queries(bool bulk, const char **sql_column, const char **sql_index)
+{
+	if (partition_rollup_enabled())
+	{
+		*sql_column = SQL_SELECT_COLUMN_ROLLUP(SQL_SELECT_COLUMN);
+		*sql_index = bulk ? SQL_SELECT_INDEX_ROLLUP(SQL_SELECT_INDEX_BULK)
+						  : SQL_SELECT_INDEX_ROLLUP(SQL_SELECT_INDEX);
+		return bulk ? database_bulk_rollup_gets : database_rollup_gets;
+	}
+	else
+	{
+		*sql_column = SQL_SELECT_COLUMN;
+		*sql_index = bulk ? SQL_SELECT_INDEX_BULK : SQL_SELECT_INDEX;
+		return bulk ? database_bulk_gets : database_gets;
+	}
+}
+
+/*
+ * probe_collect - check whether column and index statistics are collected
+ */
+static void
+probe_collect(PGconn *conn, bool *collect_column, bool *collect_index)
+{
+	PipelineQuery	queries[2];
+	int				nqueries = 0;
+
+	pipeline_add(queries, &nqueries, SQL_PROBE_COLLECT_COLUMN, 0, NULL, false);
+	pipeline_add(queries, &nqueries, SQL_PROBE_COLLECT_INDEX, 0, NULL, false);
+	do_pipeline(conn, queries, nqueries);
+
+	*collect_column = (queries[0].res && PQntuples(queries[0].res) > 0);
+	*collect_index = (queries[1].res && PQntuples(queries[1].res) > 0);
+	PQclear(queries[0].res);
+	PQclear(queries[1].res);
+}
+
+/*
+ * db_slot_send - send the query of the current step. Steps which have been
+ * done in the previous attempts are skipped. Returns false if there is
+ * nothing to send or the query could not be sent.
+ */
+static bool
+db_slot_send(DbSlot *slot, DbResult *result)
+{
+	const char *params[] = {excluded_schemas, slot->rotation};
+	const char *prepare[5];
+	char		timeout[32];
+
+	if (result->idle)
+		slot->step = DB_DONE;
+	if (slot->step == DB_BEGIN && result->dbsnap != NIL)
+		slot->step = DB_COLUMN;
+	if (slot->step == DB_COLUMN && slot->collect_column && !result->column &&
+		budget_exceeded())
+	{
+		result->column_deferred = true;
+		slot->step = DB_INDEX;
+	}
+	if (slot->step == DB_COLUMN && (!slot->collect_column || result->column))
+		slot->step = DB_INDEX;
+	if (slot->step == DB_INDEX && slot->collect_index && !result->index &&
+		budget_exceeded())
+	{
+		result->index_deferred = true;
+		slot->step = DB_DONE;
+	}
+	if (slot->step == DB_INDEX && (!slot->collect_index || result->index))
+		slot->step = DB_DONE;
+
+	switch (slot->step)
+	{
+		case DB_PREPARE:
+			prepare[0] = excluded_schemas;
+			prepare[1] = budget_timeout(timeout, sizeof(timeout));
+			prepare[2] = (snapshot_skip_idle ? "true" : "false");
+			prepare[3] = (partition_rollup_enabled() ? "true" : "false");
+			prepare[4] = result->leaves;
+			return pgut_send(slot->conn, SQL_SELECT_DB_PREPARE, 5, prepare);
+		case DB_BEGIN:
+			return pgut_send(slot->conn, "BEGIN", 0, NULL);
+		case DB_GETS:
+			return pgut_send(slot->conn, slot->gets[slot->nget], 1, params);
+		case DB_COMMIT:
+			return pgut_send(slot->conn, "COMMIT", 0, NULL);
+		case DB_COLUMN:
+			return pgut_send(slot->conn, slot->sql_column, 2, params);
+		case DB_INDEX:
+			return pgut_send(slot->conn, slot->sql_index, 1, params);
+		default:
+			return false;
+	}
+}
+
+/*
+ * db_slot_ready - read the results of the current step which have arrived,
+ * without blocking. Returns true when the step has completed, or the
+ * connection is broken. The first result is kept, or the first error if a
+ * statement of the step has failed.
+ */
+static bool
+db_slot_ready(DbSlot *slot)
+{
+	PGresult   *res;
+
+	if (!PQconsumeInput(slot->conn))
+		return true;	/* db_slot_receive() reports it */
+
+	while (!PQisBusy(slot->conn))
+	{
+		if ((res = PQgetResult(slot->conn)) == NULL)
+			return true;
+
+		if (slot->res == NULL ||
+			(PQresultStatus(res) == PGRES_FATAL_ERROR &&
+			 PQresultStatus(slot->res) != PGRES_FATAL_ERROR))
+		{
+			PQclear(slot->res);
+			slot->res = res;
+		}
+		else
+			PQclear(res);
+	}
+
+	return false;
+}
+
+/*
+ * db_slot_receive - take the result of the current step read by
+ * db_slot_ready() and move to the next step. Returns false if the query
+ * failed.
+ */
+static bool
+db_slot_receive(DbSlot *slot, DbResult *result)
+{
+	PGresult	*res = slot->res;
+	bool		 ok;
+
+	slot->res = NULL;
+
+	switch (slot->step)
+	{
+		case DB_BEGIN:
+		case DB_COMMIT:
+			ok = (PQresultStatus(res) == PGRES_COMMAND_OK);
+			break;
+		default:
+			ok = (PQresultStatus(res) == PGRES_TUPLES_OK);
+			break;
+	}
+
+	if (!ok)
+	{
+		const char *sqlstate = PQresultErrorField(res, PG_DIAG_SQLSTATE);
+
+		elog(ERROR, "query failed: %s", PQerrorMessage(slot->conn));
+
+		/* canceled by statement_timeout for the budget */
+		result->canceled = (sqlstate != NULL && strcmp(sqlstate, "57014") == 0);
+		PQclear(res);
+		return false;
+	}
+
+	switch (slot->step)
+	{
+		case DB_PREPARE:
+			db_slot_prepared(slot, result, res);
+			PQclear(res);
+			break;
+		case DB_BEGIN:
+			PQclear(res);
+			slot->nget = 0;
+			slot->step = (slot->gets[0] ? DB_GETS : DB_COMMIT);
+			break;
+		case DB_GETS:
+			result->pending = lappend(result->pending, res);
+			if (slot->gets[++slot->nget] == NULL)
+				slot->step = DB_COMMIT;
+			break;
+		case DB_COMMIT:
+			PQclear(res);
+			result->dbsnap = result->pending;
+			result->pending = NIL;
+			slot->step = DB_COLUMN;
+			break;
+		case DB_COLUMN:
+			result->column = res;
+			slot->step = DB_INDEX;
+			break;
+		case DB_INDEX:
+			result->index = res;
+			slot->step = DB_DONE;
+			break;
+		default:
+			PQclear(res);
+			break;
+	}
+
+	return true;
+}
+
+/*
+ * db_slot_failed - discard the current attempt of the database. Returns true
+ * if the database should be retried, or false if it has been given up.
+ */
+static bool
+db_slot_failed(DbSlot *slot, DbResult *result)
+{
+	bool		canceled = result->canceled;
+
+	result->canceled = false;
+	destroy_PGresult_list(result->pending);
+	result->pending = NIL;
+
+	if (PQstatus(slot->conn) == CONNECTION_OK)
+		pgut_rollback(slot->conn);
+	else
+	{
+		collector_pool_release(slot->conn);
+		slot->conn = NULL;
+	}
+
+	slot->step = DB_PREPARE;
+	slot->nget = 0;
+
+	/*
+	 * no retry after the budget is used up. The attempt has timed out only
+	 * when statement_timeout canceled it; otherwise it is an error.
+	 */
+	if (budget_exceeded())
+	{
+		if (canceled)
+			result->timed_out = true;
+		else
+		{
+			result->retry++;
+			result->failed = true;
+		}
+	}
+	else if (++result->retry < DB_MAX_RETRY &&
+			 shutdown_state < SHUTDOWN_REQUESTED)
+	{
+		delay();
+		return true;
+	}
+	else if (shutdown_state < SHUTDOWN_REQUESTED)
+		result->failed = true;
+
+	collector_pool_release(slot->conn);
+	slot->conn = NULL;
+	slot->db = -1;
+	return false;
+}
+
+/*
+ * collect_chunks - read the column and index statistics of the databases
+ * snapshot_chunk_rows at a time, and spill them into temporary files which
+ * the writer copies into the repository. Statistics which could not be read
+ * are recorded in snapshot.skipped.
+ */
+static void
+collect_chunks(Snap *snap, DbResult *results)
+{
+	int			ndbs = PQntuples(snap->dbnames);
+	int			i;
+
+	for (i = 0; i < ndbs && shutdown_state < SHUTDOWN_REQUESTED; i++)
+	{
+		const char *db = PQgetvalue(snap->dbnames, i, 1);
+
+		/* skip databases which have been given up */
+		if (results[i].dbsnap == NIL)
+			continue;
+
+		elog(DEBUG2, "snapshot (chunks database=%s)", db);
+		if (results[i].chunk_column && budget_exceeded())
+			budget_skipped(snap, db, "columns", "over budget");
+		else if (results[i].chunk_column &&
+				 !collect_chunk_rows(snap, i, results[i].leaves,
+									 SQL_COPY_COLUMN))
+			budget_skipped(snap, db, "columns", "failed");
+		if (results[i].chunk_index && budget_exceeded())
+			budget_skipped(snap, db, "indexes", "over budget");
+		else if (results[i].chunk_index &&
+				 !collect_chunk_rows(snap, i, results[i].leaves,
+									 SQL_COPY_INDEX))
+			budget_skipped(snap, db, "indexes", "failed");
+	}
+}
+
+/*
+ * collect_chunk_rows - read column or index statistics of the database in
+ * chunked rows mode into a new Spill of the snapshot. 'leaves' are the
+ * partitions rolled up by the tables of the database. Returns false if the
+ * rows could not be read.
+ */
+static bool
+collect_chunk_rows(Snap *snap, int db, const char *leaves,
+				   const char *copy_sql)
+{
+	const char *dbname = PQgetvalue(snap->dbnames, db, 1);
+	const char *params[] = {excluded_schemas, snap->rotation};
+	const char *leaves_params[] = {leaves};
+	bool		column = (strcmp(copy_sql, SQL_COPY_COLUMN) == 0);
+	int			retry;
+
+	for (retry = 0;
+		 shutdown_state < SHUTDOWN_REQUESTED && retry < DB_MAX_RETRY &&
+		 (retry == 0 || !budget_exceeded());
+		 delay(), retry++)
+	{
+		PGconn	   *conn;
+		PGresult   *res;
+		FILE	   *file;
+		Spill	   *spill;
+		const char *sql_column;
+		const char *sql_index;
+
+		if ((conn = collector_pool_get(dbname)) == NULL)
+			continue;
+		budget_set_timeout(conn);
+
+		relation_queries(has_relation_stats(conn), &sql_column, &sql_index);
+		if (leaves != NULL &&
+			(res = do_get(conn, SQL_SET_ROLLUP_LEAVES, 1, leaves_params)) == NULL)
+		{
+			collector_pool_release(conn);
+			continue;
+		}
+		PQclear(res);
+		file = spill_query(conn, column ? sql_column : sql_index,
+						   column ? 2 : 1, params, snapshot_chunk_rows);
+		collector_pool_release(conn);
+		if (file == NULL)
+			continue;
+
+		spill = pgut_new(Spill);
+		spill->db = db;
+		spill->sql = copy_sql;
+		spill->file = file;
+		spill->streamed = NULL;
+		snap->spills = lappend(snap->spills, spill);
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ * spill_query - read the rows of the query in chunked rows mode into a new
+ * temporary file. Returns the file, or NULL if the rows could not be read.
+ */
+static FILE *
+spill_query(PGconn *conn, const char *sql, int nParams, const char **params,
+			int chunk_rows)
+{
+	PGresult   *res;
+	FILE	   *file;
+	bool		ok = true;
+
+	if ((file = tmpfile()) == NULL)
+	{
+		elog(ERROR, "could not create a temporary file: %s", strerror(errno));
+		return NULL;
+	}
+
+	if (!pgut_send(conn, sql, nParams, params))
+	{
+		fclose(file);
+		return NULL;
+	}
+	if (PQsetChunkedRowsMode(conn, chunk_rows) != 1)
+		ok = false;
+
+	while ((res = PQgetResult(conn)) != NULL)
+	{
+		switch (PQresultStatus(res))
+		{
+			case PGRES_TUPLES_CHUNK:
+			case PGRES_TUPLES_OK:
+				/* read the rest and discard them after a failure */
+				if (ok && !spill_rows(file, res))
+				{
+					elog(ERROR, "could not write to a temporary file: %s",
+						 strerror(errno));
+					ok = false;
+				}
+				break;
+			default:
+				elog(ERROR, "query failed: %s", PQerrorMessage(conn));
+				ok = false;
+				break;
+		}
+		PQclear(res);
+	}
+
+	if (!ok || fflush(file) != 0)
+	{
+		fclose(file);
+		return NULL;
+	}
+
+	return file;
+}
+
+/*
+ * spill_rows - append the rows to the file in the text COPY format. Strings
+ * are escaped in the same way as do_put_copy().
+ */
+static bool
+spill_rows(FILE *file, PGresult *res)
+{
+	int		rows = PQntuples(res);
+	int		cols = PQnfields(res);
+	int		r;
+	int		c;
+
+	for (r = 0; r < rows; r++)
+	{
+		for (c = 0; c < cols; c++)
+		{
+			const char *p;
+
+			if (c > 0)
+				fputs(COPY_DELIMITER, file);
+
+			if (PQgetisnull(res, r, c))
+			{
+				fputs(NULL_STR, file);
+				continue;
+			}
+
+			p = PQgetvalue(res, r, c);
+			if (PQftype(res, c) != TEXTOID && PQftype(res, c) != NAMEOID)
+			{
+				fputs(p, file);
+				continue;
+			}
+
+			for (; *p != '\0'; p++)
+			{
+				switch (*p)
+				{
+					case '\b':
+						fputs("\\b", file);
+						break;
+					case '\f':
+						fputs("\\f", file);
+						break;
+					case '\n':
+						fputs("\\n", file);
+						break;
+					case '\r':
+						fputs("\\r", file);
+						break;
+					case '\t':
+						fputs("\\t", file);
+						break;
+					case '\v':
+						fputs("\\v", file);
+						break;
+					case '\\':
+						fputs("\\\\", file);
+						break;
+					default:
+						fputc(*p, file);
+						break;
+				}
+			}
+		}
+		fputc('\n', file);
+	}
+
+	return !ferror(file);
+}
+
+/*
+ * spill_read_line - read a line of the spilled rows, including the newline.
+ * Returns false at the end of the file.
+ */
+static bool
+spill_read_line(FILE *file, StringInfo line)
+{
+	char	buf[8192];
+
+	resetStringInfo(line);
+	while (fgets(buf, sizeof(buf), file) != NULL)
+	{
+		appendStringInfoString(line, buf);
+		if (line->data[line->len - 1] == '\n')
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * write_spill - copy the spilled rows into the repository, adding snapid,
+ * dbid and snap_date to each of them. The file is read from the beginning,
+ * so the rows are written again when the snapshot is retried.
+ */
+static bool
+write_spill(PGconn *conn,
+			Spill *spill,
+			const char *snapid,
+			const char *dbid,
+			const char *snap_date)
+{
+	StringInfoData	line;
+	StringInfoData	buf;
+	PGresult	   *res;
+	int				chunk_size;
+	bool			ok = true;
+
+	rewind(spill->file);
+
+	res = pgut_execute(conn, spill->sql, 0, NULL);
+	if (PQresultStatus(res) != PGRES_COPY_IN)
+	{
+		PQclear(res);
+		return false;
+	}
+	PQclear(res);
+
+	initStringInfo(&line);
+	initStringInfo(&buf);
+	chunk_size = Max(copy_chunk_size, 1) * 1024;
+	while (ok && spill_read_line(spill->file, &line))
+	{
+		const char *p = line.data;
+		int			c;
+
+		/* insert snap_date before the field at the partition key position */
+		for (c = 0; c < PART_KEY_POSITION && p != NULL; c++)
+		{
+			if ((p = strchr(p, '\t')) != NULL)
+				p++;
+		}
+		if (p == NULL)
+		{
+			elog(WARNING, "malformed row in the spilled rows");
+			ok = false;
+			break;
+		}
+
+		appendStringInfo(&buf, "%s" COPY_DELIMITER "%s" COPY_DELIMITER,
+						 snapid, dbid);
+		appendBinaryStringInfo(&buf, line.data, p - line.data);
+		appendStringInfo(&buf, "%s" COPY_DELIMITER "%s", snap_date, p);
+
+		if (buf.len >= chunk_size)
+		{
+			if (PQputCopyData(conn, buf.data, buf.len) != 1)
+				ok = false;
+			resetStringInfo(&buf);
+		}
+	}
+	if (ok && ferror(spill->file))
+	{
+		elog(WARNING, "could not read the spilled rows: %s", strerror(errno));
+		ok = false;
+	}
+	if (ok && buf.len > 0 && PQputCopyData(conn, buf.data, buf.len) != 1)
+		ok = false;
+	termStringInfo(&line);
+	termStringInfo(&buf);
+
+	if (PQputCopyEnd(conn, ok ? NULL : "could not read the spilled rows") != 1)
+		ok = false;
+
+	/* the result of the COPY */
+	while ((res = PQgetResult(conn)) != NULL)
+	{
+		if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		{
+			if (ok)
+				elog(WARNING, "COPY failed: %s", PQerrorMessage(conn));
+			ok = false;
+		}
+		PQclear(res);
+	}
+
+	return ok;
+}
+
+static void
+destroy_PGresult_list(List *list)
+{
+	list_destroy(list, PQclear);
+}
+
+static void
+Snap_free(Snap *snap)
+{
+	ListCell   *cell;
+
+	if (snap)
+	{
+		free(snap->comment);
+		PQclear(snap->dbnames);
+		destroy_PGresult_list(snap->instance);
+		list_destroy(snap->dbsnaps, destroy_PGresult_list);
+		foreach(cell, snap->spills)
+		{
+			Spill  *spill = (Spill *) lfirst(cell);
+
+			fclose(spill->file);
+			free(spill->streamed);
+			free(spill);
+		}
+		list_free(snap->spills);
+		if (snap->start != NULL)
+			free(snap->start);
+		free(snap->idle);
+		termStringInfo(&snap->skipped);
+		free(snap->escalation);
+		free(snap);
+	}
+}
+
+/*
+ * insert statstics into the repository server
+ */
+static bool
+Snap_exec(Snap *snap, PGconn *conn, const char *instid)
+{
+	PGresult   *snapid_date_res = NULL;
+	const char *params[10];
+	char		pool[3][32];
+	const char *snapid;
+	const char *snap_date;
+	ListCell   *db;
+	int			i;
+	PGresult   *repo_size = NULL;
+	PGresult   *alerts = NULL;
+	PGresult   *update_res = NULL;
+	char	   *end = NULL;
+
+	elog(DEBUG2, "write (snapshot)");
+
+	/*
+	 * Read the streamed relation statistics before taking the write slot and
+	 * the instance lock, so that reading the databases does not hold them.
+	 */
+	if (snap->stream && !snap->streamed)
+	{
+		List	   *spills = NIL;
+		ListCell   *cell;
+
+		i = 0;
+		foreach(db, snap->dbsnaps)
+		{
+			List   *dbsnap = (List *) lfirst(db);
+
+			if (dbsnap != NIL && linitial(dbsnap) != NULL &&
+				!stream_relations(snap, i, &spills))
+			{
+				foreach(cell, spills)
+				{
+					Spill  *spill = (Spill *) lfirst(cell);
+
+					fclose(spill->file);
+					free(spill->streamed);
+					free(spill);
+				}
+				list_free(spills);
+				return false;
+			}
+			i++;
+		}
+		snap->spills = list_concat(snap->spills, spills);
+		snap->streamed = true;
+	}
+
+	/*
+	 * create partition tables
+	 */
+	params[0] = snap->start;
+	if (pgut_command(conn,
+		SQL_CREATE_SNAPSHOT_PARTITION, 1, params) != PGRES_TUPLES_OK)
+		goto error;
+	if (pgut_command(conn,
+		SQL_CREATE_REPOLOG_PARTITION, 1, params) != PGRES_TUPLES_OK)
+		goto error;
+
+	if (pgut_command(conn, "BEGIN", 0, NULL) != PGRES_COMMAND_OK)
+		goto error;
+
+	/* take turns with the other agents sharing the repository */
+	if (repository_write_slots > 0 && !acquire_write_slot(conn, instid))
+		goto error;
+
+	/* exclusive control for don't run concurrently with the maintenance */
+	if (pgut_command(conn,
+		"LOCK TABLE statsrepo.instance IN SHARE MODE", 0, NULL) != PGRES_COMMAND_OK)
+		goto error;
+
+	/*
+	 * get statsrepo schema relation total size
+	 */
+	repo_size = do_get(conn, SQL_SELECT_REPOSIZE, 0, NULL);
+	if (repo_size == NULL)
+		goto error;
+
+	params[0] = instid;
+	params[1] = snap->start;
+	params[2] = snap->comment;
+	snapid_date_res = pgut_execute(conn, SQL_NEW_SNAPSHOT, 3, params);
+	if (PQntuples(snapid_date_res) == 0 || PQnfields(snapid_date_res) != 2)
+		goto error;
+
+	snapid = PQgetvalue(snapid_date_res, 0, 0);
+	snap_date = PQgetvalue(snapid_date_res, 0, 1);
+
+	if (!do_put(conn, SQL_INSERT_DATABASE, snap->dbnames, snapid, NULL))
+		goto error;
+
+	query_text_expire(snap->start);
+	if (!do_puts(conn, instance_puts, snap->instance, snapid, NULL, NULL))
 		goto error;
 
 	i = 0;
@@ -507,12 +2432,44 @@ Snap_exec(Snap *snap, PGconn *conn, const char *instid)
 	{
 		List	   *dbsnap = (List*) lfirst(db);
 		const char *dbid = PQgetvalue(snap->dbnames, i ,0);
+		const char *carried[2];
+
+		/* refer to the statistics of the last collected snapshot */
+		if (snap->idle[i])
+		{
+			carried[0] = snapid;
+			carried[1] = dbid;
+			if (pgut_command(conn, SQL_UPDATE_DATABASE_CARRIED,
+							 2, carried) != PGRES_COMMAND_OK)
+				goto error;
+		}
 
 		if (!do_puts(conn, database_puts, dbsnap, snapid, dbid, snap_date))
 			goto error;
 		i++;
 	}
 
+	/* write relation statistics read in chunks or streamed */
+	foreach(db, snap->spills)
+	{
+		Spill	   *spill = (Spill *) lfirst(db);
+		const char *streamed[3];
+
+		if (!write_spill(conn, spill, snapid,
+						 PQgetvalue(snap->dbnames, spill->db, 0), snap_date))
+			goto error;
+
+		if (spill->streamed != NULL)
+		{
+			streamed[0] = snapid;
+			streamed[1] = PQgetvalue(snap->dbnames, spill->db, 0);
+			streamed[2] = spill->streamed;
+			if (pgut_command(conn, SQL_UPDATE_DATABASE_STREAMED,
+							 3, streamed) != PGRES_COMMAND_OK)
+				goto error;
+		}
+	}
+
 	/*
 	 * call statsrepo.alert(snapid) if exists
 	 */
@@ -556,18 +2513,52 @@ Snap_exec(Snap *snap, PGconn *conn, const char *instid)
 	params[1] = end;
 	params[2] = snap->start;
 	params[3] = PQgetvalue(repo_size, 0, 0);
-	update_res = pgut_execute(conn, SQL_UPDATE_SNAPSHOT, 4, params);
+	params[4] = (snap->skipped.len > 0 ? snap->skipped.data : NULL);
+	params[5] = snap->escalation;
+	for (i = 0; i < lengthof(pool); i++)
+	{
+		snprintf(pool[i], sizeof(pool[i]), INT64_FORMAT, snap->pool[i]);
+		params[6 + i] = pool[i];
+	}
+	params[9] = (snap->wal_unavailable ? "true" : "false");
+	update_res = pgut_execute(conn, SQL_UPDATE_SNAPSHOT, 10, params);
 	if (PQresultStatus(update_res) != PGRES_COMMAND_OK)
 		goto error;
 
 	if (!pgut_commit(conn))
 		goto error;
+	version_end(true);
+	query_text_end(true);
+
+	/*
+	 * The plan texts written or referred to are in the repository, and the
+	 * statement counters are the baseline of the next delta.
+	 */
+	i = 0;
+	foreach(db, snap->instance)
+	{
+		if (instance_puts[i] && lfirst(db) != NULL &&
+			strcmp(instance_puts[i], SQL_INSERT_PLAN) == 0)
+			known_plans_add((PGresult *) lfirst(db), snap->start);
+		if (instance_puts[i] && lfirst(db) != NULL &&
+			strcmp(instance_puts[i], SQL_INSERT_STATEMENT) == 0)
+			statement_counters_update((PGresult *) lfirst(db), snap->start);
+		i++;
+	}
 
 	/* write alert log */
 	if (alerts)
 		for (i = 0; i < PQntuples(alerts); i++)
 			elog(ALERT, "%s", PQgetvalue(alerts, i, 0));
 
+	/*
+	 * Tell the collector, which may escalate the snapshots. The alerts of a
+	 * lightweight snapshot don't count, or a persistent alert would keep the
+	 * snapshots escalated forever.
+	 */
+	if (alerts && PQntuples(alerts) > 0 && snap->escalation == NULL)
+		last_alert_time = time(NULL);
+
 	free(end);
 	PQclear(snapid_date_res);
 	PQclear(repo_size);
@@ -575,104 +2566,491 @@ Snap_exec(Snap *snap, PGconn *conn, const char *instid)
 	PQclear(update_res);
 	return true;
 
-error:
-	if (end != NULL)
-		free(end);
-	PQclear(snapid_date_res);
-	PQclear(repo_size);
-	PQclear(alerts);
-	PQclear(update_res);
-	pgut_rollback(conn);
-	return false;
+error:
+	if (end != NULL)
+		free(end);
+	PQclear(snapid_date_res);
+	PQclear(repo_size);
+	PQclear(alerts);
+	PQclear(update_res);
+	pgut_rollback(conn);
+	version_end(false);
+	query_text_end(false);
+	return false;
+}
+
+/*
+ * pipeline_add - append a query to be sent by do_pipeline(). Returns the
+ * position of the query.
+ */
+static int
+pipeline_add(PipelineQuery *queries, int *num, const char *sql,
+			 int nParams, const char **params, bool sync)
+{
+	PipelineQuery  *query = &queries[*num];
+
+	query->sql = sql;
+	query->nParams = nParams;
+	query->params = params;
+	query->sync = sync;
+	query->res = NULL;
+
+	return (*num)++;
+}
+
+/*
+ * do_pipeline - send the queries at once and read their results in order.
+ * A sync point is placed after every query marked with 'sync' and after the
+ * last one, and a failure of a query skips the rest of its sync group.
+ * Returns true if all of the queries succeeded.
+ */
+static bool
+do_pipeline(PGconn *conn, PipelineQuery *queries, int num)
+{
+	bool	ok = true;
+	int		i;
+
+	if (!pgut_pipeline_begin(conn))
+		return false;
+
+	for (i = 0; i < num; i++)
+	{
+		if (!pgut_pipeline_send(conn, queries[i].sql,
+								queries[i].nParams, queries[i].params) ||
+			((queries[i].sync || i == num - 1) && !pgut_pipeline_sync(conn)))
+			goto error;
+	}
+
+	for (i = 0; i < num; i++)
+	{
+		PGresult   *res;
+
+		if ((res = pgut_pipeline_result(conn, queries[i].sql)) == NULL)
+			goto error;
+
+		switch (PQresultStatus(res))
+		{
+			case PGRES_TUPLES_OK:
+			case PGRES_COMMAND_OK:
+				queries[i].res = res;
+				break;
+			default:
+				PQclear(res);
+				ok = false;
+				break;
+		}
+
+		/* consume the sync point */
+		if (queries[i].sync || i == num - 1)
+		{
+			if ((res = pgut_pipeline_result(conn, "SYNC")) == NULL)
+				goto error;
+			PQclear(res);
+		}
+	}
+
+	pgut_pipeline_end(conn);
+	return ok;
+
+error:
+	pgut_pipeline_end(conn);
+	for (i = 0; i < num; i++)
+	{
+		PQclear(queries[i].res);
+		queries[i].res = NULL;
+	}
+	return false;
+}
+
+/*
+ * is_instance_drain - true if the query is one of instance_drains.
+ */
+static bool
+is_instance_drain(const char *sql)
+{
+	int		i;
+
+	for (i = 0; instance_drains[i]; i++)
+	{
+		if (strcmp(sql, instance_drains[i]) == 0)
+			return true;
+	}
+	return false;
+}
+
+static PGresult *
+do_get(PGconn *conn, const char *sql, int nParams, const char **params)
+{
+	PGresult *res;
+
+	res = pgut_execute(conn, sql, nParams, params);
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		PQclear(res);
+		return NULL;
+	}
+
+	return res;
+}
+
+static bool
+do_puts(PGconn *conn,
+		const char *sql[],
+		List *src,
+		const char *snapid,
+		const char *dbid,
+		const char *snap_date)
+{
+	ListCell   *cell;
+	int		 i;
+
+	i = 0;
+	foreach(cell, src)
+	{
+		PGresult   *res = (PGresult *) lfirst(cell);
+		const char *kind = (sql[i] ? version_kind(sql[i]) : NULL);
+
+		/* metadata is written only when it has changed */
+		if (res && kind &&
+			version_unchanged(conn, kind, res, snapid, dbid))
+			res = NULL;
+
+		if (res && sql[i])
+		{
+			/* TABLE, COLUMN, INDEX need snap_date for partition key */
+			if ( (strcmp(sql[i],SQL_COPY_TABLE) == 0)
+					|| (strcmp(sql[i], SQL_COPY_COLUMN) == 0)
+					|| (strcmp(sql[i], SQL_COPY_INDEX) == 0) )
+			{
+				if (!do_put_copy(conn, sql[i], res, snapid, dbid, snap_date))
+						return false;
+			}
+			else if( (pg_strncasecmp(sql[i], "COPY ", 5)) == 0)
+			{
+				if (!do_put_copy(conn, sql[i], res, snapid, dbid, NULL))
+						return false;
+			}
+			else if (strcmp(sql[i], SQL_INSERT_STATEMENT) == 0)
+			{
+				if (!do_put_statement(conn, res, snapid))
+						return false;
+			}
+			else
+			{
+				if (!do_put(conn, sql[i], res, snapid, dbid))
+						return false;
+			}
+
+			if (kind && !version_insert(conn, kind, snapid, dbid))
+				return false;
+		}
+		i++;
+	}
+	return true;
+}
+
+/*
+ * version_kind - return the repository table if the metadata is written
+ * only when changed, or NULL.
+ */
+static const char *
+version_kind(const char *sql)
+{
+	int		i;
+
+	for (i = 0; i < lengthof(version_puts); i++)
+	{
+		if (strcmp(sql, version_puts[i].sql) == 0)
+			return version_puts[i].kind;
+	}
+
+	return NULL;
+}
+
+/*
+ * version_unchanged - return true if the metadata is the same as the
+ * version written last, extending the version to the snapshot. The
+ * metadata must be written if the version is not in the repository.
+ */
+static bool
+version_unchanged(PGconn *conn,
+				  const char *kind,
+				  PGresult *res,
+				  const char *snapid,
+				  const char *dbid)
+{
+	Version	   *version = NULL;
+	ListCell   *cell;
+	const char *params[3];
+	PGresult   *update;
+	bool		unchanged;
+
+	if (dbid == NULL)
+		dbid = "0";
+
+	foreach(cell, versions)
+	{
+		Version	   *v = (Version *) lfirst(cell);
+
+		if (strcmp(v->dbid, dbid) == 0 && strcmp(v->kind, kind) == 0)
+		{
+			version = v;
+			break;
+		}
+	}
+
+	if (version == NULL)
+	{
+		version = pgut_new(Version);
+		memset(version, 0, sizeof(*version));
+		version->dbid = pgut_strdup(dbid);
+		version->kind = kind;
+		versions = lappend(versions, version);
+	}
+
+	version->pending = hash_result(res);
+	version->has_pending = true;
+
+	if (!version->valid || version->hash != version->pending)
+		return false;
+
+	params[0] = snapid;
+	params[1] = dbid;
+	params[2] = kind;
+	update = pgut_execute(conn, SQL_EXTEND_VERSION, 3, params);
+	unchanged = (PQresultStatus(update) == PGRES_COMMAND_OK &&
+				 atoi(PQcmdTuples(update)) > 0);
+	PQclear(update);
+
+	return unchanged;
+}
+
+/*
+ * version_insert - record a new version written in the snapshot
+ */
+static bool
+version_insert(PGconn *conn,
+			   const char *kind,
+			   const char *snapid,
+			   const char *dbid)
+{
+	const char *params[3];
+
+	params[0] = snapid;
+	params[1] = (dbid ? dbid : "0");
+	params[2] = kind;
+
+	return pgut_command(conn, SQL_INSERT_VERSION, 3, params) == PGRES_COMMAND_OK;
+}
+
+/*
+ * version_end - remember the hashes written in the transaction if it has
+ * been committed, or forget them.
+ */
+static void
+version_end(bool commit)
+{
+	ListCell   *cell;
+
+	foreach(cell, versions)
+	{
+		Version	   *version = (Version *) lfirst(cell);
+
+		if (version->has_pending && commit)
+		{
+			version->hash = version->pending;
+			version->valid = true;
+		}
+		version->has_pending = false;
+	}
+}
+
+/*
+ * hash_result - FNV-1a hash of the values in the result
+ */
+static uint64
+hash_result(PGresult *res)
+{
+	uint64		hash = UINT64CONST(0xcbf29ce484222325);
+	int			rows = PQntuples(res);
+	int			cols = PQnfields(res);
+	int			r, c;
+
+#define HASH_BYTES(data, len) \
+	do { \
+		const unsigned char *p_ = (const unsigned char *) (data); \
+		size_t	n_; \
+		for (n_ = 0; n_ < (size_t) (len); n_++) \
+		{ \
+			hash ^= p_[n_]; \
+			hash *= UINT64CONST(0x100000001b3); \
+		} \
+	} while (0)
+
+	HASH_BYTES(&rows, sizeof(rows));
+	HASH_BYTES(&cols, sizeof(cols));
+	for (r = 0; r < rows; r++)
+	{
+		for (c = 0; c < cols; c++)
+		{
+			int		len = (PQgetisnull(res, r, c) ? -1 : PQgetlength(res, r, c));
+
+			HASH_BYTES(&len, sizeof(len));
+			if (len > 0)
+				HASH_BYTES(PQgetvalue(res, r, c), len);
+		}
+	}
+
+#undef HASH_BYTES
+
+	return hash;
 }
 
 /*
- * 'sql' must have a NULL sentinel at the end.
+ * query_text_expire - forget the query texts known to be in the repository
+ * at the first snapshot of a day. Texts not referred to by any statement are
+ * deleted by the maintenance, while the ones written today are referred to.
  */
-static List *
-do_gets(PGconn *conn, const char *sql[], int nParams, const char **params)
+static void
+query_text_expire(const char *start)
 {
-	int		i;
-	List   *result = NIL;
+	if (strncmp(query_texts_date, start, 10) == 0)
+		return;
 
-	if (pgut_command(conn, "BEGIN", 0, NULL) != PGRES_COMMAND_OK)
-		goto error;
+	free(query_texts);
+	query_texts = NULL;
+	nquery_texts = 0;
+	strlcpy(query_texts_date, start, sizeof(query_texts_date));
+}
+
+/*
+ * do_put_statement - write the statements. The query texts are written into
+ * statsrepo.query_text only when they are not known to be there, and the
+ * statements refer to them by the hash.
+ */
+static bool
+do_put_statement(PGconn *conn, PGresult *src, const char *snapid)
+{
+	PGresult   *hashed;
+	const char *params[5];
+	int			rows = PQntuples(src);
+	int			inflight = 0;
+	int			r;
+	bool		ok;
+
+	hashed = PQcopyResult(src, PG_COPYRES_ATTRS | PG_COPYRES_TUPLES);
+	if (hashed == NULL)
+		return false;
+
+	pending_texts = pgut_realloc(pending_texts,
+		sizeof(QueryTextKey) * (npending_texts + rows));
 
-	for (i = 0; sql[i]; i++)
+	if (!pgut_pipeline_begin(conn))
 	{
-		PGresult   *res;
+		PQclear(hashed);
+		return false;
+	}
+
+	for (r = 0; r < rows; r++)
+	{
+		QueryTextKey	key;
+		const char	   *query = PQgetvalue(src, r, 3);
+		uint64			hash = UINT64CONST(0xcbf29ce484222325);
+		const char	   *p;
+		char			hash_str[32];
+
+		/* keep NULL as is */
+		if (PQgetisnull(src, r, 3))
+			continue;
+
+		for (p = query; *p; p++)
+		{
+			hash ^= (unsigned char) *p;
+			hash *= UINT64CONST(0x100000001b3);
+		}
 
-		if ((res = do_get(conn, sql[i], nParams, params)) == NULL)
+		memset(&key, 0, sizeof(key));
+		parse_uint32(PQgetvalue(src, r, 0), &key.dbid);
+		parse_uint32(PQgetvalue(src, r, 1), &key.userid);
+		parse_int64(PQgetvalue(src, r, 2), &key.queryid);
+		key.hash = (int64) hash;
+
+		snprintf(hash_str, sizeof(hash_str), INT64_FORMAT, key.hash);
+		if (!PQsetvalue(hashed, r, 3, hash_str, strlen(hash_str)))
+			goto error;
+
+		if (bsearch(&key, query_texts, nquery_texts,
+					sizeof(QueryTextKey), query_text_cmp) != NULL)
+			continue;
+
+		params[0] = PQgetvalue(src, r, 0);
+		params[1] = PQgetvalue(src, r, 1);
+		params[2] = PQgetvalue(src, r, 2);
+		params[3] = hash_str;
+		params[4] = query;
+		if (!pgut_pipeline_send(conn, SQL_INSERT_QUERY_TEXT, 5, params))
 			goto error;
-		result = lappend(result, res);
+		pending_texts[npending_texts++] = key;
+
+		if (++inflight >= PIPELINE_WINDOW)
+		{
+			if (!pgut_pipeline_check(conn, inflight, SQL_INSERT_QUERY_TEXT))
+				goto error;
+			inflight = 0;
+		}
 	}
 
-	if (!pgut_commit(conn))
+	if (inflight > 0 &&
+		!pgut_pipeline_check(conn, inflight, SQL_INSERT_QUERY_TEXT))
 		goto error;
 
-	return result;	/* ok */
+	pgut_pipeline_end(conn);
+
+	ok = do_put(conn, SQL_INSERT_STATEMENT, hashed, snapid, NULL);
+	PQclear(hashed);
+	return ok;
 
 error:
-	list_destroy(result, PQclear);
-	pgut_rollback(conn);
-	return NIL;
+	pgut_pipeline_end(conn);
+	PQclear(hashed);
+	return false;
 }
 
-static PGresult *
-do_get(PGconn *conn, const char *sql, int nParams, const char **params)
+/*
+ * query_text_end - remember the query texts written in the transaction if it
+ * has been committed, or forget them.
+ */
+static void
+query_text_end(bool commit)
 {
-	PGresult *res;
-
-	res = pgut_execute(conn, sql, nParams, params);
-	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	if (commit && npending_texts > 0)
 	{
-		PQclear(res);
-		return NULL;
+		query_texts = pgut_realloc(query_texts,
+			sizeof(QueryTextKey) * (nquery_texts + npending_texts));
+		memcpy(query_texts + nquery_texts, pending_texts,
+			   sizeof(QueryTextKey) * npending_texts);
+		nquery_texts += npending_texts;
+		qsort(query_texts, nquery_texts,
+			  sizeof(QueryTextKey), query_text_cmp);
 	}
-
-	return res;
+	npending_texts = 0;
 }
 
-static bool
-do_puts(PGconn *conn,
-		const char *sql[],
-		List *src,
-		const char *snapid,
-		const char *dbid,
-		const char *snap_date)
+static int
+query_text_cmp(const void *a, const void *b)
 {
-	ListCell   *cell;
-	int		 i;
-
-	i = 0;
-	foreach(cell, src)
-	{
-		PGresult *res = (PGresult *) lfirst(cell);
-
-		if (res && sql[i])
-		{
-			/* TABLE, COLUMN, INDEX need snap_date for partition key */
-			if ( (strcmp(sql[i],SQL_COPY_TABLE) == 0)
-					|| (strcmp(sql[i], SQL_COPY_COLUMN) == 0)
-					|| (strcmp(sql[i], SQL_COPY_INDEX) == 0) )
-			{
-				if (!do_put_copy(conn, sql[i], res, snapid, dbid, snap_date))
-						return false;
-			}
-			else if( (pg_strncasecmp(sql[i], "COPY ", 5)) == 0)
-			{
-				if (!do_put_copy(conn, sql[i], res, snapid, dbid, NULL))
-						return false;
-			}
-			else
-			{
-				if (!do_put(conn, sql[i], res, snapid, dbid))
-						return false;
-			}
-		}
-		i++;
-	}
-	return true;
+	const QueryTextKey *ka = (const QueryTextKey *) a;
+	const QueryTextKey *kb = (const QueryTextKey *) b;
+
+	if (ka->queryid != kb->queryid)
+		return ka->queryid < kb->queryid ? -1 : 1;
+	if (ka->dbid != kb->dbid)
+		return ka->dbid < kb->dbid ? -1 : 1;
+	if (ka->userid != kb->userid)
+		return ka->userid < kb->userid ? -1 : 1;
+	if (ka->hash != kb->hash)
+		return ka->hash < kb->hash ? -1 : 1;
+	return 0;
 }
 
 static bool
@@ -686,6 +3064,7 @@ do_put(PGconn *conn,
 	int			rows, cols;
 	int			r, c;
 	int			shift;
+	int			inflight = 0;
 
 	Assert(src);
 
@@ -701,6 +3080,13 @@ do_put(PGconn *conn,
 		return false;
 	}
 
+	/*
+	 * Rows are sent in pipeline mode, and the results are checked every
+	 * PIPELINE_WINDOW rows. The caller's transaction is left open on error.
+	 */
+	if (!pgut_pipeline_begin(conn))
+		return false;
+
 	rows = PQntuples(src);
 	for (r = 0; r < rows; r++)
 	{
@@ -712,28 +3098,27 @@ do_put(PGconn *conn,
 				params[shift + c] = PQgetvalue(src, r, c);
 		}
 
-		switch (pgut_command(conn, sql, shift + cols, params))
+		if (!pgut_pipeline_send(conn, sql, shift + cols, params))
+			goto error;
+
+		if (++inflight >= PIPELINE_WINDOW)
 		{
-			case PGRES_COMMAND_OK:
-			case PGRES_TUPLES_OK:
-				break;
-			default:
-				return false;
+			if (!pgut_pipeline_check(conn, inflight, sql))
+				goto error;
+			inflight = 0;
 		}
 	}
 
+	if (inflight > 0 && !pgut_pipeline_check(conn, inflight, sql))
+		goto error;
+
+	pgut_pipeline_end(conn);
 	return true;
-}
 
-/*
- *	statsrepo.table/column/index has columns as snapid, dbid, xx, xx, date, ....
- *	If we perform COPY  to these tables, must care about partition key column(date).
- *	For now, these tables has date column at attnum = 5.
- *	And in do_put_copy() snapid and dbid would be always set.
- *	So, when the data to be copied is extracted from the resultSet and added to the buffer,
- *	snap_date should be inserted at the position of this constant.
- */
-#define PART_KEY_POSITION 2
+error:
+	pgut_pipeline_end(conn);
+	return false;
+}
 
 static bool
 do_put_copy(PGconn *conn,
@@ -743,19 +3128,13 @@ do_put_copy(PGconn *conn,
 			const char *dbid,
 			const char *snap_date)
 {
-	char buffer[4096];
-	char   *field_buffer = NULL;
-	size_t	field_buffer_size = 0;
-	int		rows, cols;
-	int		r, c;
-	int		shift;
-	int copy_res;
-	PGresult   *res;
-	char *copy_errormsg = NULL;
-	bool has_snap_date = false;
-	size_t  max_len = sizeof(buffer) - 1;
-	size_t  len = 0;
-	size_t  n;
+	StringInfoData	buf;
+	int				chunk_size;
+	int				rows, cols;
+	int				r, c;
+	int				shift;
+	PGresult	   *res;
+	bool			ok = true;
 
 	Assert(src);
 
@@ -766,11 +3145,8 @@ do_put_copy(PGconn *conn,
 	if (dbid)
 		shift++;
 
-	if(snap_date)
-	{
-		has_snap_date = true;
+	if (snap_date)
 		shift++;
-	}
 
 	if (shift + cols > FUNC_MAX_ARGS)
 	{
@@ -778,6 +3154,18 @@ do_put_copy(PGconn *conn,
 		return false;
 	}
 
+	/* use the binary format if the repository columns allow it */
+	switch (copy_binary(conn, sql, src, snapid, dbid, snap_date,
+						PART_KEY_POSITION))
+	{
+		case COPY_BINARY_OK:
+			return true;
+		case COPY_BINARY_FAILED:
+			return false;
+		case COPY_BINARY_UNSUPPORTED:
+			break;
+	}
+
 	rows = PQntuples(src);
 	res = pgut_execute(conn, sql, 0, NULL);
 	if (PQresultStatus(res) != PGRES_COPY_IN)
@@ -785,246 +3173,206 @@ do_put_copy(PGconn *conn,
 		PQclear(res);
 		return false;
 	}
+	PQclear(res);
 
-	for (r = 0; r < rows; r++)
+	/* the rows are sent every copy_chunk_size kilobytes */
+	initStringInfo(&buf);
+	chunk_size = Max(copy_chunk_size, 1) * 1024;
+	for (r = 0; r < rows && ok; r++)
 	{
-		buffer[0] = '\0';
-		len = 0;
-
-		strcpy(&buffer[ len ], snapid);
-		len += strlen(snapid);;
-		strcpy(&buffer[ len ], COPY_DELIMITER);
-		len += 1;
-
+		appendStringInfo(&buf, "%s" COPY_DELIMITER, snapid);
 		if (dbid)
-		{
-			strcpy(&buffer[ len ], dbid);
-			len += strlen(dbid);
-			strcpy(&buffer[ len ], COPY_DELIMITER);
-			len += 1;
-		}
+			appendStringInfo(&buf, "%s" COPY_DELIMITER, dbid);
 
 		for (c = 0; c < cols; c++)
 		{
-			const char *field;
 			const char *p;
-			int			field_len;
-			int			esc_cnt;
 
 			/* insert date info for partition key if reaches the corresponding position */
-			if (c == PART_KEY_POSITION && has_snap_date)
-			{
-				strcpy(&buffer[ len ], snap_date);
-				len += strlen(snap_date);
-				strcpy(&buffer[ len ], COPY_DELIMITER);
-				len += 1;
-			}
+			if (c == PART_KEY_POSITION && snap_date)
+				appendStringInfo(&buf, "%s" COPY_DELIMITER, snap_date);
 
 			if (PQgetisnull(src, r, c))
-				field = NULL_STR;
-			else
-				field = PQgetvalue(src, r, c);
-
-			/*
-			 * If the column is a string or name type, characters are escaped
-			 * in the same way as CopyAttributeOutText.
-			 */
-			if (PQftype(src, c) == TEXTOID || PQftype(src, c) == NAMEOID)
+				appendStringInfoString(&buf, NULL_STR);
+			else if (PQftype(src, c) == TEXTOID || PQftype(src, c) == NAMEOID)
 			{
-				/* Check size of field after escaping */
-				esc_cnt = 0;
-				for (p = field; *p != '\0'; p++)
+				/*
+				 * If the column is a string or name type, characters are
+				 * escaped in the same way as CopyAttributeOutText.
+				 */
+				for (p = PQgetvalue(src, r, c); *p != '\0'; p++)
 				{
 					switch (*p)
 					{
 						case '\b':
+							appendStringInfoString(&buf, "\\b");
+							break;
 						case '\f':
+							appendStringInfoString(&buf, "\\f");
+							break;
 						case '\n':
+							appendStringInfoString(&buf, "\\n");
+							break;
 						case '\r':
+							appendStringInfoString(&buf, "\\r");
+							break;
 						case '\t':
+							/* contains delimiter (COPY_DELIMITER) */
+							appendStringInfoString(&buf, "\\t");
+							break;
 						case '\v':
+							appendStringInfoString(&buf, "\\v");
+							break;
 						case '\\':
-							esc_cnt++;
+							appendStringInfoString(&buf, "\\\\");
 							break;
 						default:
-							break;
-					}
-				}
-
-				if (esc_cnt == 0){
-					/* No characters require escape */
-					n = strlen(field);
-					p = field;
-				}
-				else
-				{
-					field_len = strlen(field) + esc_cnt;
-					/* Add 1 byte for null terminator. */
-					field_len++;
-
-					/* Reallocate memory if buffer size is insufficient. */
-					if (field_buffer_size < field_len)
-					{
-						if (field_buffer_size == 0)
-							field_buffer_size = 64;
-						while (field_buffer_size < field_len)
-							field_buffer_size *= 2;
-
-						field_buffer = pgut_realloc(field_buffer, field_buffer_size);
-					}
-
-					n = 0;
-					for (p = field; *p != '\0'; p++)
-					{
-						switch (*p)
-						{
-							case '\b':
-								field_buffer[n++] = '\\';
-								field_buffer[n++] = 'b';
-								break;
-							case '\f':
-								field_buffer[n++] = '\\';
-								field_buffer[n++] = 'f';
-								break;
-							case '\n':
-								field_buffer[n++] = '\\';
-								field_buffer[n++] = 'n';
-								break;
-							case '\r':
-								field_buffer[n++] = '\\';
-								field_buffer[n++] = 'r';
-								break;
-							case '\t':
-								/* contains delimiter (COPY_DELIMITER) */
-								field_buffer[n++] = '\\';
-								field_buffer[n++] = 't';
-								break;
-							case '\v':
-								field_buffer[n++] = '\\';
-								field_buffer[n++] = 'v';
-								break;
-							case '\\':
-								field_buffer[n++] = '\\';
-								field_buffer[n++] = '\\';
-								break;
-							default:
-								field_buffer[n++] = *p;
-						}
+							appendStringInfoChar(&buf, *p);
 					}
-					field_buffer[n] = '\0';
-					n = strlen(field_buffer);
-					p = field_buffer;
 				}
-			} else {
-				n = strlen(field);
-				p = field;
 			}
+			else
+				appendStringInfoString(&buf, PQgetvalue(src, r, c));
 
-			/*
-			 * If there are huge column values, split them into "buffer" sizes and
-			 * call PQputCopyData individually.
-			 */
-			while ( len + n + 1 >= max_len )
-			{
-				int  s;
-				/*
-				 * Number of characters that can be stored in the buffer.
-				 * (Including delimiter characters)
-				 */
-				s = max_len - len - 1;
-				Assert( s >= 0 );
-
-				strncpy(&buffer[ len ], p, s);
-				len += s;
-				copy_res = PQputCopyData(conn, buffer, len);
-				if (copy_res  != 1)
-					goto FAILED_COPY_DATA;
-				
-				n -= s;
-				p += s;
-				buffer[0] = '\0'; /* clear buffer */
-				len = 0;
-			}
-			strcpy(&buffer[ len ], p);
-			len += n;
-			strcpy(&buffer[ len ], COPY_DELIMITER);
-			len += 1;
+			appendStringInfoString(&buf, c < cols - 1 ? COPY_DELIMITER : "\n");
 		}
 
-		/* Overwrite end of  COPY_DELIMITER with "\n" */
-		buffer[len - 1] = '\n';
+		if (buf.len >= chunk_size)
+		{
+			if (PQputCopyData(conn, buf.data, buf.len) != 1)
+				ok = false;
+			resetStringInfo(&buf);
+		}
+	}
+	if (ok && buf.len > 0 && PQputCopyData(conn, buf.data, buf.len) != 1)
+		ok = false;
+	termStringInfo(&buf);
 
-		copy_res = PQputCopyData(conn, buffer, len);
-		if (copy_res  != 1)
-			goto FAILED_COPY_DATA;
-		
+	if (!ok)
+		elog(WARNING, "PQputCopyData was failed: %s", PQerrorMessage(conn));
+	if (PQputCopyEnd(conn, ok ? NULL : "could not send the data") != 1)
+	{
+		elog(WARNING, "Failed Copy and/or sent CopyDone Msg:%s",
+			 PQerrorMessage(conn));
+		ok = false;
 	}
 
-	if (field_buffer)
+	/* the result of the COPY */
+	while ((res = PQgetResult(conn)) != NULL)
 	{
-		free(field_buffer);
-		field_buffer = NULL;
+		if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		{
+			if (ok)
+				elog(WARNING, "COPY failed: %s", PQerrorMessage(conn));
+			ok = false;
+		}
+		PQclear(res);
 	}
 
-	switch (PQputCopyEnd(conn, copy_errormsg))
+	return ok;
+}
+
+/*
+ * stream_relations - read the statistics of tables, columns and indexes of
+ * the database into Spills without keeping them in memory. The writer reads
+ * them before it takes the write slot and the instance lock, so reading the
+ * database does not extend the hold of them. The statistics are read when
+ * the snapshot is written, which may be well after the other statistics of
+ * the snapshot, so the time they are read is recorded in
+ * statsrepo.database.streamed.
+ */
+static bool
+stream_relations(Snap *snap, int db, List **spills)
+{
+	const char *dbname = PQgetvalue(snap->dbnames, db, 1);
+	const char *params[] = {excluded_schemas, snap->rotation};
+	PGconn	   *src;
+	const char **gets;
+	const char *sql_column;
+	const char *sql_index;
+	bool		collect_column;
+	bool		collect_index;
+	char	   *streamed;
+	Spill	   *spill;
+
+	elog(DEBUG2, "write (stream database=%s)", dbname);
+
+	if ((src = collector_connect_db(&stream_conn, dbname)) == NULL)
+		return false;
+
+	if ((streamed = getlocaltimestamp()) == NULL)
+		return false;
+
+	gets = relation_queries(has_relation_stats(src),
+							&sql_column, &sql_index);
+	probe_collect(src, &collect_column, &collect_index);
+
+	/* decide the leaves rolled up by the tables, columns and indexes */
+	if (partition_rollup_enabled())
 	{
-		case 1:
-			break;
-		default:
-			elog(WARNING, "Failed Copy and/or sent CopyDone Msg:%s:%s",
-							copy_errormsg ? copy_errormsg : "(null)", PQerrorMessage(conn) );
-			PQclear(res);
+		PGresult   *res = do_get(src, SQL_SET_ROLLUP_LEAVES_NEW, 0, NULL);
+
+		if (res == NULL)
+		{
+			free(streamed);
 			return false;
+		}
+		PQclear(res);
 	}
 
-	PQclear(res);
-	return true;
+	/* the table statistics carry the time they are read */
+	if ((spill = stream_spill(src, db, gets[DATABASE_GETS_TABLE], 1, params,
+							  SQL_COPY_TABLE)) == NULL)
+	{
+		free(streamed);
+		return false;
+	}
+	spill->streamed = streamed;
+	*spills = lappend(*spills, spill);
 
-FAILED_COPY_DATA:
-	PQclear(res);
-	if (field_buffer)
+	if (collect_column)
 	{
-		free(field_buffer);
-		field_buffer = NULL;
+		if ((spill = stream_spill(src, db, sql_column, 2, params,
+								  SQL_COPY_COLUMN)) == NULL)
+			return false;
+		*spills = lappend(*spills, spill);
 	}
 
-	elog(WARNING, "PQputCopyData was failed. return code %d", copy_res);
-	return false;
+	if (collect_index)
+	{
+		if ((spill = stream_spill(src, db, sql_index, 1, params,
+								  SQL_COPY_INDEX)) == NULL)
+			return false;
+		*spills = lappend(*spills, spill);
+	}
 
+	return true;
 }
 
-static bool
-has_pg_stat_statements(PGconn *conn)
+/*
+ * stream_spill - read the rows of 'sql' into a new Spill to be written with
+ * 'copy_sql'. Returns NULL if the rows could not be read.
+ */
+static Spill *
+stream_spill(PGconn *src, int db, const char *sql, int nParams,
+			 const char **params, const char *copy_sql)
 {
-	PGresult   *res;
-	bool		result;
-
-	/* check whether pg_stat_statements is installed */
-	res = pgut_execute(conn,
-			"SELECT relname FROM pg_class"
-			" WHERE relname = 'pg_stat_statements' AND relkind = 'v'",
-			0, NULL);
-	result = (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) > 0);
-	PQclear(res);
-
-	return result;
-}
+	Spill	   *spill;
+	FILE	   *file;
 
-static bool
-has_pg_store_plans(PGconn *conn)
-{
-	PGresult   *res;
-	bool		result;
+	file = spill_query(src, sql, nParams, params,
+					   snapshot_chunk_rows > 0 ? snapshot_chunk_rows
+											   : STREAM_CHUNK_ROWS);
+	if (file == NULL)
+		return NULL;
 
-	/* check whether pg_store_plans is installed */
-	res = pgut_execute(conn,
-			"SELECT relname FROM pg_class"
-			" WHERE relname = 'pg_store_plans' AND relkind = 'v'",
-			0, NULL);
-	result = (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) > 0);
-	PQclear(res);
+	spill = pgut_new(Spill);
+	spill->db = db;
+	spill->sql = copy_sql;
+	spill->file = file;
+	spill->streamed = NULL;
 
-	return result;
+	return spill;
 }
 
 static bool
@@ -1047,56 +3395,21 @@ has_statsrepo_alert(PGconn *conn)
 	return result;
 }
 
+/*
+ * has_relation_stats - tell whether the functions to collect statistics of
+ * tables and indexes are installed in the database. If not, the catalog
+ * join queries are used instead.
+ */
 static bool
-is_rusage_enabled(PGconn *conn)
-{
-	PGresult   *res;
-	bool	    result;
-
-	/* check whether rusage is enabled  */
-	res = pgut_execute(conn,
-			"SELECT 1 FROM pg_settings"
-			" WHERE name = 'pg_statsinfo.rusage_track' AND setting IN ('all', 'top');",
-					   0, NULL);
-	result = (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) > 0);
-	PQclear(res);
-
-	return result;
-
-}
-
-static bool
-is_collect_column_enabled(PGconn *conn)
-{
-	PGresult   *res;
-	bool	    result;
-
-	/* check collect_column is enabled  */
-	res = pgut_execute(conn,
-			"SELECT 1 FROM pg_settings"
-			" WHERE name = 'pg_statsinfo.collect_column' AND setting = 'on';",
-					   0, NULL);
-	result = (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) > 0);
-	PQclear(res);
-
-	return result;
-
-}
-
-static bool
-is_collect_index_enabled(PGconn *conn)
+has_relation_stats(PGconn *conn)
 {
 	PGresult   *res;
-	bool	    result;
+	bool		result;
 
-	/* check collect_index is enabled  */
-	res = pgut_execute(conn,
-			"SELECT 1 FROM pg_settings"
-			" WHERE name = 'pg_statsinfo.collect_index' AND setting = 'on';",
-					   0, NULL);
-	result = (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) > 0);
+	res = pgut_execute(conn, SQL_HAS_RELATION_STATS, 0, NULL);
+	result = (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) > 0 &&
+			  strcmp(PQgetvalue(res, 0, 0), "t") == 0);
 	PQclear(res);
 
 	return result;
-
 }
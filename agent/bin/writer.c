@@ -30,6 +30,10 @@ static PGconn		   *writer_conn = NULL;
 static time_t			writer_conn_last_used;
 static bool				superuser_connect = false;
 static bool				ignore_logstore = false;
+static bool				writer_pipelining = false;
+
+/* instance ID in the repository, or 0 until the writer gets it */
+volatile int64			writer_instid = 0;
 
 /*---- GUC variables ----*/
 static char	   *my_repository_server = NULL;
@@ -49,6 +53,9 @@ static bool check_repository(PGconn *conn);
 static void set_writer_state(WriterState state);
 static void writer_delay(void);
 static void validate_logstore(void);
+static bool is_event_item(QueueItem *item);
+static List *write_events(List *queue, PGconn *conn, const char *instid,
+						  bool *retry);
 
 void
 writer_init(void)
@@ -241,12 +248,27 @@ recv_writer_queue(void)
 	/* do the writer queue process */
 	if ((instid = get_instid(writer_conn)) != NULL)
 	{
+		int64	id;
+
 		connection_used = true;
+		if (parse_int64(instid, &id))
+			writer_instid = id;
 
 		while (list_length(queue) > 0)
 		{
 			QueueItem  *item = (QueueItem *) linitial(queue);
 
+			/* send a run of single-row events in a pipeline */
+			if (is_event_item(item))
+			{
+				bool	retry;
+
+				queue = write_events(queue, writer_conn, instid, &retry);
+				if (retry)
+					break;
+				continue;
+			}
+
 			if (!item->exec(item, writer_conn, instid))
 			{
 				if (++item->retry < DB_MAX_RETRY)
@@ -285,6 +307,130 @@ recv_writer_queue(void)
 	return ret;
 }
 
+/*
+ * writer_put - run an INSERT of a single event. While the writer is sending
+ * a run of events, the INSERT is queued in the pipeline with its own sync
+ * point, and the result is checked in write_events().
+ */
+bool
+writer_put(PGconn *conn, const char *sql, int nParams, const char **params)
+{
+	if (writer_pipelining)
+		return pgut_pipeline_send(conn, sql, nParams, params) &&
+			   pgut_pipeline_sync(conn);
+
+	return pgut_command(conn, sql, nParams, params) == PGRES_COMMAND_OK;
+}
+
+/* checkpoints and autovacuums are written with a single INSERT each */
+static bool
+is_event_item(QueueItem *item)
+{
+	return item->type == QUEUE_CHECKPOINT || item->type == QUEUE_AUTOVACUUM;
+}
+
+/*
+ * write_events - write up to PIPELINE_WINDOW events from the head of the
+ * queue in one round trip. Each event still commits on its own. Written and
+ * discarded items are removed from the queue. *retry is set when some items
+ * failed and are left at the head of the queue to be retried.
+ */
+static List *
+write_events(List *queue, PGconn *conn, const char *instid, bool *retry)
+{
+	List	   *sent = NIL;
+	List	   *failed = NIL;
+	List	   *retried = NIL;
+	QueueItem  *unsent = NULL;
+	ListCell   *cell;
+	bool		connected = true;
+
+	if (!pgut_pipeline_begin(conn))
+	{
+		*retry = true;
+		return queue;
+	}
+
+	writer_pipelining = true;
+	while (list_length(queue) > 0 && list_length(sent) < PIPELINE_WINDOW)
+	{
+		QueueItem  *item = (QueueItem *) linitial(queue);
+
+		if (!is_event_item(item))
+			break;
+
+		queue = list_delete_first(queue);
+		if (!item->exec(item, conn, instid))
+		{
+			unsent = item;
+			break;
+		}
+		sent = lappend(sent, item);
+	}
+	writer_pipelining = false;
+
+	/*
+	 * Read the results in order. A failed event does not affect the others
+	 * because each one has its own sync point.
+	 */
+	foreach(cell, sent)
+	{
+		QueueItem  *item = (QueueItem *) lfirst(cell);
+		PGresult   *res;
+		bool		ok = false;
+
+		if (connected)
+		{
+			if ((res = pgut_pipeline_result(conn, "INSERT")) == NULL)
+				connected = false;
+			else
+			{
+				ok = (PQresultStatus(res) == PGRES_COMMAND_OK);
+				PQclear(res);
+
+				/* consume the sync point of the event */
+				if ((res = pgut_pipeline_result(conn, "SYNC")) == NULL)
+					connected = false;
+				PQclear(res);
+			}
+		}
+
+		if (ok)
+			item->free(item);
+		else
+			failed = lappend(failed, item);
+	}
+	list_free(sent);
+	pgut_pipeline_end(conn);
+
+	/* the item which could not be sent follows all of the sent ones */
+	if (unsent != NULL)
+		failed = lappend(failed, unsent);
+
+	/* failed items are put back to the head of the queue in order */
+	foreach(cell, failed)
+	{
+		QueueItem  *item = (QueueItem *) lfirst(cell);
+
+		if (++item->retry < DB_MAX_RETRY)
+		{
+			retried = lappend(retried, item);
+			continue;
+		}
+
+		/*
+		 * discard if the retry count is exceeded to avoid infinite
+		 * loops at one bad item.
+		 */
+		elog(WARNING, "writer discard an item");
+		item->free(item);
+	}
+	list_free(failed);
+
+	*retry = (retried != NIL);
+	return list_concat(retried, queue);
+}
+
 /*
  * connect to repository server.
  */
@@ -322,6 +468,7 @@ writer_disconnect(void)
 {
 	pgut_disconnect(writer_conn);
 	writer_conn = NULL;
+	copy_binary_reset();
 }
 
 static char *
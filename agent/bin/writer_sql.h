@@ -31,28 +31,55 @@ INSERT INTO statsrepo.activity VALUES \
 INSERT INTO statsrepo.xact VALUES \
 ($1, $2, $3, $4, $5, $6)"
 
+#define SQL_INSERT_BACKEND_MEMORY "\
+INSERT INTO statsrepo.backend_memory VALUES \
+($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11, $12, $13)"
+
 #define SQL_INSERT_STATEMENT "\
 INSERT INTO statsrepo.statement \
-  SELECT (($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11, $12, $13, $14, $15, $16, $17, $18, $19, $20, $21, $22, $23, $24, $25, $26)::statsrepo.statement).* \
+  SELECT (($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11, $12, $13, $14, $15, $16, $17, $18, $19, $20, $21, $22, $23, $24, $25, $26, $27)::statsrepo.statement).* \
     FROM statsrepo.database d \
    WHERE d.snapid = $1 AND d.dbid = $2"
 
+#define SQL_INSERT_QUERY_TEXT "\
+INSERT INTO statsrepo.query_text VALUES \
+($1, $2, $3, $4, $5) ON CONFLICT DO NOTHING"
+
 #define SQL_INSERT_PLAN "\
+WITH t AS ( \
+  INSERT INTO statsrepo.plan_text \
+    SELECT $5::bigint, $6::bigint, $28::text WHERE $28 IS NOT NULL \
+    ON CONFLICT DO NOTHING) \
 INSERT INTO statsrepo.plan \
   SELECT (($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11, $12, $13, $14, $15, $16, $17, $18, $19, $20, $21, $22, $23, $24, $25, $26, $27)::statsrepo.plan).* \
     FROM statsrepo.database d \
    WHERE d.snapid = $1 AND d.dbid = $2"
 
 #define SQL_INSERT_LOCK "\
-INSERT INTO statsrepo.lock VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11, $12, $13, $14, $15, $16)"
+INSERT INTO statsrepo.lock VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11, $12, $13, $14, $15, $16, $17, $18)"
 
 #define SQL_INSERT_BGWRITER "\
 INSERT INTO statsrepo.bgwriter VALUES ($1, $2, $3, $4)"
 
+#define SQL_INSERT_BUFFERCACHE "\
+INSERT INTO statsrepo.buffercache VALUES \
+($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11, $12, $13, $14, $15, $16)"
+
+#define SQL_INSERT_PROGRESS "\
+INSERT INTO statsrepo.progress VALUES \
+($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11, $12, $13, $14)"
+
 #define SQL_INSERT_REPLICATION "\
 INSERT INTO statsrepo.replication VALUES \
 ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11, $12, $13, $14, $15, $16, $17, $18, $19, $20, $21)"
 
+#define SQL_INSERT_REPLICATION_LAG "\
+INSERT INTO statsrepo.replication_lag VALUES \
+($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11, $12, $13)"
+
+#define SQL_INSERT_REPLICATION_SLOT_RETENTION "\
+INSERT INTO statsrepo.replication_slot_retention VALUES ($1, $2, $3, $4, $5, $6)"
+
 #define SQL_INSERT_REPLICATION_SLOTS "\
 INSERT INTO statsrepo.replication_slots VALUES \
 ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11, $12, $13, $14)"
@@ -72,6 +99,9 @@ INSERT INTO statsrepo.stat_wal VALUES \
 #define SQL_INSERT_XLOG "\
 INSERT INTO statsrepo.xlog VALUES ($1, $2, $3)"
 
+#define SQL_INSERT_WAL_COMPOSITION "\
+INSERT INTO statsrepo.wal_composition VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9)"
+
 #define SQL_INSERT_ARCHIVE "\
 INSERT INTO statsrepo.archive VALUES ($1, $2, $3, $4, $5, $6, $7, $8)"
 
@@ -129,6 +159,20 @@ COPY statsrepo.inherits FROM STDIN with(NULL '" NULL_STR "')"
 #define SQL_COPY_FUNCTION "\
 COPY statsrepo.function FROM STDIN with(NULL '" NULL_STR "')"
 
+#define SQL_COPY_STAT_FUNCTION "\
+COPY statsrepo.stat_function FROM STDIN with(NULL '" NULL_STR "')"
+
+#define SQL_COPY_INSTANCE_TS "\
+COPY statsrepo.instance_ts FROM STDIN with(NULL '" NULL_STR "')"
+
+#define SQL_COPY_BINARY "\
+COPY %s FROM STDIN WITH (FORMAT binary)"
+
+#define SQL_SELECT_COPY_TYPES "\
+SELECT atttypid FROM pg_attribute \
+WHERE attrelid = pg_catalog.to_regclass($1) AND attnum > 0 AND NOT attisdropped \
+ORDER BY attnum"
+
 #define SQL_INSERT_ALERT "\
 INSERT INTO statsrepo.alert_message VALUES ($1, $2)"
 
@@ -143,16 +187,70 @@ SET \
 	exec_time = pg_catalog.age($2, $3), \
 	snapshot_increase_size = ((SELECT pg_catalog.sum(pg_catalog.pg_relation_size(oid)) FROM pg_class \
 								WHERE relnamespace = (SELECT oid FROM pg_namespace WHERE nspname = 'statsrepo')) - $4), \
-  xid_current = pg_catalog.pg_snapshot_xmax(pg_catalog.pg_current_snapshot()) \
+  xid_current = pg_catalog.pg_snapshot_xmax(pg_catalog.pg_current_snapshot()), \
+	skipped = $5, \
+	escalation = $6, \
+	pool_hits = $7, \
+	pool_misses = $8, \
+	pool_reconnects = $9, \
+	wal_unavailable = $10 \
 WHERE \
 	snapid = $1"
 
+#define SQL_UPDATE_DATABASE_CARRIED "\
+UPDATE \
+	statsrepo.database d \
+SET \
+	carried = ( \
+		SELECT COALESCE(p.carried, p.snapid) \
+		FROM statsrepo.database p, statsrepo.snapshot s \
+		WHERE p.snapid = s.snapid \
+		  AND p.dbid = d.dbid \
+		  AND p.snapid < d.snapid \
+		  AND s.instid = (SELECT instid FROM statsrepo.snapshot WHERE snapid = $1) \
+		ORDER BY p.snapid DESC LIMIT 1) \
+WHERE \
+	d.snapid = $1 AND d.dbid = $2"
+
+/* time the streamed relation statistics were read from the database */
+#define SQL_UPDATE_DATABASE_STREAMED "\
+UPDATE statsrepo.database SET streamed = $3 WHERE snapid = $1 AND dbid = $2"
+
+#define SQL_EXTEND_VERSION "\
+UPDATE \
+	statsrepo.version v \
+SET \
+	last_snapid = $1 \
+WHERE \
+	v.instid = (SELECT instid FROM statsrepo.snapshot WHERE snapid = $1) AND \
+	v.dbid = $2 AND \
+	v.kind = $3 AND \
+	v.first_snapid = ( \
+		SELECT pg_catalog.max(first_snapid) FROM statsrepo.version \
+		WHERE instid = v.instid AND dbid = $2 AND kind = $3)"
+
+#define SQL_INSERT_VERSION "\
+INSERT INTO statsrepo.version \
+SELECT instid, $2, $3, $1, $1 FROM statsrepo.snapshot WHERE snapid = $1"
+
+/* one of $1 advisory locks shared by the agents, looked up from $2 */
+#define SQL_TRY_WRITE_SLOT "\
+SELECT statsrepo.try_write_slot($1, $2)"
+
+#define SQL_WAIT_WRITE_SLOT "\
+SELECT pg_catalog.pg_advisory_xact_lock( \
+	pg_catalog.hashtext('statsrepo.write_slot'), \
+	($2::bigint % $1::integer)::integer)"
+
 #define SQL_CREATE_SNAPSHOT_PARTITION "\
 SELECT statsrepo.create_snapshot_partition($1)"
 
 #define SQL_CREATE_REPOLOG_PARTITION "\
 SELECT statsrepo.create_repolog_partition($1)"
 
+#define SQL_CREATE_INSTANCE_TS_PARTITION "\
+SELECT statsrepo.create_instance_ts_partition($1)"
+
 #define SQL_INSERT_WAIT_SAMPLING_PROFILE "\
 INSERT INTO statsrepo.wait_sampling VALUES ($1, $2, $3, $4, $5, $6, $7, $8)"
 
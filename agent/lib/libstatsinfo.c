@@ -14,12 +14,16 @@
 #include <sys/wait.h>
 #include <time.h>
 #include <float.h>
+#include <math.h>
 
 #include "access/hash.h"
 #include "access/heapam.h"
+#include "access/xlog.h"
+#include "access/xlogrecovery.h"
 #include "catalog/pg_type.h"
 #include "catalog/pg_control.h"
 #include "catalog/pg_tablespace.h"
+#include "commands/progress.h"
 #include "funcapi.h"
 #include "libpq/pqsignal.h"
 #include "mb/pg_wchar.h"
@@ -30,6 +34,9 @@
 #include "postmaster/syslogger.h"
 #include "postmaster/fork_process.h"
 #include "postmaster/postmaster.h"
+#include "replication/slot.h"
+#include "replication/walsender.h"
+#include "replication/walsender_private.h"
 #include "storage/ipc.h"
 #include "storage/proc.h"
 #include "storage/procarray.h"
@@ -156,6 +163,10 @@ default_log_maintenance_command(void)
 #define DEFAULT_SAMPLING_INTERVAL			5		/* sec */
 #define DEFAULT_WAIT_SAMPLING_INTERVAL			10		/* msec */
 #define DEFAULT_SNAPSHOT_INTERVAL			600		/* sec */
+#define DEFAULT_SNAPSHOT_PARALLELISM		1
+#define DEFAULT_CONNECTION_POOL_IDLE_TIMEOUT	900		/* sec */
+#define DEFAULT_ESCALATION_INTERVAL			10		/* sec */
+#define DEFAULT_ESCALATION_DURATION			300		/* sec */
 #define DEFAULT_SYSLOG_LEVEL				DISABLE
 #define DEFAULT_TEXTLOG_LEVEL				WARNING
 #define DEFAULT_REPOLOG_LEVEL				WARNING
@@ -167,9 +178,17 @@ default_log_maintenance_command(void)
 #define DEFAULT_LOG_MAINTENANCE_COMMAND		default_log_maintenance_command()
 #define DEFAULT_LONG_LOCK_THRESHOLD			30		/* sec */
 #define DEFAULT_STAT_STATEMENTS_MAX			30
+#define DEFAULT_BUFFERCACHE_MAX				50
+#define DEFAULT_PARTITION_ROLLUP_KEEP		10
+#define DEFAULT_WALINSPECT_MAX_SIZE			128		/* MB */
+#define DEFAULT_COPY_CHUNK_SIZE				64		/* kB */
 #define DEFAULT_CONTROLFILE_FSYNC_INTERVAL	60		/* sec */
 #define DEFAULT_LONG_TRANSACTION_MAX		10
 #define LONG_TRANSACTION_THRESHOLD			1.0		/* sec */
+#define DEFAULT_BACKEND_MEMORY_MAX			10
+#define DEFAULT_LOCK_WAIT_MAX				100
+#define DEFAULT_PROGRESS_MAX				100
+#define DEFAULT_BACKEND_MEMORY_LOG_THRESHOLD	0		/* MB */
 #define DEFAULT_ENABLE_MAINTENANCE			"on"	/* snapshot + log */
 #define DEFAULT_WAIT_SAMPLING_QUERIES				true
 #define DEFAULT_WAIT_SAMPLING_MAX					25000
@@ -216,12 +235,34 @@ static const char *const RELOAD_PARAM_NAMES[] =
 	"syslog_ident",
 	GUC_PREFIX ".excluded_dbnames",
 	GUC_PREFIX ".excluded_schemas",
+	GUC_PREFIX ".partition_rollup",
 	GUC_PREFIX ".stat_statements_max",
 	GUC_PREFIX ".stat_statements_exclude_users",
+	GUC_PREFIX ".stat_statements_delta",
+	GUC_PREFIX ".stat_statements_top",
+	GUC_PREFIX ".buffercache_max",
+	GUC_PREFIX ".walinspect_max_size",
+	GUC_PREFIX ".copy_chunk_size",
+	GUC_PREFIX ".snapshot_streaming",
+	GUC_PREFIX ".snapshot_chunk_rows",
+	GUC_PREFIX ".snapshot_skip_idle",
+	GUC_PREFIX ".snapshot_budget",
 	GUC_PREFIX ".repository_server",
 	GUC_PREFIX ".sampling_interval",
 	GUC_PREFIX ".wait_sampling_interval",
 	GUC_PREFIX ".snapshot_interval",
+	GUC_PREFIX ".snapshot_parallelism",
+	GUC_PREFIX ".connection_pool_size",
+	GUC_PREFIX ".connection_pool_idle_timeout",
+	GUC_PREFIX ".snapshot_jitter",
+	GUC_PREFIX ".repository_write_slots",
+	GUC_PREFIX ".mini_snapshot_interval",
+	GUC_PREFIX ".escalation_interval",
+	GUC_PREFIX ".escalation_duration",
+	GUC_PREFIX ".escalation_waiting_sessions",
+	GUC_PREFIX ".escalation_replication_lag",
+	GUC_PREFIX ".escalation_cpu_usage",
+	GUC_PREFIX ".escalation_on_alert",
 	GUC_PREFIX ".syslog_line_prefix",
 	GUC_PREFIX ".syslog_min_messages",
 	GUC_PREFIX ".textlog_min_messages",
@@ -260,10 +301,24 @@ static const char *const RELOAD_PARAM_NAMES[] =
 
 static char	   *excluded_dbnames = NULL;
 static char	   *excluded_schemas = NULL;
+static char	   *partition_rollup = NULL;
+static int		partition_rollup_keep = DEFAULT_PARTITION_ROLLUP_KEEP;
 static char	   *repository_server = NULL;
 static int		sampling_interval = DEFAULT_SAMPLING_INTERVAL;
 static int		wait_sampling_interval = DEFAULT_WAIT_SAMPLING_INTERVAL;
 static int		snapshot_interval = DEFAULT_SNAPSHOT_INTERVAL;
+static int		snapshot_parallelism = DEFAULT_SNAPSHOT_PARALLELISM;
+static int		connection_pool_size = 0;
+static int		connection_pool_idle_timeout = DEFAULT_CONNECTION_POOL_IDLE_TIMEOUT;
+static int		snapshot_jitter = 0;
+static int		repository_write_slots = 0;
+static int		mini_snapshot_interval = 0;
+static int		escalation_interval = DEFAULT_ESCALATION_INTERVAL;
+static int		escalation_duration = DEFAULT_ESCALATION_DURATION;
+static int		escalation_waiting_sessions = 0;
+static int		escalation_replication_lag = 0;
+static int		escalation_cpu_usage = 0;
+static bool		escalation_on_alert = false;
 static char	   *syslog_line_prefix = NULL;
 static int		syslog_min_messages = DEFAULT_SYSLOG_LEVEL;
 static char	   *textlog_filename = NULL;
@@ -290,7 +345,20 @@ static char	   *log_maintenance_command = NULL;
 static int		long_lock_threshold = DEFAULT_LONG_LOCK_THRESHOLD;
 static int		stat_statements_max = DEFAULT_STAT_STATEMENTS_MAX;
 static char	   *stat_statements_exclude_users = NULL;
+static bool		stat_statements_delta = false;
+static int		stat_statements_top = 0;
+static int		buffercache_max = DEFAULT_BUFFERCACHE_MAX;
+static int		walinspect_max_size = DEFAULT_WALINSPECT_MAX_SIZE;
+static int		copy_chunk_size = DEFAULT_COPY_CHUNK_SIZE;
+static bool		snapshot_streaming = false;
+static int		snapshot_chunk_rows = 0;
+static bool		snapshot_skip_idle = false;
+static int		snapshot_budget = 0;
 static int		long_transaction_max = DEFAULT_LONG_TRANSACTION_MAX;
+static int		backend_memory_max = DEFAULT_BACKEND_MEMORY_MAX;
+static int		backend_memory_log_threshold = DEFAULT_BACKEND_MEMORY_LOG_THRESHOLD;
+static int		lock_wait_max = DEFAULT_LOCK_WAIT_MAX;
+static int		progress_max = DEFAULT_PROGRESS_MAX;
 static int		controlfile_fsync_interval = DEFAULT_CONTROLFILE_FSYNC_INTERVAL;
 static bool		enable_alert = false;
 static char	   *target_server = NULL;
@@ -299,6 +367,7 @@ int				wait_sampling_max = DEFAULT_WAIT_SAMPLING_MAX;
 bool			wait_sampling_save = true;
 extern wait_samplingSharedState	*wait_sampling;
 static bool		collect_column = true;
+static int		collect_column_rotation = 1;
 static bool		collect_index = true;
 
 int		rusage_max = 0;
@@ -314,6 +383,11 @@ PG_FUNCTION_INFO_V1(statsinfo_sample_wait_sampling_reset);
 PG_FUNCTION_INFO_V1(statsinfo_sample_wait_sampling_info);
 PG_FUNCTION_INFO_V1(statsinfo_activity);
 PG_FUNCTION_INFO_V1(statsinfo_long_xact);
+PG_FUNCTION_INFO_V1(statsinfo_backend_memory);
+PG_FUNCTION_INFO_V1(statsinfo_lock_waits);
+PG_FUNCTION_INFO_V1(statsinfo_replication_lag);
+PG_FUNCTION_INFO_V1(statsinfo_replication_slot_retention);
+PG_FUNCTION_INFO_V1(statsinfo_progress);
 PG_FUNCTION_INFO_V1(statsinfo_snapshot);
 PG_FUNCTION_INFO_V1(statsinfo_maintenance);
 PG_FUNCTION_INFO_V1(statsinfo_wait_sampling_profile);
@@ -335,6 +409,11 @@ extern Datum PGUT_EXPORT statsinfo_sample_wait_sampling_reset(PG_FUNCTION_ARGS);
 extern Datum PGUT_EXPORT statsinfo_sample_wait_sampling_info(PG_FUNCTION_ARGS);
 extern Datum PGUT_EXPORT statsinfo_activity(PG_FUNCTION_ARGS);
 extern Datum PGUT_EXPORT statsinfo_long_xact(PG_FUNCTION_ARGS);
+extern Datum PGUT_EXPORT statsinfo_backend_memory(PG_FUNCTION_ARGS);
+extern Datum PGUT_EXPORT statsinfo_lock_waits(PG_FUNCTION_ARGS);
+extern Datum PGUT_EXPORT statsinfo_replication_lag(PG_FUNCTION_ARGS);
+extern Datum PGUT_EXPORT statsinfo_replication_slot_retention(PG_FUNCTION_ARGS);
+extern Datum PGUT_EXPORT statsinfo_progress(PG_FUNCTION_ARGS);
 extern Datum PGUT_EXPORT statsinfo_snapshot(PG_FUNCTION_ARGS);
 extern Datum PGUT_EXPORT statsinfo_maintenance(PG_FUNCTION_ARGS);
 extern Datum PGUT_EXPORT statsinfo_wait_sampling_profile(PG_FUNCTION_ARGS);
@@ -393,6 +472,135 @@ typedef struct LongXactEntry
 	/* Note: the allocated length of query[] is actually pgstat_track_activity_query_size */
 } LongXactEntry;
 
+/* hashtable key for backend memory */
+typedef struct BackendMemoryHashKey
+{
+	int				pid;
+	TimestampTz		start;		/* backend start time */
+} BackendMemoryHashKey;
+
+/* hashtable entry for backend memory */
+typedef struct BackendMemoryEntry
+{
+	BackendMemoryHashKey	key;	/* hash key of entry - MUST BE FIRST */
+	BackendType		backend_type;
+	Oid				dbid;
+	Oid				userid;
+	int64			queryid;	/* query running at the peak */
+	int64			rss;		/* resident set size at the peak, in bytes */
+	int64			anon;		/* anonymous resident memory at the peak, in bytes */
+	int64			swap;		/* swapped-out memory at the peak, in bytes */
+	TimestampTz		peak_time;
+	bool			logged;		/* memory contexts already logged? */
+	char			query[1];	/* VARIABLE LENGTH ARRAY - MUST BE LAST */
+	/* Note: the allocated length of query[] is actually pgstat_track_activity_query_size */
+} BackendMemoryEntry;
+
+/* hashtable entry for backend whose memory contexts have been logged */
+typedef struct MemoryLoggedEntry
+{
+	BackendMemoryHashKey	key;	/* hash key of entry - MUST BE FIRST */
+	int64			queryid;	/* query running when the contexts were logged */
+	TimestampTz		last_seen;	/* last sample in which the backend was alive */
+} MemoryLoggedEntry;
+
+/* samples of a value kept between snapshots */
+#define SERIES_SAMPLES		720		/* an hour of the default sampling_interval */
+
+typedef struct SampleSeries
+{
+	int64	min;
+	int64	max;
+	int64	count;						/* number of samples added */
+	int64	values[SERIES_SAMPLES];		/* ring buffer of the latest samples */
+} SampleSeries;
+
+/* hashtable key for replication lag */
+typedef struct ReplicationLagHashKey
+{
+	int				pid;		/* pid of the walsender */
+	TimestampTz		start;		/* walsender start time */
+} ReplicationLagHashKey;
+
+/* hashtable entry for replication lag */
+typedef struct ReplicationLagEntry
+{
+	ReplicationLagHashKey	key;	/* hash key of entry - MUST BE FIRST */
+	char			application_name[NAMEDATALEN];
+	int				samples;
+	SampleSeries	write_lag;		/* in usec */
+	SampleSeries	flush_lag;		/* in usec */
+	SampleSeries	replay_lag;		/* in usec */
+} ReplicationLagEntry;
+
+/* hashtable entry for WAL retention of replication slot */
+typedef struct SlotRetentionEntry
+{
+	NameData		slot_name;	/* hash key of entry - MUST BE FIRST */
+	SampleSeries	retained;	/* in bytes */
+} SlotRetentionEntry;
+
+/* progress of an operation reported through pg_stat_progress_* */
+#define MAX_PROGRESS_PHASES		16
+
+typedef struct ProgressPhase
+{
+	int				phase;
+	TimestampTz		start;			/* first sample in the phase */
+	TimestampTz		end;			/* last sample in the phase */
+	int64			blocks_total;
+	int64			blocks_start;	/* blocks done at the first sample */
+	int64			blocks_end;		/* blocks done at the last sample */
+} ProgressPhase;
+
+/* hashtable entry for progress of an operation */
+typedef struct ProgressEntry
+{
+	int64			opid;		/* hash key of entry - MUST BE FIRST */
+	int				pid;
+	ProgressCommandType command;
+	int				subcommand;	/* e.g. CLUSTER or VACUUM FULL */
+	Oid				dbid;
+	Oid				relid;
+	TimestampTz		start;		/* first sample of the operation */
+	TimestampTz		last_seen;	/* last sample of the operation */
+	bool			seen;		/* seen in the current sample? */
+	int				nphases;
+	ProgressPhase	phases[MAX_PROGRESS_PHASES];
+} ProgressEntry;
+
+/* hashtable entry for operation in progress */
+typedef struct ProgressActiveEntry
+{
+	int				pid;		/* hash key of entry - MUST BE FIRST */
+	ProgressEntry	op;
+} ProgressActiveEntry;
+
+/* hashtable key for lock wait */
+typedef struct LockWaitHashKey
+{
+	int				blockee_pid;
+	int				blocker_pid;
+	TimestampTz		waitstart;	/* lock wait start time of the blockee */
+} LockWaitHashKey;
+
+/* hashtable entry for lock wait */
+typedef struct LockWaitEntry
+{
+	LockWaitHashKey	key;		/* hash key of entry - MUST BE FIRST */
+	Oid				dbid;
+	Oid				relation;	/* waited relation, or InvalidOid */
+	TransactionId	xid;		/* waited transaction, or InvalidTransactionId */
+	uint32			wait_event_info;
+	TimestampTz		last_seen;	/* last sample in which the blockee waited */
+	int				samples;	/* number of samples observing the wait */
+	char			queries[1];	/* VARIABLE LENGTH ARRAY - MUST BE LAST */
+	/* Note: queries[] holds blockee and blocker queries, each of pgstat_track_activity_query_size */
+} LockWaitEntry;
+
+#define LW_BLOCKEE_QUERY(entry)	((entry)->queries)
+#define LW_BLOCKER_QUERY(entry)	((entry)->queries + pgstat_track_activity_query_size)
+
 /* structures describing the devices and partitions */
 typedef struct DiskStats
 {
@@ -452,6 +660,22 @@ static void sil_sigchld_handler(SIGNAL_ARGS);
 static pid_t exec_background_process(char cmd[], int *outStdin);
 static void sample_activity(void);
 static void sample_diskstats(void);
+static void sample_backend_memory(void);
+static bool parse_proc_status(int pid, int64 *rss, int64 *anon, int64 *swap);
+static void sample_lock_waits(void);
+static void sample_replication(void);
+static void sample_progress(void);
+static void progress_track(ProgressEntry *entry, PgBackendStatus *be, TimestampTz now);
+static void progress_finish(ProgressEntry *entry);
+static const char *progress_command_name(const ProgressEntry *entry);
+static const char *progress_phase_name(const ProgressEntry *entry, int phase);
+static void series_add(SampleSeries *series, int64 value);
+static int64 series_percentile(const SampleSeries *series, double fraction);
+static int series_value_cmp(const void *lhs, const void *rhs);
+static Datum lag_interval(int64 usec);
+static int get_lock_blockers(LockData *lockData, int blockee_pid,
+							 int **blockers, LOCKTAG *locktag);
+static PgBackendStatus *find_beentry(int pid);
 static void parse_diskstats(HTAB *diskstats);
 static void must_be_superuser(void);
 static int get_devinfo(const char *path, Datum values[], bool nulls[]);
@@ -475,6 +699,16 @@ static int lx_match_fn(const void *key1, const void *key2, Size keysize);
 static LongXactEntry *lx_entry_alloc(LongXactHashKey *key, PgBackendStatus *be);
 static void lx_entry_dealloc(void);
 static int lx_entry_cmp(const void *lhs, const void *rhs);
+static uint32 bm_hash_fn(const void *key, Size keysize);
+static int bm_match_fn(const void *key1, const void *key2, Size keysize);
+static void bm_entry_dealloc(void);
+static int bm_entry_cmp(const void *lhs, const void *rhs);
+static uint32 lw_hash_fn(const void *key, Size keysize);
+static int lw_match_fn(const void *key1, const void *key2, Size keysize);
+static void lw_entry_dealloc(void);
+static int lw_entry_cmp(const void *lhs, const void *rhs);
+static void pr_entry_dealloc(void);
+static int pr_entry_cmp(const void *lhs, const void *rhs);
 static uint32 ds_hash_fn(const void *key, Size keysize);
 static int ds_match_fn(const void *key1, const void *key2, Size keysize);
 static void sample_waits(void);
@@ -509,6 +743,14 @@ static shmem_startup_hook_type	prev_shmem_startup_hook = NULL;
 static Activity		 activity = { 0, 0, 0, 0, 0, 0 };
 static HTAB			*long_xacts = NULL;
 static HTAB			*diskstats = NULL;
+static HTAB			*backend_memory = NULL;
+static HTAB			*memory_logged = NULL;
+static HTAB			*lock_waits = NULL;
+static HTAB			*replication_lags = NULL;
+static HTAB			*slot_retentions = NULL;
+static HTAB			*progress_active = NULL;	/* keyed by pid */
+static HTAB			*progress_done = NULL;		/* keyed by opid */
+static int64		 progress_next_opid = 1;
 HTAB				*wait_sampling_hash = NULL;
 
 
@@ -529,6 +771,10 @@ statsinfo_sample(PG_FUNCTION_ARGS)
 
 	sample_activity();
 	sample_diskstats();
+	sample_backend_memory();
+	sample_lock_waits();
+	sample_replication();
+	sample_progress();
 
 	PG_RETURN_VOID();
 }
@@ -711,7 +957,11 @@ sample_activity(void)
 		if (duration < LONG_TRANSACTION_THRESHOLD)
 			continue;
 
-		/* XXX: needs lock? */
+		/*
+		 * BackendPidGetProc() takes ProcArrayLock by itself. statusFlags is
+		 * read without the lock as pg_stat_get_activity() reads wait events;
+		 * a stale value only misclassifies the transaction in this sample.
+		 */
 		if ((proc = BackendPidGetProc(be->st_procpid)) == NULL ||
 			(proc->statusFlags & PROC_IN_VACUUM))
 			continue;
@@ -769,222 +1019,1582 @@ sample_diskstats(void)
 	parse_diskstats(diskstats);
 }
 
+/*
+ * sample_backend_memory - remember the memory peak of the largest backends.
+ *
+ * Backends are ranked by anonymous resident memory, which is where work_mem
+ * and the backend-local caches live; VmRSS also counts the pages of shared
+ * buffers the backend has touched. Memory contexts of another backend can't
+ * be read from here, so a backend crossing backend_memory_log_threshold is
+ * asked to dump its contexts into the server log once.
+ */
 static void
-check_io_peak(DiskStatsEntry *entry, unsigned long rd_sec,
-			  unsigned long wr_sec, time_t duration)
+sample_backend_memory(void)
 {
-	float8	calc;
+	TimestampTz	now;
+	int			i;
 
-	if (duration <= 0)
+	if (backend_memory_max <= 0)
 		return;
 
-	if (rd_sec >= entry->stats.rd_sectors)
+	if (!backend_memory)
 	{
-		calc = (float8) (rd_sec - entry->stats.rd_sectors) / duration;
-		if (calc > entry->drs_ps_max)
-			entry->drs_ps_max = calc;
+		/* create hash table when first needed */
+		HASHCTL		ctl;
+
+		ctl.keysize = sizeof(BackendMemoryHashKey);
+		ctl.entrysize = offsetof(BackendMemoryEntry, query) +
+							pgstat_track_activity_query_size;
+		ctl.hash = bm_hash_fn;
+		ctl.match = bm_match_fn;
+		backend_memory = hash_create("Backend Memory",
+									 backend_memory_max, &ctl,
+									 HASH_ELEM | HASH_FUNCTION | HASH_COMPARE);
+
+		/* kept across snapshots, unlike the peaks */
+		ctl.entrysize = sizeof(MemoryLoggedEntry);
+		memory_logged = hash_create("Backend Memory Logged",
+									backend_memory_max, &ctl,
+									HASH_ELEM | HASH_FUNCTION | HASH_COMPARE);
 	}
-	if (wr_sec >= entry->stats.wr_sectors)
+
+	now = GetCurrentTimestamp();
+
+	for (i = pgstat_fetch_stat_numbackends(); i > 0; i--)
 	{
-		calc = (float8) (wr_sec - entry->stats.wr_sectors) / duration;
-		if (calc > entry->dws_ps_max)
-			entry->dws_ps_max = calc;
-	}
-}
+		LocalPgBackendStatus *lbe;
+		PgBackendStatus    *be;
+		BackendMemoryHashKey key;
+		BackendMemoryEntry *entry;
+		MemoryLoggedEntry  *logged;
+		int64				rss;
+		int64				anon;
+		int64				swap;
+		bool				found;
 
-static void
-check_io_overflow(DiskStatsEntry *entry, unsigned long rd_sec,
-				  unsigned long wr_sec, unsigned int rd_ticks,
-				  unsigned int wr_ticks, unsigned int rq_ticks)
-{
-	if (entry->stats.rd_sectors > rd_sec)
-		entry->overflow_drs++;
-	if (entry->stats.wr_sectors > wr_sec)
-		entry->overflow_dws++;
-	if (entry->stats.rd_ticks > rd_ticks)
-		entry->overflow_drt++;
-	if (entry->stats.wr_ticks > wr_ticks)
-		entry->overflow_dwt++;
-	if (entry->stats.rq_ticks > rq_ticks)
-		entry->overflow_dit++;
-}
+		lbe = pgstat_get_local_beentry_by_index(i);
+		be = &lbe->backendStatus;
 
-#define FILE_DISKSTATS					"/proc/diskstats"
-#define NUM_DISKSTATS_FIELDS			14
-#define NUM_DISKSTATS_PARTITION_FIELDS	7
+		if (!be || be->st_procpid == 0 || be->st_procpid == MyProcPid)
+			continue;
 
-static void
-parse_diskstats(HTAB *htab)
-{
-	FILE			*fp;
-	char			 line[256];
-	char			 dev_name[128];
-	unsigned int	 dev_major, dev_minor;
-	unsigned int	 ios_pgr, tot_ticks, rq_ticks, wr_ticks;
-	unsigned long	 rd_ios, rd_merges_or_rd_sec, rd_ticks_or_wr_sec, wr_ios;
-	unsigned long	 wr_merges, rd_sec_or_wr_ios, wr_sec;
-	DiskStatsHashKey key;
-	DiskStatsEntry	*entry;
-	bool			 found;
-	int				 i;
-	time_t			 now;
+		if (!parse_proc_status(be->st_procpid, &rss, &anon, &swap))
+			continue;	/* This backend is dead */
 
-	if ((fp = fopen(FILE_DISKSTATS, "r")) == NULL)
-		ereport(ERROR,
-			(errcode_for_file_access(),
-			 errmsg("could not open file \"%s\": ", FILE_DISKSTATS)));
+		/* set up key for hashtable search */
+		key.pid = be->st_procpid;
+		key.start = be->st_proc_start_timestamp;
 
-	now = time(NULL);
+		logged = (MemoryLoggedEntry *)
+			hash_search(memory_logged, &key, HASH_FIND, NULL);
+		if (logged)
+			logged->last_seen = now;
 
-	while (fgets(line, sizeof(line), fp) != NULL)
-	{
-		/* major minor name rio rmerge rsect ruse wio wmerge wsect wuse running use aveq */
-		i = sscanf(line, "%u %u %s %lu %lu %lu %lu %lu %lu %lu %u %u %u %u",
-				&dev_major, &dev_minor, dev_name,
-				&rd_ios, &rd_merges_or_rd_sec, &rd_sec_or_wr_ios, &rd_ticks_or_wr_sec,
-				&wr_ios, &wr_merges, &wr_sec, &wr_ticks, &ios_pgr, &tot_ticks, &rq_ticks);
+		/* lookup the hash table entry, and keep it only when it grows */
+		entry = (BackendMemoryEntry *)
+			hash_search(backend_memory, &key, HASH_ENTER, &found);
 
-		if (i != NUM_DISKSTATS_FIELDS &&
-			i != NUM_DISKSTATS_PARTITION_FIELDS)
-			/* unknown entry: ignore it */
+		if (!found)
+			entry->logged = false;
+		else if (anon <= entry->anon)
 			continue;
 
-		/* lookup the hash table entry */
-		key.dev_major = dev_major;
-		key.dev_minor = dev_minor;
-		entry = (DiskStatsEntry *) hash_search(htab, &key, HASH_ENTER, &found);
+		entry->backend_type = be->st_backendType;
+		entry->dbid = be->st_databaseid;
+		entry->userid = be->st_userid;
+		entry->queryid = be->st_query_id;
+		entry->rss = rss;
+		entry->anon = anon;
+		entry->swap = swap;
+		entry->peak_time = now;
+		strlcpy(entry->query,
+			be->st_activity_raw, pgstat_track_activity_query_size);
 
-		if (found)
+		/*
+		 * The contexts are logged again only when the backend has moved on
+		 * to another query, since the peaks are reported on every snapshot.
+		 */
+		if (backend_memory_log_threshold > 0 &&
+			anon >= (int64) backend_memory_log_threshold * 1024 * 1024)
 		{
-			/* check I/O peak and overflow if there is previous sample */
-			time_t duration;
-
-			duration = now - entry->timestamp;
-			if (i == NUM_DISKSTATS_FIELDS)
+			if (!logged)
 			{
-				check_io_peak(entry, rd_sec_or_wr_ios, wr_sec, duration);
-				check_io_overflow(entry, rd_sec_or_wr_ios, wr_sec,
-					rd_ticks_or_wr_sec, wr_ticks, rq_ticks);
+				logged = (MemoryLoggedEntry *)
+					hash_search(memory_logged, &key, HASH_ENTER, NULL);
+				logged->last_seen = now;
 			}
-			else
+			else if (logged->queryid == entry->queryid)
 			{
-				check_io_peak(entry, rd_merges_or_rd_sec, rd_ticks_or_wr_sec, duration);
-				check_io_overflow(entry, rd_merges_or_rd_sec,
-					rd_ticks_or_wr_sec, 0, 0, 0);
+				entry->logged = true;
+				continue;
 			}
-		}
-		else
-		{
-			/* initialize new entry */
-			memset(&entry->stats, 0, sizeof(entry->stats));
-			entry->field_num = i;
-			entry->stats.dev_major = dev_major;
-			entry->stats.dev_minor = dev_minor;
-			strlcpy(entry->stats.dev_name, dev_name, sizeof(entry->stats.dev_name));
-			entry->drs_ps_max = 0;
-			entry->dws_ps_max = 0;
-			entry->overflow_drs = 0;
-			entry->overflow_drt = 0;
-			entry->overflow_dws = 0;
-			entry->overflow_dwt = 0;
-			entry->overflow_dit = 0;
-		}
 
-		/* set I/O statistics */
-		if (i == NUM_DISKSTATS_FIELDS)
-		{
-			/* device or partition */
-			entry->stats.rd_ios     = rd_ios;				/* Field 1 -- # of reads completed */
-			entry->stats.rd_merges  = rd_merges_or_rd_sec;	/* Field 2 -- # of reads merged */
-			entry->stats.rd_sectors = rd_sec_or_wr_ios;		/* Field 3 -- # of sectors read */
-			entry->stats.rd_ticks   = (unsigned int) rd_ticks_or_wr_sec;	/* Field 4 -- # of milliseconds spent reading */
-			entry->stats.wr_ios     = wr_ios;				/* Field 5 -- # of writes completed */
-			entry->stats.wr_merges  = wr_merges;			/* Field 6 -- # of writes merged */
-			entry->stats.wr_sectors = wr_sec;				/* Field 7 -- # of sectors written */
-			entry->stats.wr_ticks   = wr_ticks;				/* Field 8 -- # of milliseconds spent writing  */
-			entry->stats.ios_pgr    = ios_pgr;				/* Field 9 -- # of I/Os currently in progress */
-			entry->stats.tot_ticks  = tot_ticks;			/* Field 10 -- # of milliseconds spent doing I/Os */
-			entry->stats.rq_ticks   = rq_ticks;				/* Field 11 -- weighted # of milliseconds spent doing I/Os */
-		}
-		else
-		{
-			/* partition without extended statistics */
-			entry->stats.rd_ios     = rd_ios;				/* Field 1 -- # of reads issued */
-			entry->stats.rd_sectors = rd_merges_or_rd_sec;	/* Field 2 -- # of sectors read */
-			entry->stats.wr_ios     = rd_sec_or_wr_ios;		/* Field 3 -- # of writes issued */
-			entry->stats.wr_sectors = rd_ticks_or_wr_sec;	/* Field 4 -- # of sectors written */
+			DirectFunctionCall1(pg_log_backend_memory_contexts,
+								Int32GetDatum(entry->key.pid));
+			logged->queryid = entry->queryid;
+			entry->logged = true;
 		}
-		entry->timestamp = now;
 	}
 
-	if (ferror(fp) && errno != EINTR)
+	/* forget the backends which have exited */
+	if (hash_get_num_entries(memory_logged) > 0)
 	{
-		fclose(fp);
-		ereport(ERROR,
-			(errcode_for_file_access(),
-			 errmsg("could not read file \"%s\": ", FILE_DISKSTATS)));
+		HASH_SEQ_STATUS		hash_seq;
+		MemoryLoggedEntry  *logged;
+
+		hash_seq_init(&hash_seq, memory_logged);
+		while ((logged = hash_seq_search(&hash_seq)) != NULL)
+		{
+			if (logged->last_seen != now)
+				hash_search(memory_logged, &logged->key, HASH_REMOVE, NULL);
+		}
 	}
 
-	fclose(fp);
+	bm_entry_dealloc();
 }
 
-#define NUM_ACTIVITY_COLS		5
-
 /*
- * statsinfo_activity - accumulate sampled counters.
+ * sample_lock_waits - accumulate blocker and blockee pairs of lock waits.
+ *
+ * A pair is identified with the start of the lock wait, so the time the
+ * blockee has been blocked is last_seen - waitstart. The lock manager is
+ * read once per sample, and only when some backend is waiting for a lock.
  */
-Datum
-statsinfo_activity(PG_FUNCTION_ARGS)
+static void
+sample_lock_waits(void)
 {
-	TupleDesc	tupdesc;
-	HeapTuple	tuple;
-	Datum		values[NUM_ACTIVITY_COLS];
-	bool		nulls[NUM_ACTIVITY_COLS];
+	TimestampTz	now;
+	LockData   *lockData = NULL;
 	int			i;
 
-	must_be_superuser();
+	if (!lock_waits)
+	{
+		/* create hash table when first needed */
+		HASHCTL		ctl;
 
-	/* Build a tuple descriptor for our result type */
-	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
-		elog(ERROR, "return type must be a row type");
+		ctl.keysize = sizeof(LockWaitHashKey);
+		ctl.entrysize = offsetof(LockWaitEntry, queries) +
+							pgstat_track_activity_query_size * 2;
+		ctl.hash = lw_hash_fn;
+		ctl.match = lw_match_fn;
+		lock_waits = hash_create("Lock Wait",
+								 lock_wait_max, &ctl,
+								 HASH_ELEM | HASH_FUNCTION | HASH_COMPARE);
+	}
 
-	Assert(tupdesc->natts == lengthof(values));
+	now = GetCurrentTimestamp();
 
-	if (activity.samples > 0)
+	for (i = pgstat_fetch_stat_numbackends(); i > 0; i--)
 	{
+		LocalPgBackendStatus *lbe;
+		PgBackendStatus    *be;
+		PGPROC			   *proc;
+		TimestampTz			waitstart;
+		uint32				wait_event_info;
+		LOCKTAG				locktag;
+		int				   *blockers;
+		int					nblockers;
+		int					j;
 
-		memset(nulls, 0, sizeof(nulls));
+		lbe = pgstat_get_local_beentry_by_index(i);
+		be = &lbe->backendStatus;
 
-		i = 0;
-		values[i++] = Int32GetDatum(activity.idle);
-		values[i++] = Int32GetDatum(activity.idle_in_xact);
-		values[i++] = Int32GetDatum(activity.waiting);
-		values[i++] = Int32GetDatum(activity.running);
-		values[i++] = Int32GetDatum(activity.max_backends);
+		if (!be || be->st_procpid == 0 || be->st_procpid == MyProcPid)
+			continue;
 
-		Assert(i == lengthof(values));
+		/*
+		 * No lock is held over the PGPROC, like pg_stat_get_activity(). The
+		 * lock wait is checked again against the lock manager snapshot, so
+		 * a wait which has just ended is not sampled.
+		 */
+		if ((proc = BackendPidGetProc(be->st_procpid)) == NULL)
+			continue;	/* This backend is dead */
 
-		/* reset activity statistics */
-		memset(&activity, 0, sizeof(Activity));
+		wait_event_info = proc->wait_event_info;
+		if ((wait_event_info & 0xFF000000) != PG_WAIT_LOCK)
+			continue;
+
+		/* waitStart is set slightly after the wait begins */
+		waitstart = (TimestampTz) pg_atomic_read_u64(&proc->waitStart);
+		if (waitstart == 0)
+			continue;
+
+		if (lockData == NULL)
+			lockData = GetLockStatusData();
+
+		nblockers = get_lock_blockers(lockData, be->st_procpid,
+									  &blockers, &locktag);
+
+		for (j = 0; j < nblockers; j++)
+		{
+			LockWaitHashKey	 key;
+			LockWaitEntry	*entry;
+			PgBackendStatus	*blocker;
+			bool			 found;
+
+			/* set up key for hashtable search */
+			key.blockee_pid = be->st_procpid;
+			key.blocker_pid = blockers[j];
+			key.waitstart = waitstart;
+
+			entry = (LockWaitEntry *)
+				hash_search(lock_waits, &key, HASH_ENTER, &found);
+
+			/*
+			 * A blocker may be listed more than once, such as prepared
+			 * transactions which all have pid 0; count each pair once per
+			 * sample.
+			 */
+			if (found && entry->last_seen == now)
+				continue;
+
+			if (!found)
+			{
+				/* new entry, initialize it */
+				entry->dbid = be->st_databaseid;
+				entry->relation = InvalidOid;
+				entry->xid = InvalidTransactionId;
+				switch (locktag.locktag_type)
+				{
+					case LOCKTAG_RELATION:
+					case LOCKTAG_RELATION_EXTEND:
+					case LOCKTAG_PAGE:
+					case LOCKTAG_TUPLE:
+						entry->relation = locktag.locktag_field2;
+						break;
+					case LOCKTAG_TRANSACTION:
+						entry->xid = locktag.locktag_field1;
+						break;
+					default:
+						break;
+				}
+				entry->samples = 0;
+				strlcpy(LW_BLOCKEE_QUERY(entry),
+					be->st_activity_raw, pgstat_track_activity_query_size);
+				LW_BLOCKER_QUERY(entry)[0] = '\0';
+			}
+
+			/* the blocker may have moved on to the next query */
+			if ((blocker = find_beentry(blockers[j])) != NULL)
+				strlcpy(LW_BLOCKER_QUERY(entry),
+					blocker->st_activity_raw, pgstat_track_activity_query_size);
+
+			entry->wait_event_info = wait_event_info;
+			entry->last_seen = now;
+			entry->samples++;
+		}
+
+		if (blockers)
+			pfree(blockers);
 	}
-	else
+
+	if (lockData)
 	{
-		for (i = 0; i < lengthof(nulls); i++)
-			nulls[i] = true;
+		pfree(lockData->locks);
+		pfree(lockData);
 	}
 
-	tuple = heap_form_tuple(tupdesc, values, nulls);
+	lw_entry_dealloc();
+}
+
+/*
+ * sample_replication - accumulate replication lags of each walsender and
+ * WAL retained by each replication slot.
+ */
+static void
+sample_replication(void)
+{
+	XLogRecPtr	current;
+	int			i;
+
+	if (!replication_lags)
+	{
+		/* create hash tables when first needed */
+		HASHCTL		ctl;
+
+		ctl.keysize = sizeof(ReplicationLagHashKey);
+		ctl.entrysize = sizeof(ReplicationLagEntry);
+		replication_lags = hash_create("Replication Lag",
+									   Max(max_wal_senders, 1), &ctl,
+									   HASH_ELEM | HASH_BLOBS);
+
+		ctl.keysize = sizeof(NameData);
+		ctl.entrysize = sizeof(SlotRetentionEntry);
+		slot_retentions = hash_create("Slot Retention",
+									  Max(max_replication_slots, 1), &ctl,
+									  HASH_ELEM | HASH_STRINGS);
+	}
+
+	for (i = 0; i < max_wal_senders; i++)
+	{
+		WalSnd				*walsnd = &WalSndCtl->walsnds[i];
+		ReplicationLagHashKey key;
+		ReplicationLagEntry *entry;
+		PgBackendStatus		*be;
+		pid_t				 pid;
+		WalSndState			 state;
+		TimeOffset			 write_lag;
+		TimeOffset			 flush_lag;
+		TimeOffset			 replay_lag;
+		bool				 found;
+
+		SpinLockAcquire(&walsnd->mutex);
+		pid = walsnd->pid;
+		state = walsnd->state;
+		write_lag = walsnd->writeLag;
+		flush_lag = walsnd->flushLag;
+		replay_lag = walsnd->applyLag;
+		SpinLockRelease(&walsnd->mutex);
+
+		if (pid == 0 || state != WALSNDSTATE_STREAMING)
+			continue;
+
+		if ((be = find_beentry(pid)) == NULL)
+			continue;
+
+		/* set up key for hashtable search */
+		MemSet(&key, 0, sizeof(key));
+		key.pid = pid;
+		key.start = be->st_proc_start_timestamp;
+
+		entry = (ReplicationLagEntry *)
+			hash_search(replication_lags, &key, HASH_ENTER, &found);
+
+		if (!found)
+		{
+			/* new entry, initialize it */
+			strlcpy(entry->application_name, be->st_appname, NAMEDATALEN);
+			entry->samples = 0;
+			entry->write_lag.count = 0;
+			entry->flush_lag.count = 0;
+			entry->replay_lag.count = 0;
+		}
+
+		/* lag is -1 while the standby has caught up and been idle */
+		series_add(&entry->write_lag, Max(write_lag, 0));
+		series_add(&entry->flush_lag, Max(flush_lag, 0));
+		series_add(&entry->replay_lag, Max(replay_lag, 0));
+		entry->samples++;
+	}
+
+	if (max_replication_slots <= 0)
+		return;
+
+	current = RecoveryInProgress() ? GetXLogReplayRecPtr(NULL) : GetXLogInsertRecPtr();
+
+	LWLockAcquire(ReplicationSlotControlLock, LW_SHARED);
+	for (i = 0; i < max_replication_slots; i++)
+	{
+		ReplicationSlot		*slot = &ReplicationSlotCtl->replication_slots[i];
+		SlotRetentionEntry	*entry;
+		NameData			 slot_name;
+		XLogRecPtr			 restart_lsn;
+		bool				 found;
+
+		if (!slot->in_use)
+			continue;
+
+		SpinLockAcquire(&slot->mutex);
+		slot_name = slot->data.name;
+		restart_lsn = slot->data.restart_lsn;
+		SpinLockRelease(&slot->mutex);
+
+		if (XLogRecPtrIsInvalid(restart_lsn) || restart_lsn > current)
+			continue;
+
+		entry = (SlotRetentionEntry *)
+			hash_search(slot_retentions, NameStr(slot_name), HASH_ENTER, &found);
+
+		if (!found)
+			entry->retained.count = 0;
+
+		series_add(&entry->retained, (int64) (current - restart_lsn));
+	}
+	LWLockRelease(ReplicationSlotControlLock);
+}
+
+/*
+ * sample_progress - follow vacuum, analyze, cluster and index builds
+ * reported through the progress views.
+ *
+ * Each backend runs at most one of those operations at a time, so an
+ * operation in progress is tracked per pid.  It is regarded as completed
+ * when the backend no longer reports it, and then it is moved to the table
+ * of completed operations which statsinfo_progress() drains.
+ */
+static void
+sample_progress(void)
+{
+	HASH_SEQ_STATUS		 hash_seq;
+	ProgressActiveEntry	*active;
+	TimestampTz			 now;
+	int					 i;
+
+	if (!progress_active)
+	{
+		/* create hash tables when first needed */
+		HASHCTL		ctl;
+
+		ctl.keysize = sizeof(int);
+		ctl.entrysize = sizeof(ProgressActiveEntry);
+		progress_active = hash_create("Progress Active",
+									  32, &ctl,
+									  HASH_ELEM | HASH_BLOBS);
+
+		ctl.keysize = sizeof(int64);
+		ctl.entrysize = sizeof(ProgressEntry);
+		progress_done = hash_create("Progress Done",
+									progress_max, &ctl,
+									HASH_ELEM | HASH_BLOBS);
+	}
+
+	now = GetCurrentTimestamp();
+
+	hash_seq_init(&hash_seq, progress_active);
+	while ((active = hash_seq_search(&hash_seq)) != NULL)
+		active->op.seen = false;
+
+	for (i = pgstat_fetch_stat_numbackends(); i > 0; i--)
+	{
+		LocalPgBackendStatus *lbe;
+		PgBackendStatus    *be;
+		int					pid;
+		bool				found;
+
+		lbe = pgstat_get_local_beentry_by_index(i);
+		be = &lbe->backendStatus;
+
+		if (!be || be->st_procpid == 0)
+			continue;
+
+		switch (be->st_progress_command)
+		{
+			case PROGRESS_COMMAND_VACUUM:
+			case PROGRESS_COMMAND_ANALYZE:
+			case PROGRESS_COMMAND_CLUSTER:
+			case PROGRESS_COMMAND_CREATE_INDEX:
+				break;
+			default:
+				continue;	/* not a maintenance operation */
+		}
+
+		pid = be->st_procpid;
+		active = (ProgressActiveEntry *)
+			hash_search(progress_active, &pid, HASH_ENTER, &found);
+
+		/* the backend has moved on to another operation */
+		if (found &&
+			(active->op.command != be->st_progress_command ||
+			 active->op.relid != be->st_progress_command_target ||
+			 active->op.dbid != be->st_databaseid))
+		{
+			progress_finish(&active->op);
+			found = false;
+		}
+
+		if (!found)
+		{
+			/* new operation, initialize it */
+			memset(&active->op, 0, sizeof(ProgressEntry));
+			active->op.opid = progress_next_opid++;
+			active->op.pid = pid;
+			active->op.command = be->st_progress_command;
+			active->op.dbid = be->st_databaseid;
+			active->op.relid = be->st_progress_command_target;
+			active->op.start = now;
+		}
+
+		progress_track(&active->op, be, now);
+	}
+
+	/* operations no longer reported have completed */
+	hash_seq_init(&hash_seq, progress_active);
+	while ((active = hash_seq_search(&hash_seq)) != NULL)
+	{
+		if (active->op.seen)
+			continue;
+
+		progress_finish(&active->op);
+		hash_search(progress_active, &active->pid, HASH_REMOVE, NULL);
+	}
+
+	pr_entry_dealloc();
+}
+
+/*
+ * progress_track - record a sample of the operation into its phase curve.
+ */
+static void
+progress_track(ProgressEntry *entry, PgBackendStatus *be, TimestampTz now)
+{
+	const int64	   *param = be->st_progress_param;
+	ProgressPhase  *ph;
+	int				phase;
+	int64			total;
+	int64			done;
+
+	switch (entry->command)
+	{
+		case PROGRESS_COMMAND_VACUUM:
+			phase = (int) param[PROGRESS_VACUUM_PHASE];
+			total = param[PROGRESS_VACUUM_TOTAL_HEAP_BLKS];
+			if (phase == PROGRESS_VACUUM_PHASE_VACUUM_HEAP)
+				done = param[PROGRESS_VACUUM_HEAP_BLKS_VACUUMED];
+			else
+				done = param[PROGRESS_VACUUM_HEAP_BLKS_SCANNED];
+			break;
+		case PROGRESS_COMMAND_ANALYZE:
+			phase = (int) param[PROGRESS_ANALYZE_PHASE];
+			total = param[PROGRESS_ANALYZE_BLOCKS_TOTAL];
+			done = param[PROGRESS_ANALYZE_BLOCKS_DONE];
+			break;
+		case PROGRESS_COMMAND_CLUSTER:
+			entry->subcommand = (int) param[PROGRESS_CLUSTER_COMMAND];
+			phase = (int) param[PROGRESS_CLUSTER_PHASE];
+			total = param[PROGRESS_CLUSTER_TOTAL_HEAP_BLKS];
+			done = param[PROGRESS_CLUSTER_HEAP_BLKS_SCANNED];
+			break;
+		case PROGRESS_COMMAND_CREATE_INDEX:
+			entry->subcommand = (int) param[PROGRESS_CREATEIDX_COMMAND];
+			phase = (int) param[PROGRESS_CREATEIDX_PHASE];
+			total = param[PROGRESS_SCAN_BLOCKS_TOTAL];
+			done = param[PROGRESS_SCAN_BLOCKS_DONE];
+			break;
+		default:
+			return;
+	}
+
+	ph = (entry->nphases > 0) ? &entry->phases[entry->nphases - 1] : NULL;
+
+	/*
+	 * Start a new phase when the phase changes.  Phases can repeat (e.g.
+	 * index and heap vacuuming), so once the array is full the rest of the
+	 * operation is accounted to the last phase.
+	 */
+	if (ph == NULL ||
+		(ph->phase != phase && entry->nphases < MAX_PROGRESS_PHASES))
+	{
+		ph = &entry->phases[entry->nphases++];
+		ph->phase = phase;
+		ph->start = now;
+		ph->blocks_start = done;
+	}
+
+	ph->end = now;
+	ph->blocks_total = total;
+	ph->blocks_end = done;
+
+	entry->last_seen = now;
+	entry->seen = true;
+}
+
+/*
+ * progress_finish - move the operation to the table of completed operations.
+ */
+static void
+progress_finish(ProgressEntry *entry)
+{
+	ProgressEntry  *done;
+
+	done = (ProgressEntry *)
+		hash_search(progress_done, &entry->opid, HASH_ENTER, NULL);
+	memcpy(done, entry, sizeof(ProgressEntry));
+}
+
+/*
+ * progress_command_name - get the name of the command of the operation
+ */
+static const char *
+progress_command_name(const ProgressEntry *entry)
+{
+	switch (entry->command)
+	{
+		case PROGRESS_COMMAND_VACUUM:
+			return "VACUUM";
+		case PROGRESS_COMMAND_ANALYZE:
+			return "ANALYZE";
+		case PROGRESS_COMMAND_CLUSTER:
+			if (entry->subcommand == PROGRESS_CLUSTER_COMMAND_VACUUM_FULL)
+				return "VACUUM FULL";
+			return "CLUSTER";
+		case PROGRESS_COMMAND_CREATE_INDEX:
+			switch (entry->subcommand)
+			{
+				case PROGRESS_CREATEIDX_COMMAND_CREATE_CONCURRENTLY:
+					return "CREATE INDEX CONCURRENTLY";
+				case PROGRESS_CREATEIDX_COMMAND_REINDEX:
+					return "REINDEX";
+				case PROGRESS_CREATEIDX_COMMAND_REINDEX_CONCURRENTLY:
+					return "REINDEX CONCURRENTLY";
+				default:
+					return "CREATE INDEX";
+			}
+		default:
+			return "unknown";
+	}
+}
+
+/* phase names as shown in the pg_stat_progress_* views */
+static const char *const vacuum_phase_names[] =
+{
+	"initializing",
+	"scanning heap",
+	"vacuuming indexes",
+	"vacuuming heap",
+	"cleaning up indexes",
+	"truncating heap",
+	"performing final cleanup"
+};
+
+static const char *const analyze_phase_names[] =
+{
+	"initializing",
+	"acquiring sample rows",
+	"acquiring inherited sample rows",
+	"computing statistics",
+	"computing extended statistics",
+	"finalizing analyze"
+};
+
+static const char *const cluster_phase_names[] =
+{
+	"initializing",
+	"seq scanning heap",
+	"index scanning heap",
+	"sorting tuples",
+	"writing new heap",
+	"swapping relation files",
+	"rebuilding index",
+	"performing final cleanup"
+};
+
+static const char *const create_index_phase_names[] =
+{
+	"initializing",
+	"waiting for writers before build",
+	"building index",
+	"waiting for writers before validation",
+	"index validation: scanning index",
+	"index validation: sorting tuples",
+	"index validation: scanning table",
+	"waiting for old snapshots",
+	"waiting for readers before marking dead",
+	"waiting for readers before dropping"
+};
+
+/*
+ * progress_phase_name - get the name of the phase of the operation
+ */
+static const char *
+progress_phase_name(const ProgressEntry *entry, int phase)
+{
+	const char *const  *names;
+	int					nnames;
+
+	switch (entry->command)
+	{
+		case PROGRESS_COMMAND_VACUUM:
+			names = vacuum_phase_names;
+			nnames = lengthof(vacuum_phase_names);
+			break;
+		case PROGRESS_COMMAND_ANALYZE:
+			names = analyze_phase_names;
+			nnames = lengthof(analyze_phase_names);
+			break;
+		case PROGRESS_COMMAND_CLUSTER:
+			names = cluster_phase_names;
+			nnames = lengthof(cluster_phase_names);
+			break;
+		case PROGRESS_COMMAND_CREATE_INDEX:
+			names = create_index_phase_names;
+			nnames = lengthof(create_index_phase_names);
+			break;
+		default:
+			return "unknown";
+	}
+
+	if (phase < 0 || phase >= nnames)
+		return "unknown";
+	return names[phase];
+}
+
+/*
+ * series_add - add a sample to the series.
+ */
+static void
+series_add(SampleSeries *series, int64 value)
+{
+	if (series->count == 0 || value < series->min)
+		series->min = value;
+	if (series->count == 0 || value > series->max)
+		series->max = value;
+
+	series->values[series->count % SERIES_SAMPLES] = value;
+	series->count++;
+}
+
+/*
+ * series_percentile - get the percentile of the latest samples.
+ */
+static int64
+series_percentile(const SampleSeries *series, double fraction)
+{
+	int64	values[SERIES_SAMPLES];
+	int		n;
+	int		rank;
+
+	n = (int) Min(series->count, SERIES_SAMPLES);
+	if (n == 0)
+		return 0;
+
+	memcpy(values, series->values, n * sizeof(int64));
+	qsort(values, n, sizeof(int64), series_value_cmp);
+
+	rank = (int) ceil(fraction * n) - 1;
+
+	return values[Max(rank, 0)];
+}
+
+/*
+ * series_value_cmp - qsort comparator for sorting samples
+ */
+static int
+series_value_cmp(const void *lhs, const void *rhs)
+{
+	int64	l = *(const int64 *) lhs;
+	int64	r = *(const int64 *) rhs;
+
+	if (l < r)
+		return -1;
+	else if (l > r)
+		return +1;
+	else
+		return 0;
+}
+
+/*
+ * get_lock_blockers - list the backends blocking the lock wait of the blockee.
+ *
+ * This follows pg_blocking_pids(), but works on a snapshot of the whole lock
+ * manager taken by the caller, so that it can be shared by all waiters of a
+ * sample. The snapshot carries no wait queue, so a conflicting waiter is
+ * regarded as ahead of the blockee when it started waiting earlier. Also
+ * reports the tag of the awaited lock. Returns the number of blockers.
+ */
+static int
+get_lock_blockers(LockData *lockData, int blockee_pid,
+				  int **blockers, LOCKTAG *locktag)
+{
+	LockInstanceData   *blocked_instance = NULL;
+	LockMethod			lockMethodTable;
+	int					conflictMask;
+	int					nblockers = 0;
+	int					i;
+
+	*blockers = NULL;
+	MemSet(locktag, 0, sizeof(LOCKTAG));
+
+	for (i = 0; i < lockData->nelements; i++)
+	{
+		if (lockData->locks[i].pid == blockee_pid &&
+			lockData->locks[i].waitLockMode != NoLock)
+		{
+			blocked_instance = &lockData->locks[i];
+			break;
+		}
+	}
+	if (blocked_instance == NULL)
+		return 0;	/* the lock has been granted meanwhile */
+
+	*locktag = blocked_instance->locktag;
+	*blockers = palloc(lockData->nelements * sizeof(int));
+
+	lockMethodTable = GetLockTagsMethodTable(&blocked_instance->locktag);
+	conflictMask = lockMethodTable->conflictTab[blocked_instance->waitLockMode];
+
+	for (i = 0; i < lockData->nelements; i++)
+	{
+		LockInstanceData   *instance = &lockData->locks[i];
+
+		/* a proc never blocks itself, nor members of its lock group */
+		if (instance == blocked_instance ||
+			instance->leaderPid == blocked_instance->leaderPid)
+			continue;
+
+		if (memcmp(&instance->locktag, &blocked_instance->locktag,
+				   sizeof(LOCKTAG)) != 0)
+			continue;
+
+		if (conflictMask & instance->holdMask)
+		{
+			/* hard block: blocked by lock already held by this entry */
+		}
+		else if (instance->waitLockMode != NoLock &&
+				 (conflictMask & LOCKBIT_ON(instance->waitLockMode)))
+		{
+			/* soft block: only if this entry has been waiting longer */
+			if (instance->waitStart == 0 ||
+				(blocked_instance->waitStart != 0 &&
+				 instance->waitStart >= blocked_instance->waitStart))
+				continue;
+		}
+		else
+			continue;
+
+		(*blockers)[nblockers++] = instance->pid;
+	}
+
+	return nblockers;
+}
+
+/*
+ * find_beentry - lookup the backend status of the process.
+ */
+static PgBackendStatus *
+find_beentry(int pid)
+{
+	int		i;
+
+	for (i = pgstat_fetch_stat_numbackends(); i > 0; i--)
+	{
+		LocalPgBackendStatus *lbe = pgstat_get_local_beentry_by_index(i);
+
+		if (lbe && lbe->backendStatus.st_procpid == pid)
+			return &lbe->backendStatus;
+	}
+
+	return NULL;
+}
+
+#define FILE_PROC_STATUS	"/proc/%d/status"
+
+/*
+ * parse_proc_status - read memory usage of the process from /proc.
+ *
+ * Returns false if the process has already gone.
+ */
+static bool
+parse_proc_status(int pid, int64 *rss, int64 *anon, int64 *swap)
+{
+	FILE	*fp;
+	char	 path[MAXPGPATH];
+	char	 line[256];
+	long	 value;
+	bool	 has_anon = false;
+
+	*rss = *anon = *swap = 0;
+
+	snprintf(path, sizeof(path), FILE_PROC_STATUS, pid);
+	if ((fp = fopen(path, "r")) == NULL)
+	{
+		if (errno == ENOENT || errno == ESRCH)
+			return false;
+		ereport(ERROR,
+			(errcode_for_file_access(),
+			 errmsg("could not open file \"%s\": ", path)));
+	}
+
+	while (fgets(line, sizeof(line), fp) != NULL)
+	{
+		if (sscanf(line, "VmRSS: %ld kB", &value) == 1)
+			*rss = (int64) value * 1024;
+		else if (sscanf(line, "RssAnon: %ld kB", &value) == 1)
+		{
+			*anon = (int64) value * 1024;
+			has_anon = true;
+		}
+		else if (sscanf(line, "VmSwap: %ld kB", &value) == 1)
+			*swap = (int64) value * 1024;
+	}
+
+	fclose(fp);
+
+	/* RssAnon is not available before Linux 4.5 */
+	if (!has_anon)
+		*anon = *rss;
+
+	return true;
+}
+
+static void
+check_io_peak(DiskStatsEntry *entry, unsigned long rd_sec,
+			  unsigned long wr_sec, time_t duration)
+{
+	float8	calc;
+
+	if (duration <= 0)
+		return;
+
+	if (rd_sec >= entry->stats.rd_sectors)
+	{
+		calc = (float8) (rd_sec - entry->stats.rd_sectors) / duration;
+		if (calc > entry->drs_ps_max)
+			entry->drs_ps_max = calc;
+	}
+	if (wr_sec >= entry->stats.wr_sectors)
+	{
+		calc = (float8) (wr_sec - entry->stats.wr_sectors) / duration;
+		if (calc > entry->dws_ps_max)
+			entry->dws_ps_max = calc;
+	}
+}
+
+static void
+check_io_overflow(DiskStatsEntry *entry, unsigned long rd_sec,
+				  unsigned long wr_sec, unsigned int rd_ticks,
+				  unsigned int wr_ticks, unsigned int rq_ticks)
+{
+	if (entry->stats.rd_sectors > rd_sec)
+		entry->overflow_drs++;
+	if (entry->stats.wr_sectors > wr_sec)
+		entry->overflow_dws++;
+	if (entry->stats.rd_ticks > rd_ticks)
+		entry->overflow_drt++;
+	if (entry->stats.wr_ticks > wr_ticks)
+		entry->overflow_dwt++;
+	if (entry->stats.rq_ticks > rq_ticks)
+		entry->overflow_dit++;
+}
+
+#define FILE_DISKSTATS					"/proc/diskstats"
+#define NUM_DISKSTATS_FIELDS			14
+#define NUM_DISKSTATS_PARTITION_FIELDS	7
+
+static void
+parse_diskstats(HTAB *htab)
+{
+	FILE			*fp;
+	char			 line[256];
+	char			 dev_name[128];
+	unsigned int	 dev_major, dev_minor;
+	unsigned int	 ios_pgr, tot_ticks, rq_ticks, wr_ticks;
+	unsigned long	 rd_ios, rd_merges_or_rd_sec, rd_ticks_or_wr_sec, wr_ios;
+	unsigned long	 wr_merges, rd_sec_or_wr_ios, wr_sec;
+	DiskStatsHashKey key;
+	DiskStatsEntry	*entry;
+	bool			 found;
+	int				 i;
+	time_t			 now;
+
+	if ((fp = fopen(FILE_DISKSTATS, "r")) == NULL)
+		ereport(ERROR,
+			(errcode_for_file_access(),
+			 errmsg("could not open file \"%s\": ", FILE_DISKSTATS)));
+
+	now = time(NULL);
+
+	while (fgets(line, sizeof(line), fp) != NULL)
+	{
+		/* major minor name rio rmerge rsect ruse wio wmerge wsect wuse running use aveq */
+		i = sscanf(line, "%u %u %s %lu %lu %lu %lu %lu %lu %lu %u %u %u %u",
+				&dev_major, &dev_minor, dev_name,
+				&rd_ios, &rd_merges_or_rd_sec, &rd_sec_or_wr_ios, &rd_ticks_or_wr_sec,
+				&wr_ios, &wr_merges, &wr_sec, &wr_ticks, &ios_pgr, &tot_ticks, &rq_ticks);
+
+		if (i != NUM_DISKSTATS_FIELDS &&
+			i != NUM_DISKSTATS_PARTITION_FIELDS)
+			/* unknown entry: ignore it */
+			continue;
+
+		/* lookup the hash table entry */
+		key.dev_major = dev_major;
+		key.dev_minor = dev_minor;
+		entry = (DiskStatsEntry *) hash_search(htab, &key, HASH_ENTER, &found);
+
+		if (found)
+		{
+			/* check I/O peak and overflow if there is previous sample */
+			time_t duration;
+
+			duration = now - entry->timestamp;
+			if (i == NUM_DISKSTATS_FIELDS)
+			{
+				check_io_peak(entry, rd_sec_or_wr_ios, wr_sec, duration);
+				check_io_overflow(entry, rd_sec_or_wr_ios, wr_sec,
+					rd_ticks_or_wr_sec, wr_ticks, rq_ticks);
+			}
+			else
+			{
+				check_io_peak(entry, rd_merges_or_rd_sec, rd_ticks_or_wr_sec, duration);
+				check_io_overflow(entry, rd_merges_or_rd_sec,
+					rd_ticks_or_wr_sec, 0, 0, 0);
+			}
+		}
+		else
+		{
+			/* initialize new entry */
+			memset(&entry->stats, 0, sizeof(entry->stats));
+			entry->field_num = i;
+			entry->stats.dev_major = dev_major;
+			entry->stats.dev_minor = dev_minor;
+			strlcpy(entry->stats.dev_name, dev_name, sizeof(entry->stats.dev_name));
+			entry->drs_ps_max = 0;
+			entry->dws_ps_max = 0;
+			entry->overflow_drs = 0;
+			entry->overflow_drt = 0;
+			entry->overflow_dws = 0;
+			entry->overflow_dwt = 0;
+			entry->overflow_dit = 0;
+		}
+
+		/* set I/O statistics */
+		if (i == NUM_DISKSTATS_FIELDS)
+		{
+			/* device or partition */
+			entry->stats.rd_ios     = rd_ios;				/* Field 1 -- # of reads completed */
+			entry->stats.rd_merges  = rd_merges_or_rd_sec;	/* Field 2 -- # of reads merged */
+			entry->stats.rd_sectors = rd_sec_or_wr_ios;		/* Field 3 -- # of sectors read */
+			entry->stats.rd_ticks   = (unsigned int) rd_ticks_or_wr_sec;	/* Field 4 -- # of milliseconds spent reading */
+			entry->stats.wr_ios     = wr_ios;				/* Field 5 -- # of writes completed */
+			entry->stats.wr_merges  = wr_merges;			/* Field 6 -- # of writes merged */
+			entry->stats.wr_sectors = wr_sec;				/* Field 7 -- # of sectors written */
+			entry->stats.wr_ticks   = wr_ticks;				/* Field 8 -- # of milliseconds spent writing  */
+			entry->stats.ios_pgr    = ios_pgr;				/* Field 9 -- # of I/Os currently in progress */
+			entry->stats.tot_ticks  = tot_ticks;			/* Field 10 -- # of milliseconds spent doing I/Os */
+			entry->stats.rq_ticks   = rq_ticks;				/* Field 11 -- weighted # of milliseconds spent doing I/Os */
+		}
+		else
+		{
+			/* partition without extended statistics */
+			entry->stats.rd_ios     = rd_ios;				/* Field 1 -- # of reads issued */
+			entry->stats.rd_sectors = rd_merges_or_rd_sec;	/* Field 2 -- # of sectors read */
+			entry->stats.wr_ios     = rd_sec_or_wr_ios;		/* Field 3 -- # of writes issued */
+			entry->stats.wr_sectors = rd_ticks_or_wr_sec;	/* Field 4 -- # of sectors written */
+		}
+		entry->timestamp = now;
+	}
+
+	if (ferror(fp) && errno != EINTR)
+	{
+		fclose(fp);
+		ereport(ERROR,
+			(errcode_for_file_access(),
+			 errmsg("could not read file \"%s\": ", FILE_DISKSTATS)));
+	}
+
+	fclose(fp);
+}
+
+#define NUM_ACTIVITY_COLS		5
+
+/*
+ * statsinfo_activity - accumulate sampled counters.
+ */
+Datum
+statsinfo_activity(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	HeapTuple	tuple;
+	Datum		values[NUM_ACTIVITY_COLS];
+	bool		nulls[NUM_ACTIVITY_COLS];
+	int			i;
+
+	must_be_superuser();
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	Assert(tupdesc->natts == lengthof(values));
+
+	if (activity.samples > 0)
+	{
+
+		memset(nulls, 0, sizeof(nulls));
+
+		i = 0;
+		values[i++] = Int32GetDatum(activity.idle);
+		values[i++] = Int32GetDatum(activity.idle_in_xact);
+		values[i++] = Int32GetDatum(activity.waiting);
+		values[i++] = Int32GetDatum(activity.running);
+		values[i++] = Int32GetDatum(activity.max_backends);
+
+		Assert(i == lengthof(values));
+
+		/* reset activity statistics */
+		memset(&activity, 0, sizeof(Activity));
+	}
+	else
+	{
+		for (i = 0; i < lengthof(nulls); i++)
+			nulls[i] = true;
+	}
+
+	tuple = heap_form_tuple(tupdesc, values, nulls);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(tuple));
+}
+
+#define NUM_LONG_TRANSACTION_COLS		5
+
+/*
+ * statsinfo_long_xact - get long transaction information
+ */
+Datum
+statsinfo_long_xact(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo	   *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc			tupdesc;
+	Tuplestorestate	   *tupstore;
+	MemoryContext		per_query_ctx;
+	MemoryContext		oldcontext;
+	HASH_SEQ_STATUS		hash_seq;
+	LongXactEntry	   *entry;
+	Datum				values[NUM_LONG_TRANSACTION_COLS];
+	bool				nulls[NUM_LONG_TRANSACTION_COLS];
+	int					i;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+	Assert(tupdesc->natts == lengthof(values));
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	if (long_xacts)
+	{
+		hash_seq_init(&hash_seq, long_xacts);
+		while ((entry = hash_seq_search(&hash_seq)) != NULL)
+		{
+			memset(values, 0, sizeof(values));
+			memset(nulls, 0, sizeof(nulls));
+
+			i = 0;
+			if (entry->client[0])
+				values[i++] = CStringGetTextDatum(entry->client);
+			else
+				nulls[i++] = true;
+			if (entry->pid != 0)
+			{
+				char	*clipped_activity;
+
+				values[i++] = Int32GetDatum(entry->pid);
+				values[i++] = TimestampTzGetDatum(entry->start);
+				values[i++] = Float8GetDatum(entry->duration);
+
+				clipped_activity = pgstat_clip_activity(entry->query);
+				values[i++] = CStringGetTextDatum(clipped_activity);
+				pfree(clipped_activity);
+			}
+			else
+			{
+				nulls[i++] = true;
+				nulls[i++] = true;
+				nulls[i++] = true;
+				nulls[i++] = true;
+			}
+			Assert(i == lengthof(values));
+			tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+
+			/* remove entry from hashtable */
+			hash_search(long_xacts, &entry->key, HASH_REMOVE, NULL);
+		}
+	}
+
+	return (Datum) 0;
+}
+
+#define NUM_BACKEND_MEMORY_COLS		12
+
+/*
+ * statsinfo_backend_memory - get memory peaks of the largest backends
+ */
+Datum
+statsinfo_backend_memory(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo	   *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc			tupdesc;
+	Tuplestorestate	   *tupstore;
+	MemoryContext		per_query_ctx;
+	MemoryContext		oldcontext;
+	HASH_SEQ_STATUS		hash_seq;
+	BackendMemoryEntry *entry;
+	Datum				values[NUM_BACKEND_MEMORY_COLS];
+	bool				nulls[NUM_BACKEND_MEMORY_COLS];
+	int					i;
+
+	must_be_superuser();
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+	Assert(tupdesc->natts == lengthof(values));
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	if (backend_memory)
+	{
+		hash_seq_init(&hash_seq, backend_memory);
+		while ((entry = hash_seq_search(&hash_seq)) != NULL)
+		{
+			char	*clipped_activity;
+
+			memset(values, 0, sizeof(values));
+			memset(nulls, 0, sizeof(nulls));
+
+			i = 0;
+			values[i++] = Int32GetDatum(entry->key.pid);
+			values[i++] = TimestampTzGetDatum(entry->key.start);
+			values[i++] = CStringGetTextDatum(GetBackendTypeDesc(entry->backend_type));
+			if (OidIsValid(entry->dbid))
+				values[i++] = ObjectIdGetDatum(entry->dbid);
+			else
+				nulls[i++] = true;
+			if (OidIsValid(entry->userid))
+				values[i++] = ObjectIdGetDatum(entry->userid);
+			else
+				nulls[i++] = true;
+			if (entry->queryid != 0)
+				values[i++] = Int64GetDatum(entry->queryid);
+			else
+				nulls[i++] = true;
+			values[i++] = Int64GetDatum(entry->rss);
+			values[i++] = Int64GetDatum(entry->anon);
+			values[i++] = Int64GetDatum(entry->swap);
+			values[i++] = TimestampTzGetDatum(entry->peak_time);
+			values[i++] = BoolGetDatum(entry->logged);
+
+			clipped_activity = pgstat_clip_activity(entry->query);
+			values[i++] = CStringGetTextDatum(clipped_activity);
+			pfree(clipped_activity);
+
+			Assert(i == lengthof(values));
+			tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+
+			/* remove entry from hashtable */
+			hash_search(backend_memory, &entry->key, HASH_REMOVE, NULL);
+		}
+	}
+
+	return (Datum) 0;
+}
+
+#define NUM_LOCK_WAITS_COLS		12
+
+/*
+ * statsinfo_lock_waits - get lock waits sampled since the last call
+ */
+Datum
+statsinfo_lock_waits(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo	   *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc			tupdesc;
+	Tuplestorestate	   *tupstore;
+	MemoryContext		per_query_ctx;
+	MemoryContext		oldcontext;
+	HASH_SEQ_STATUS		hash_seq;
+	LockWaitEntry	   *entry;
+	Datum				values[NUM_LOCK_WAITS_COLS];
+	bool				nulls[NUM_LOCK_WAITS_COLS];
+	int					i;
+
+	must_be_superuser();
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+	Assert(tupdesc->natts == lengthof(values));
+
+	/* take one more sample so that the waits lasting now are included */
+	sample_lock_waits();
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	hash_seq_init(&hash_seq, lock_waits);
+	while ((entry = hash_seq_search(&hash_seq)) != NULL)
+	{
+		const char	*event_type;
+		const char	*event;
+		char		*clipped_activity;
+
+		memset(values, 0, sizeof(values));
+		memset(nulls, 0, sizeof(nulls));
+
+		event_type = pgstat_get_wait_event_type(entry->wait_event_info);
+		event = pgstat_get_wait_event(entry->wait_event_info);
+
+		i = 0;
+		values[i++] = Int32GetDatum(entry->key.blockee_pid);
+		values[i++] = Int32GetDatum(entry->key.blocker_pid);
+		if (OidIsValid(entry->dbid))
+			values[i++] = ObjectIdGetDatum(entry->dbid);
+		else
+			nulls[i++] = true;
+		if (OidIsValid(entry->relation))
+			values[i++] = ObjectIdGetDatum(entry->relation);
+		else
+			nulls[i++] = true;
+		if (TransactionIdIsValid(entry->xid))
+			values[i++] = TransactionIdGetDatum(entry->xid);
+		else
+			nulls[i++] = true;
+		if (event_type)
+			values[i++] = CStringGetTextDatum(event_type);
+		else
+			nulls[i++] = true;
+		if (event)
+			values[i++] = CStringGetTextDatum(event);
+		else
+			nulls[i++] = true;
+		values[i++] = TimestampTzGetDatum(entry->key.waitstart);
+		values[i++] = TimestampTzGetDatum(entry->last_seen);
+		values[i++] = Int32GetDatum(entry->samples);
+
+		clipped_activity = pgstat_clip_activity(LW_BLOCKEE_QUERY(entry));
+		values[i++] = CStringGetTextDatum(clipped_activity);
+		pfree(clipped_activity);
+
+		if (LW_BLOCKER_QUERY(entry)[0])
+		{
+			clipped_activity = pgstat_clip_activity(LW_BLOCKER_QUERY(entry));
+			values[i++] = CStringGetTextDatum(clipped_activity);
+			pfree(clipped_activity);
+		}
+		else
+			nulls[i++] = true;
+
+		Assert(i == lengthof(values));
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+
+		/* remove entry from hashtable */
+		hash_search(lock_waits, &entry->key, HASH_REMOVE, NULL);
+	}
+
+	return (Datum) 0;
+}
+
+/*
+ * lag_interval - convert a lag in usec into an interval datum
+ */
+static Datum
+lag_interval(int64 usec)
+{
+	Interval   *result = palloc0(sizeof(Interval));
+
+	result->time = usec;
+
+	return IntervalPGetDatum(result);
+}
+
+#define NUM_REPLICATION_LAG_COLS		12
+
+/*
+ * statsinfo_replication_lag - get replication lags sampled since the last call
+ */
+Datum
+statsinfo_replication_lag(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo	   *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc			tupdesc;
+	Tuplestorestate	   *tupstore;
+	MemoryContext		per_query_ctx;
+	MemoryContext		oldcontext;
+	HASH_SEQ_STATUS		hash_seq;
+	ReplicationLagEntry *entry;
+	Datum				values[NUM_REPLICATION_LAG_COLS];
+	bool				nulls[NUM_REPLICATION_LAG_COLS];
+	int					i;
+
+	must_be_superuser();
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+	Assert(tupdesc->natts == lengthof(values));
+
+	/* take one more sample so that the current lags are included */
+	sample_replication();
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	hash_seq_init(&hash_seq, replication_lags);
+	while ((entry = hash_seq_search(&hash_seq)) != NULL)
+	{
+		memset(values, 0, sizeof(values));
+		memset(nulls, 0, sizeof(nulls));
+
+		i = 0;
+		values[i++] = Int32GetDatum(entry->key.pid);
+		values[i++] = CStringGetTextDatum(entry->application_name);
+		values[i++] = Int32GetDatum(entry->samples);
+		values[i++] = lag_interval(entry->write_lag.min);
+		values[i++] = lag_interval(entry->write_lag.max);
+		values[i++] = lag_interval(series_percentile(&entry->write_lag, 0.99));
+		values[i++] = lag_interval(entry->flush_lag.min);
+		values[i++] = lag_interval(entry->flush_lag.max);
+		values[i++] = lag_interval(series_percentile(&entry->flush_lag, 0.99));
+		values[i++] = lag_interval(entry->replay_lag.min);
+		values[i++] = lag_interval(entry->replay_lag.max);
+		values[i++] = lag_interval(series_percentile(&entry->replay_lag, 0.99));
+
+		Assert(i == lengthof(values));
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+
+		/* remove entry from hashtable */
+		hash_search(replication_lags, &entry->key, HASH_REMOVE, NULL);
+	}
+
+	return (Datum) 0;
+}
+
+#define NUM_SLOT_RETENTION_COLS		5
+
+/*
+ * statsinfo_replication_slot_retention - get WAL retained by replication
+ * slots sampled since the last call
+ */
+Datum
+statsinfo_replication_slot_retention(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo	   *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc			tupdesc;
+	Tuplestorestate	   *tupstore;
+	MemoryContext		per_query_ctx;
+	MemoryContext		oldcontext;
+	HASH_SEQ_STATUS		hash_seq;
+	SlotRetentionEntry *entry;
+	Datum				values[NUM_SLOT_RETENTION_COLS];
+	bool				nulls[NUM_SLOT_RETENTION_COLS];
+	int					i;
+
+	must_be_superuser();
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+	Assert(tupdesc->natts == lengthof(values));
+
+	/* take one more sample so that the current retention is included */
+	sample_replication();
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	hash_seq_init(&hash_seq, slot_retentions);
+	while ((entry = hash_seq_search(&hash_seq)) != NULL)
+	{
+		memset(values, 0, sizeof(values));
+		memset(nulls, 0, sizeof(nulls));
+
+		i = 0;
+		values[i++] = NameGetDatum(&entry->slot_name);
+		values[i++] = Int32GetDatum((int32) entry->retained.count);
+		values[i++] = Int64GetDatum(entry->retained.min);
+		values[i++] = Int64GetDatum(entry->retained.max);
+		values[i++] = Int64GetDatum(series_percentile(&entry->retained, 0.99));
+
+		Assert(i == lengthof(values));
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+
+		/* remove entry from hashtable */
+		hash_search(slot_retentions, &entry->slot_name, HASH_REMOVE, NULL);
+	}
 
-	PG_RETURN_DATUM(HeapTupleGetDatum(tuple));
+	return (Datum) 0;
 }
 
-#define NUM_LONG_TRANSACTION_COLS		5
+#define NUM_PROGRESS_COLS		13
 
 /*
- * statsinfo_long_xact - get long transaction information
+ * statsinfo_progress - get phases of maintenance operations completed since
+ * the last call
  */
 Datum
-statsinfo_long_xact(PG_FUNCTION_ARGS)
+statsinfo_progress(PG_FUNCTION_ARGS)
 {
 	ReturnSetInfo	   *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
 	TupleDesc			tupdesc;
@@ -992,10 +2602,13 @@ statsinfo_long_xact(PG_FUNCTION_ARGS)
 	MemoryContext		per_query_ctx;
 	MemoryContext		oldcontext;
 	HASH_SEQ_STATUS		hash_seq;
-	LongXactEntry	   *entry;
-	Datum				values[NUM_LONG_TRANSACTION_COLS];
-	bool				nulls[NUM_LONG_TRANSACTION_COLS];
+	ProgressEntry	   *entry;
+	Datum				values[NUM_PROGRESS_COLS];
+	bool				nulls[NUM_PROGRESS_COLS];
 	int					i;
+	int					j;
+
+	must_be_superuser();
 
 	/* check to see if caller supports us returning a tuplestore */
 	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
@@ -1013,6 +2626,9 @@ statsinfo_long_xact(PG_FUNCTION_ARGS)
 		elog(ERROR, "return type must be a row type");
 	Assert(tupdesc->natts == lengthof(values));
 
+	/* take one more sample so that just completed operations are included */
+	sample_progress();
+
 	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
 	oldcontext = MemoryContextSwitchTo(per_query_ctx);
 
@@ -1023,44 +2639,37 @@ statsinfo_long_xact(PG_FUNCTION_ARGS)
 
 	MemoryContextSwitchTo(oldcontext);
 
-	if (long_xacts)
+	hash_seq_init(&hash_seq, progress_done);
+	while ((entry = hash_seq_search(&hash_seq)) != NULL)
 	{
-		hash_seq_init(&hash_seq, long_xacts);
-		while ((entry = hash_seq_search(&hash_seq)) != NULL)
+		for (j = 0; j < entry->nphases; j++)
 		{
+			ProgressPhase  *ph = &entry->phases[j];
+
 			memset(values, 0, sizeof(values));
 			memset(nulls, 0, sizeof(nulls));
 
 			i = 0;
-			if (entry->client[0])
-				values[i++] = CStringGetTextDatum(entry->client);
-			else
-				nulls[i++] = true;
-			if (entry->pid != 0)
-			{
-				char	*clipped_activity;
-
-				values[i++] = Int32GetDatum(entry->pid);
-				values[i++] = TimestampTzGetDatum(entry->start);
-				values[i++] = Float8GetDatum(entry->duration);
+			values[i++] = Int32GetDatum(entry->pid);
+			values[i++] = CStringGetTextDatum(progress_command_name(entry));
+			values[i++] = ObjectIdGetDatum(entry->dbid);
+			values[i++] = ObjectIdGetDatum(entry->relid);
+			values[i++] = TimestampTzGetDatum(entry->start);
+			values[i++] = TimestampTzGetDatum(entry->last_seen);
+			values[i++] = Int32GetDatum(j + 1);
+			values[i++] = CStringGetTextDatum(progress_phase_name(entry, ph->phase));
+			values[i++] = TimestampTzGetDatum(ph->start);
+			values[i++] = TimestampTzGetDatum(ph->end);
+			values[i++] = Int64GetDatum(ph->blocks_total);
+			values[i++] = Int64GetDatum(ph->blocks_start);
+			values[i++] = Int64GetDatum(ph->blocks_end);
 
-				clipped_activity = pgstat_clip_activity(entry->query);
-				values[i++] = CStringGetTextDatum(clipped_activity);
-				pfree(clipped_activity);
-			}
-			else
-			{
-				nulls[i++] = true;
-				nulls[i++] = true;
-				nulls[i++] = true;
-				nulls[i++] = true;
-			}
 			Assert(i == lengthof(values));
 			tuplestore_putvalues(tupstore, tupdesc, values, nulls);
-
-			/* remove entry from hashtable */
-			hash_search(long_xacts, &entry->key, HASH_REMOVE, NULL);
 		}
+
+		/* remove entry from hashtable */
+		hash_search(progress_done, &entry->opid, HASH_REMOVE, NULL);
 	}
 
 	return (Datum) 0;
@@ -1312,6 +2921,30 @@ _PG_init(void)
 							   NULL,
 							   NULL);
 
+	DefineCustomStringVariable(GUC_PREFIX ".partition_rollup",
+							   "Selects partitioned tables whose leaf partitions are rolled up into the root.",
+							   "Comma-separated list of LIKE patterns matched against schema-qualified names of root partitioned tables.",
+							   &partition_rollup,
+							   "",
+							   PGC_SIGHUP,
+							   0,
+							   NULL,
+							   NULL,
+							   NULL);
+
+	DefineCustomIntVariable(GUC_PREFIX ".partition_rollup_keep",
+							"Sets the number of the most active leaf partitions kept individually per partitioned table.",
+							NULL,
+							&partition_rollup_keep,
+							DEFAULT_PARTITION_ROLLUP_KEEP,
+							0,
+							INT_MAX,
+							PGC_SIGHUP,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
 	DefineCustomIntVariable(GUC_PREFIX ".sampling_interval",
 							"Sets the sampling interval.",
 							NULL,
@@ -1351,6 +2984,160 @@ _PG_init(void)
 							NULL,
 							NULL);
 
+	DefineCustomIntVariable(GUC_PREFIX ".snapshot_parallelism",
+							"Sets the number of databases whose statistics are collected concurrently.",
+							NULL,
+							&snapshot_parallelism,
+							DEFAULT_SNAPSHOT_PARALLELISM,
+							1,
+							MAX_BACKENDS,
+							PGC_SIGHUP,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable(GUC_PREFIX ".connection_pool_size",
+							"Sets the number of idle connections to databases kept by the collector.",
+							"0 closes the connections after use.",
+							&connection_pool_size,
+							0,
+							0,
+							MAX_BACKENDS,
+							PGC_SIGHUP,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable(GUC_PREFIX ".connection_pool_idle_timeout",
+							"Sets the time after which idle pooled connections are closed.",
+							NULL,
+							&connection_pool_idle_timeout,
+							DEFAULT_CONNECTION_POOL_IDLE_TIMEOUT,
+							1,
+							INT_MAX,
+							PGC_SIGHUP,
+							GUC_UNIT_S,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable(GUC_PREFIX ".snapshot_jitter",
+							"Sets the window in which snapshots are delayed per instance.",
+							"0 takes snapshots at multiples of snapshot_interval.",
+							&snapshot_jitter,
+							0,
+							0,
+							INT_MAX,
+							PGC_SIGHUP,
+							GUC_UNIT_S,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable(GUC_PREFIX ".repository_write_slots",
+							"Sets the number of agents which write snapshots into the repository at once.",
+							"0 disables the limit.",
+							&repository_write_slots,
+							0,
+							0,
+							INT_MAX,
+							PGC_SIGHUP,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable(GUC_PREFIX ".mini_snapshot_interval",
+							"Sets the interval of mini-snapshots of the instance-level counters.",
+							"0 disables mini-snapshots.",
+							&mini_snapshot_interval,
+							0,
+							0,
+							INT_MAX,
+							PGC_SIGHUP,
+							GUC_UNIT_S,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable(GUC_PREFIX ".escalation_interval",
+							"Sets the interval of lightweight snapshots while escalated.",
+							NULL,
+							&escalation_interval,
+							DEFAULT_ESCALATION_INTERVAL,
+							1,
+							INT_MAX,
+							PGC_SIGHUP,
+							GUC_UNIT_S,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable(GUC_PREFIX ".escalation_duration",
+							"Sets how long lightweight snapshots are taken after a trigger.",
+							NULL,
+							&escalation_duration,
+							DEFAULT_ESCALATION_DURATION,
+							1,
+							INT_MAX,
+							PGC_SIGHUP,
+							GUC_UNIT_S,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable(GUC_PREFIX ".escalation_waiting_sessions",
+							"Sets the number of sessions waiting for locks which triggers lightweight snapshots.",
+							"0 disables the trigger.",
+							&escalation_waiting_sessions,
+							0,
+							0,
+							INT_MAX,
+							PGC_SIGHUP,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable(GUC_PREFIX ".escalation_replication_lag",
+							"Sets the replication lag which triggers lightweight snapshots.",
+							"0 disables the trigger.",
+							&escalation_replication_lag,
+							0,
+							0,
+							INT_MAX,
+							PGC_SIGHUP,
+							GUC_UNIT_S,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable(GUC_PREFIX ".escalation_cpu_usage",
+							"Sets the CPU usage in percent which triggers lightweight snapshots.",
+							"0 disables the trigger.",
+							&escalation_cpu_usage,
+							0,
+							0,
+							100,
+							PGC_SIGHUP,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomBoolVariable(GUC_PREFIX ".escalation_on_alert",
+							"Triggers lightweight snapshots when an alert is raised.",
+							NULL,
+							&escalation_on_alert,
+							false,
+							PGC_SIGHUP,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
 	DefineCustomStringVariable(GUC_PREFIX ".repository_server",
 							   "Connection string for repository database.",
 							   NULL,
@@ -1483,48 +3270,159 @@ _PG_init(void)
 							   NULL,
 							   NULL);
 
-	DefineCustomIntVariable(GUC_PREFIX ".repository_keepday",
-							"Sets the retention period of repository.",
+	DefineCustomIntVariable(GUC_PREFIX ".repository_keepday",
+							"Sets the retention period of repository.",
+							NULL,
+							&repository_keepday,
+							DEFAULT_REPOSITORY_KEEPDAY,
+							1,
+							3650,
+							PGC_SIGHUP,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable(GUC_PREFIX ".repolog_keepday",
+							"Sets the retention period of log which is in repository.",
+							NULL,
+							&repolog_keepday,
+							DEFAULT_REPOLOG_KEEPDAY,
+							1,
+							3650,
+							PGC_SIGHUP,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomStringVariable(GUC_PREFIX ".log_maintenance_command",
+							   "Sets the shell command that will be called to the log maintenance.",
+							   NULL,
+							   &log_maintenance_command,
+							   DEFAULT_LOG_MAINTENANCE_COMMAND,
+							   PGC_SIGHUP,
+							   0,
+							   NULL,
+							   NULL,
+							   NULL);
+
+	DefineCustomIntVariable(GUC_PREFIX ".long_lock_threshold",
+							"Sets the threshold of lock wait time.",
+							NULL,
+							&long_lock_threshold,
+							DEFAULT_LONG_LOCK_THRESHOLD,
+							0,
+							INT_MAX,
+							PGC_SIGHUP,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable(GUC_PREFIX ".stat_statements_max",
+							"Sets the max collection size from pg_stat_statements.",
+							NULL,
+							&stat_statements_max,
+							DEFAULT_STAT_STATEMENTS_MAX,
+							0,
+							INT_MAX,
+							PGC_SIGHUP,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomStringVariable(GUC_PREFIX ".stat_statements_exclude_users",
+							   "Sets dbusers that doesn't collect statistics of statement from pg_stat_statements.",
+							   NULL,
+							   &stat_statements_exclude_users,
+							   "",
+							   PGC_SIGHUP,
+							   0,
+							   NULL,
+							   NULL,
+							   NULL);
+
+	DefineCustomBoolVariable(GUC_PREFIX ".stat_statements_delta",
+							 "Collects only the statements whose counters changed since the last snapshot.",
+							 NULL,
+							 &stat_statements_delta,
+							 false,
+							 PGC_SIGHUP,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomIntVariable(GUC_PREFIX ".stat_statements_top",
+							"Sets the number of the top statements collected by each of execution time, block I/O and calls.",
+							NULL,
+							&stat_statements_top,
+							0,
+							0,
+							INT_MAX,
+							PGC_SIGHUP,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable(GUC_PREFIX ".buffercache_max",
+							"Sets the max number of relations collected from pg_buffercache.",
 							NULL,
-							&repository_keepday,
-							DEFAULT_REPOSITORY_KEEPDAY,
-							1,
-							3650,
+							&buffercache_max,
+							DEFAULT_BUFFERCACHE_MAX,
+							0,
+							INT_MAX,
 							PGC_SIGHUP,
 							0,
 							NULL,
 							NULL,
 							NULL);
 
-	DefineCustomIntVariable(GUC_PREFIX ".repolog_keepday",
-							"Sets the retention period of log which is in repository.",
+	DefineCustomIntVariable(GUC_PREFIX ".walinspect_max_size",
+							"Sets the max size of WAL summarized by pg_walinspect per snapshot.",
 							NULL,
-							&repolog_keepday,
-							DEFAULT_REPOLOG_KEEPDAY,
-							1,
-							3650,
-							PGC_SIGHUP,
+							&walinspect_max_size,
+							DEFAULT_WALINSPECT_MAX_SIZE,
 							0,
+							INT_MAX,
+							PGC_SIGHUP,
+							GUC_UNIT_MB,
 							NULL,
 							NULL,
 							NULL);
 
-	DefineCustomStringVariable(GUC_PREFIX ".log_maintenance_command",
-							   "Sets the shell command that will be called to the log maintenance.",
-							   NULL,
-							   &log_maintenance_command,
-							   DEFAULT_LOG_MAINTENANCE_COMMAND,
-							   PGC_SIGHUP,
-							   0,
-							   NULL,
-							   NULL,
-							   NULL);
+	DefineCustomIntVariable(GUC_PREFIX ".copy_chunk_size",
+							"Sets the size of the chunks sent with binary COPY to the repository.",
+							NULL,
+							&copy_chunk_size,
+							DEFAULT_COPY_CHUNK_SIZE,
+							1,
+							MAX_KILOBYTES,
+							PGC_SIGHUP,
+							GUC_UNIT_KB,
+							NULL,
+							NULL,
+							NULL);
 
-	DefineCustomIntVariable(GUC_PREFIX ".long_lock_threshold",
-							"Sets the threshold of lock wait time.",
+	DefineCustomBoolVariable(GUC_PREFIX ".snapshot_streaming",
+							"Streams table, column and index statistics into the repository.",
 							NULL,
-							&long_lock_threshold,
-							DEFAULT_LONG_LOCK_THRESHOLD,
+							&snapshot_streaming,
+							false,
+							PGC_SIGHUP,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable(GUC_PREFIX ".snapshot_chunk_rows",
+							"Sets the number of rows of column and index statistics read at a time.",
+							"Zero reads all the rows at once.",
+							&snapshot_chunk_rows,
+							0,
 							0,
 							INT_MAX,
 							PGC_SIGHUP,
@@ -1533,29 +3431,29 @@ _PG_init(void)
 							NULL,
 							NULL);
 
-	DefineCustomIntVariable(GUC_PREFIX ".stat_statements_max",
-							"Sets the max collection size from pg_stat_statements.",
+	DefineCustomBoolVariable(GUC_PREFIX ".snapshot_skip_idle",
+							"Skips databases whose statistics have not changed since the previous snapshot.",
 							NULL,
-							&stat_statements_max,
-							DEFAULT_STAT_STATEMENTS_MAX,
-							0,
-							INT_MAX,
+							&snapshot_skip_idle,
+							false,
 							PGC_SIGHUP,
 							0,
 							NULL,
 							NULL,
 							NULL);
 
-	DefineCustomStringVariable(GUC_PREFIX ".stat_statements_exclude_users",
-							   "Sets dbusers that doesn't collect statistics of statement from pg_stat_statements.",
-							   NULL,
-							   &stat_statements_exclude_users,
-							   "",
-							   PGC_SIGHUP,
-							   0,
-							   NULL,
-							   NULL,
-							   NULL);
+	DefineCustomIntVariable(GUC_PREFIX ".snapshot_budget",
+							"Sets the time after which a snapshot skips expensive statistics.",
+							"0 disables the budget.",
+							&snapshot_budget,
+							0,
+							0,
+							INT_MAX,
+							PGC_SIGHUP,
+							GUC_UNIT_S,
+							NULL,
+							NULL,
+							NULL);
 
 	DefineCustomIntVariable(GUC_PREFIX ".controlfile_fsync_interval",
 							"Sets the fsync interval of the control file.",
@@ -1609,6 +3507,58 @@ _PG_init(void)
 							NULL,
 							NULL);
 
+	DefineCustomIntVariable(GUC_PREFIX ".backend_memory_max",
+							"Sets the max collection size of backend memory peaks.",
+							NULL,
+							&backend_memory_max,
+							DEFAULT_BACKEND_MEMORY_MAX,
+							0,
+							INT_MAX,
+							PGC_SIGHUP,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable(GUC_PREFIX ".backend_memory_log_threshold",
+							"Sets the memory usage above which a backend logs its memory contexts.",
+							"Zero disables logging of memory contexts.",
+							&backend_memory_log_threshold,
+							DEFAULT_BACKEND_MEMORY_LOG_THRESHOLD,
+							0,
+							INT_MAX,
+							PGC_SIGHUP,
+							GUC_UNIT_MB,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable(GUC_PREFIX ".lock_wait_max",
+							"Sets the max collection size of lock waits between snapshots.",
+							NULL,
+							&lock_wait_max,
+							DEFAULT_LOCK_WAIT_MAX,
+							1,
+							INT_MAX,
+							PGC_SIGHUP,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable(GUC_PREFIX ".progress_max",
+							"Sets the max collection size of completed maintenance operations between snapshots.",
+							NULL,
+							&progress_max,
+							DEFAULT_PROGRESS_MAX,
+							1,
+							INT_MAX,
+							PGC_SIGHUP,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
 	DefineCustomBoolVariable(GUC_PREFIX ".enable_alert",
 							"Enable the alert function.",
 							NULL,
@@ -1677,6 +3627,19 @@ _PG_init(void)
 							NULL,
 							NULL);
 
+	DefineCustomIntVariable(GUC_PREFIX ".collect_column_rotation",
+							"Sets the number of snapshots in which column information of all tables is collected in turn.",
+							NULL,
+							&collect_column_rotation,
+							1,
+							1,
+							INT_MAX,
+							PGC_SIGHUP,
+							GUC_SUPERUSER_ONLY,
+							NULL,
+							NULL,
+							NULL);
+
 	DefineCustomBoolVariable(GUC_PREFIX ".collect_index",
 							"Enable collect index information.",
 							NULL,
@@ -4159,6 +6122,224 @@ lx_entry_cmp(const void *lhs, const void *rhs)
 		return 0;
 }
 
+/*
+ * bm_hash_fn - calculate hash value for a key
+ */
+static uint32
+bm_hash_fn(const void *key, Size keysize)
+{
+	const BackendMemoryHashKey	*k = (const BackendMemoryHashKey *) key;
+
+	return hash_uint32((uint32) k->pid) ^
+		   hash_uint32((uint32) k->start);
+}
+
+/*
+ * bm_match_fn - compare two keys, zero means match
+ */
+static int
+bm_match_fn(const void *key1, const void *key2, Size keysize)
+{
+	const BackendMemoryHashKey	*k1 = (const BackendMemoryHashKey *) key1;
+	const BackendMemoryHashKey	*k2 = (const BackendMemoryHashKey *) key2;
+
+	if (k1->pid == k2->pid &&
+		k1->start == k2->start)
+		return 0;
+	else
+		return 1;
+}
+
+/*
+ * bm_entry_dealloc - deallocate entries
+ */
+static void
+bm_entry_dealloc(void)
+{
+	HASH_SEQ_STATUS		 hash_seq;
+	BackendMemoryEntry	**entries;
+	BackendMemoryEntry	 *entry;
+	int					  entry_num;
+	int					  excess;
+	int					  i;
+
+	entry_num = hash_get_num_entries(backend_memory);
+
+	if (entry_num <= backend_memory_max)
+		return;	/* not need to be deallocated */
+
+	entries = palloc(entry_num * sizeof(BackendMemoryEntry *));
+
+	i = 0;
+	hash_seq_init(&hash_seq, backend_memory);
+	while ((entry = hash_seq_search(&hash_seq)) != NULL)
+		entries[i++] = entry;
+
+	qsort(entries, i, sizeof(BackendMemoryEntry *), bm_entry_cmp);
+
+	/* discards extra entries in order of memory peak */
+	excess = entry_num - backend_memory_max;
+	for (i = 0; i < excess; i++)
+		hash_search(backend_memory, &entries[i]->key, HASH_REMOVE, NULL);
+
+	pfree(entries);
+}
+
+/*
+ * bm_entry_cmp - qsort comparator for sorting into memory peak order
+ */
+static int
+bm_entry_cmp(const void *lhs, const void *rhs)
+{
+	int64		l_anon = (*(BackendMemoryEntry *const *) lhs)->anon;
+	int64		r_anon = (*(BackendMemoryEntry *const *) rhs)->anon;
+
+	if (l_anon < r_anon)
+		return -1;
+	else if (l_anon > r_anon)
+		return +1;
+	else
+		return 0;
+}
+
+/*
+ * lw_hash_fn - calculate hash value for a key
+ */
+static uint32
+lw_hash_fn(const void *key, Size keysize)
+{
+	const LockWaitHashKey	*k = (const LockWaitHashKey *) key;
+
+	return hash_uint32((uint32) k->blockee_pid) ^
+		   hash_uint32((uint32) k->blocker_pid) ^
+		   hash_uint32((uint32) k->waitstart);
+}
+
+/*
+ * lw_match_fn - compare two keys, zero means match
+ */
+static int
+lw_match_fn(const void *key1, const void *key2, Size keysize)
+{
+	const LockWaitHashKey	*k1 = (const LockWaitHashKey *) key1;
+	const LockWaitHashKey	*k2 = (const LockWaitHashKey *) key2;
+
+	if (k1->blockee_pid == k2->blockee_pid &&
+		k1->blocker_pid == k2->blocker_pid &&
+		k1->waitstart == k2->waitstart)
+		return 0;
+	else
+		return 1;
+}
+
+/*
+ * lw_entry_dealloc - deallocate entries
+ */
+static void
+lw_entry_dealloc(void)
+{
+	HASH_SEQ_STATUS	  hash_seq;
+	LockWaitEntry	**entries;
+	LockWaitEntry	 *entry;
+	int				  entry_num;
+	int				  excess;
+	int				  i;
+
+	entry_num = hash_get_num_entries(lock_waits);
+
+	if (entry_num <= lock_wait_max)
+		return;	/* not need to be deallocated */
+
+	entries = palloc(entry_num * sizeof(LockWaitEntry *));
+
+	i = 0;
+	hash_seq_init(&hash_seq, lock_waits);
+	while ((entry = hash_seq_search(&hash_seq)) != NULL)
+		entries[i++] = entry;
+
+	qsort(entries, i, sizeof(LockWaitEntry *), lw_entry_cmp);
+
+	/* discards extra entries in order of blocked time */
+	excess = entry_num - lock_wait_max;
+	for (i = 0; i < excess; i++)
+		hash_search(lock_waits, &entries[i]->key, HASH_REMOVE, NULL);
+
+	pfree(entries);
+}
+
+/*
+ * lw_entry_cmp - qsort comparator for sorting into blocked time order
+ */
+static int
+lw_entry_cmp(const void *lhs, const void *rhs)
+{
+	const LockWaitEntry	*l = *(LockWaitEntry *const *) lhs;
+	const LockWaitEntry	*r = *(LockWaitEntry *const *) rhs;
+	TimestampTz			 l_duration = l->last_seen - l->key.waitstart;
+	TimestampTz			 r_duration = r->last_seen - r->key.waitstart;
+
+	if (l_duration < r_duration)
+		return -1;
+	else if (l_duration > r_duration)
+		return +1;
+	else
+		return 0;
+}
+
+/*
+ * pr_entry_dealloc - deallocate entries
+ */
+static void
+pr_entry_dealloc(void)
+{
+	HASH_SEQ_STATUS	  hash_seq;
+	ProgressEntry	**entries;
+	ProgressEntry	 *entry;
+	int				  entry_num;
+	int				  excess;
+	int				  i;
+
+	entry_num = hash_get_num_entries(progress_done);
+
+	if (entry_num <= progress_max)
+		return;	/* not need to be deallocated */
+
+	entries = palloc(entry_num * sizeof(ProgressEntry *));
+
+	i = 0;
+	hash_seq_init(&hash_seq, progress_done);
+	while ((entry = hash_seq_search(&hash_seq)) != NULL)
+		entries[i++] = entry;
+
+	qsort(entries, i, sizeof(ProgressEntry *), pr_entry_cmp);
+
+	/* discards extra entries in order of duration */
+	excess = entry_num - progress_max;
+	for (i = 0; i < excess; i++)
+		hash_search(progress_done, &entries[i]->opid, HASH_REMOVE, NULL);
+
+	pfree(entries);
+}
+
+/*
+ * pr_entry_cmp - qsort comparator for sorting into duration order
+ */
+static int
+pr_entry_cmp(const void *lhs, const void *rhs)
+{
+	const ProgressEntry	*l = *(ProgressEntry *const *) lhs;
+	const ProgressEntry	*r = *(ProgressEntry *const *) rhs;
+	TimestampTz			 l_duration = l->last_seen - l->start;
+	TimestampTz			 r_duration = r->last_seen - r->start;
+
+	if (l_duration < r_duration)
+		return -1;
+	else if (l_duration > r_duration)
+		return +1;
+	else
+		return 0;
+}
+
 /*
  * ds_hash_fn - calculate hash value for a key
  */
@@ -0,0 +1,575 @@
+/*
+ * lib/relation_stats.c
+ *	 Collect statistics of tables and indexes in one pass over the catalogs.
+ *
+ * Copyright (c) 2009-2025, NIPPON TELEGRAPH AND TELEPHONE CORPORATION
+ */
+
+#include "postgres.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "access/genam.h"
+#include "access/htup_details.h"
+#include "access/table.h"
+#include "catalog/namespace.h"
+#include "catalog/pg_class.h"
+#include "catalog/pg_index.h"
+#include "catalog/pg_tablespace.h"
+#include "common/relpath.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "pgstat.h"
+#include "storage/procnumber.h"
+#include "utils/builtins.h"
+#include "utils/hsearch.h"
+#include "utils/relmapper.h"
+#include "utils/syscache.h"
+#include "utils/timestamp.h"
+#include "utils/varlena.h"
+
+#include "pgut/pgut-be.h"
+
+#define NUM_TABLES_COLS		34
+#define NUM_INDEXES_COLS	20
+
+/* hashtable entry for valid indexes of a table */
+typedef struct RelIndexesEntry
+{
+	Oid			indrelid;	/* hash key of entry - MUST BE FIRST */
+	List	   *indexes;	/* OIDs of valid indexes */
+} RelIndexesEntry;
+
+PG_FUNCTION_INFO_V1(statsinfo_tables);
+PG_FUNCTION_INFO_V1(statsinfo_indexes);
+
+extern Datum PGUT_EXPORT statsinfo_tables(PG_FUNCTION_ARGS);
+extern Datum PGUT_EXPORT statsinfo_indexes(PG_FUNCTION_ARGS);
+
+static Tuplestorestate *init_materialize(FunctionCallInfo fcinfo, TupleDesc *tupdesc, int natts);
+static List *get_excluded_namespaces(text *schemas);
+static bool is_target_table(Form_pg_class classForm, List *excluded);
+static HTAB *get_valid_indexes(void);
+static int64 relation_size(Form_pg_class classForm);
+static Datum get_indexdef(Oid indexrelid, bool *isnull);
+
+/*
+ * statsinfo_tables - get statistics of tables
+ *
+ * Returns the same rows as the catalog join in the collector, but walks
+ * pg_class and pg_index once, reads the cumulative statistics directly and
+ * gets the size from the relation files, so no lock is taken per relation.
+ */
+Datum
+statsinfo_tables(PG_FUNCTION_ARGS)
+{
+	Tuplestorestate	   *tupstore;
+	TupleDesc			tupdesc;
+	List			   *excluded;
+	HTAB			   *indexes;
+	Relation			rel;
+	SysScanDesc			scan;
+	HeapTuple			tuple;
+
+	tupstore = init_materialize(fcinfo, &tupdesc, NUM_TABLES_COLS);
+	excluded = get_excluded_namespaces(PG_GETARG_TEXT_PP(0));
+	indexes = get_valid_indexes();
+
+	rel = table_open(RelationRelationId, AccessShareLock);
+	scan = systable_beginscan(rel, InvalidOid, false, NULL, 0, NULL);
+	while (HeapTupleIsValid(tuple = systable_getnext(scan)))
+	{
+		Form_pg_class		classForm = (Form_pg_class) GETSTRUCT(tuple);
+		PgStat_StatTabEntry *tabentry;
+		PgStat_StatTabEntry *toastentry = NULL;
+		RelIndexesEntry	   *relindexes;
+		RelIndexesEntry	   *toastindexes = NULL;
+		Datum				values[NUM_TABLES_COLS];
+		bool				nulls[NUM_TABLES_COLS];
+		ListCell		   *cell;
+		int64				idx_scan = 0;
+		int64				idx_tup_fetch = 0;
+		int64				idx_blks_fetched = 0;
+		int64				idx_blks_hit = 0;
+		Oid					toastidxid = InvalidOid;
+		int					i;
+
+		CHECK_FOR_INTERRUPTS();
+
+		if (!is_target_table(classForm, excluded))
+			continue;
+
+		memset(values, 0, sizeof(values));
+		memset(nulls, 0, sizeof(nulls));
+
+		tabentry = pgstat_fetch_stat_tabentry_ext(classForm->relisshared,
+												  classForm->oid);
+
+		relindexes = (RelIndexesEntry *)
+			hash_search(indexes, &classForm->oid, HASH_FIND, NULL);
+		if (relindexes)
+		{
+			foreach(cell, relindexes->indexes)
+			{
+				PgStat_StatTabEntry *idxentry;
+
+				idxentry = pgstat_fetch_stat_tabentry_ext(classForm->relisshared,
+														  lfirst_oid(cell));
+				if (idxentry == NULL)
+					continue;
+				idx_scan += idxentry->numscans;
+				idx_tup_fetch += idxentry->tuples_fetched;
+				idx_blks_fetched += idxentry->blocks_fetched;
+				idx_blks_hit += idxentry->blocks_hit;
+			}
+		}
+
+		if (OidIsValid(classForm->reltoastrelid))
+		{
+			toastentry = pgstat_fetch_stat_tabentry_ext(classForm->relisshared,
+														classForm->reltoastrelid);
+			toastindexes = (RelIndexesEntry *)
+				hash_search(indexes, &classForm->reltoastrelid, HASH_FIND, NULL);
+			if (toastindexes)
+			{
+				/* should be only one valid index */
+				foreach(cell, toastindexes->indexes)
+					toastidxid = Max(toastidxid, lfirst_oid(cell));
+			}
+		}
+
+		i = 0;
+		values[i++] = ObjectIdGetDatum(classForm->oid);
+		values[i++] = ObjectIdGetDatum(classForm->relnamespace);
+		values[i++] = ObjectIdGetDatum(classForm->reltablespace);
+		values[i++] = NameGetDatum(&classForm->relname);
+		values[i++] = ObjectIdGetDatum(classForm->reltoastrelid);
+		if (OidIsValid(toastidxid))
+			values[i++] = ObjectIdGetDatum(toastidxid);
+		else
+			nulls[i++] = true;
+		values[i++] = CharGetDatum(classForm->relkind);
+		values[i++] = Int32GetDatum(classForm->relpages);
+		values[i++] = Float4GetDatum(classForm->reltuples);
+		values[i] = heap_getattr(tuple, Anum_pg_class_reloptions,
+								 RelationGetDescr(rel), &nulls[i]);
+		i++;
+		values[i++] = Int64GetDatum(relation_size(classForm));
+		values[i++] = Int64GetDatum(tabentry ? tabentry->numscans : 0);
+		values[i++] = Int64GetDatum(tabentry ? tabentry->tuples_returned : 0);
+
+		/* index counters are null for a table without valid indexes */
+		if (relindexes)
+		{
+			values[i++] = Int64GetDatum(idx_scan);
+			values[i++] = Int64GetDatum(idx_tup_fetch +
+							(tabentry ? tabentry->tuples_fetched : 0));
+		}
+		else
+		{
+			nulls[i++] = true;
+			nulls[i++] = true;
+		}
+
+		values[i++] = Int64GetDatum(tabentry ? tabentry->tuples_inserted : 0);
+		values[i++] = Int64GetDatum(tabentry ? tabentry->tuples_updated : 0);
+		values[i++] = Int64GetDatum(tabentry ? tabentry->tuples_deleted : 0);
+		values[i++] = Int64GetDatum(tabentry ? tabentry->tuples_hot_updated : 0);
+		values[i++] = Int64GetDatum(tabentry ? tabentry->live_tuples : 0);
+		values[i++] = Int64GetDatum(tabentry ? tabentry->dead_tuples : 0);
+		values[i++] = Int64GetDatum(tabentry ? tabentry->mod_since_analyze : 0);
+		values[i++] = Int64GetDatum(tabentry ?
+							tabentry->blocks_fetched - tabentry->blocks_hit : 0);
+		values[i++] = Int64GetDatum(tabentry ? tabentry->blocks_hit : 0);
+
+		if (relindexes)
+		{
+			values[i++] = Int64GetDatum(idx_blks_fetched - idx_blks_hit);
+			values[i++] = Int64GetDatum(idx_blks_hit);
+		}
+		else
+		{
+			nulls[i++] = true;
+			nulls[i++] = true;
+		}
+
+		if (OidIsValid(classForm->reltoastrelid))
+		{
+			values[i++] = Int64GetDatum(toastentry ?
+							toastentry->blocks_fetched - toastentry->blocks_hit : 0);
+			values[i++] = Int64GetDatum(toastentry ? toastentry->blocks_hit : 0);
+		}
+		else
+		{
+			nulls[i++] = true;
+			nulls[i++] = true;
+		}
+
+		if (OidIsValid(toastidxid))
+		{
+			PgStat_StatTabEntry *tidxentry;
+
+			tidxentry = pgstat_fetch_stat_tabentry_ext(classForm->relisshared,
+													   toastidxid);
+			values[i++] = Int64GetDatum(tidxentry ?
+							tidxentry->blocks_fetched - tidxentry->blocks_hit : 0);
+			values[i++] = Int64GetDatum(tidxentry ? tidxentry->blocks_hit : 0);
+		}
+		else
+		{
+			nulls[i++] = true;
+			nulls[i++] = true;
+		}
+
+#define PUT_TIMESTAMP(field) \
+		do { \
+			if (tabentry && tabentry->field != 0) \
+				values[i++] = TimestampTzGetDatum(tabentry->field); \
+			else \
+				nulls[i++] = true; \
+		} while (0)
+
+		PUT_TIMESTAMP(last_vacuum_time);
+		PUT_TIMESTAMP(last_autovacuum_time);
+		PUT_TIMESTAMP(last_analyze_time);
+		PUT_TIMESTAMP(last_autoanalyze_time);
+
+#undef PUT_TIMESTAMP
+
+		Assert(i == lengthof(values));
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+	systable_endscan(scan);
+	table_close(rel, AccessShareLock);
+
+	hash_destroy(indexes);
+
+	return (Datum) 0;
+}
+
+/*
+ * statsinfo_indexes - get statistics of indexes on tables
+ */
+Datum
+statsinfo_indexes(PG_FUNCTION_ARGS)
+{
+	Tuplestorestate	   *tupstore;
+	TupleDesc			tupdesc;
+	List			   *excluded;
+	Relation			rel;
+	SysScanDesc			scan;
+	HeapTuple			tuple;
+	HASHCTL				ctl;
+	HTAB			   *targets;
+
+	tupstore = init_materialize(fcinfo, &tupdesc, NUM_INDEXES_COLS);
+	excluded = get_excluded_namespaces(PG_GETARG_TEXT_PP(0));
+
+	/* collect the tables whose indexes are reported */
+	ctl.keysize = sizeof(Oid);
+	ctl.entrysize = sizeof(Oid);
+	ctl.hcxt = CurrentMemoryContext;
+	targets = hash_create("Target Tables", 1024, &ctl,
+						  HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+
+	rel = table_open(RelationRelationId, AccessShareLock);
+	scan = systable_beginscan(rel, InvalidOid, false, NULL, 0, NULL);
+	while (HeapTupleIsValid(tuple = systable_getnext(scan)))
+	{
+		Form_pg_class	classForm = (Form_pg_class) GETSTRUCT(tuple);
+
+		if (is_target_table(classForm, excluded))
+			hash_search(targets, &classForm->oid, HASH_ENTER, NULL);
+	}
+	systable_endscan(scan);
+	table_close(rel, AccessShareLock);
+
+	rel = table_open(IndexRelationId, AccessShareLock);
+	scan = systable_beginscan(rel, InvalidOid, false, NULL, 0, NULL);
+	while (HeapTupleIsValid(tuple = systable_getnext(scan)))
+	{
+		Form_pg_index		indexForm = (Form_pg_index) GETSTRUCT(tuple);
+		Form_pg_class		classForm;
+		HeapTuple			classTuple;
+		PgStat_StatTabEntry *idxentry;
+		Datum				values[NUM_INDEXES_COLS];
+		bool				nulls[NUM_INDEXES_COLS];
+		int					i;
+
+		CHECK_FOR_INTERRUPTS();
+
+		if (hash_search(targets, &indexForm->indrelid, HASH_FIND, NULL) == NULL)
+			continue;
+
+		classTuple = SearchSysCache1(RELOID,
+									 ObjectIdGetDatum(indexForm->indexrelid));
+		if (!HeapTupleIsValid(classTuple))
+			continue;	/* dropped concurrently */
+		classForm = (Form_pg_class) GETSTRUCT(classTuple);
+
+		memset(values, 0, sizeof(values));
+		memset(nulls, 0, sizeof(nulls));
+
+		idxentry = pgstat_fetch_stat_tabentry_ext(classForm->relisshared,
+												  classForm->oid);
+
+		i = 0;
+		values[i++] = ObjectIdGetDatum(indexForm->indexrelid);
+		values[i++] = ObjectIdGetDatum(indexForm->indrelid);
+		values[i++] = ObjectIdGetDatum(classForm->reltablespace);
+		values[i++] = NameGetDatum(&classForm->relname);
+		values[i++] = ObjectIdGetDatum(classForm->relam);
+		values[i++] = Int32GetDatum(classForm->relpages);
+		values[i++] = Float4GetDatum(classForm->reltuples);
+		values[i] = SysCacheGetAttr(RELOID, classTuple,
+									Anum_pg_class_reloptions, &nulls[i]);
+		i++;
+		values[i++] = BoolGetDatum(indexForm->indisunique);
+		values[i++] = BoolGetDatum(indexForm->indisprimary);
+		values[i++] = BoolGetDatum(indexForm->indisclustered);
+		values[i++] = BoolGetDatum(indexForm->indisvalid);
+		values[i++] = PointerGetDatum(&indexForm->indkey);
+		values[i] = get_indexdef(indexForm->indexrelid, &nulls[i]);
+		i++;
+		values[i++] = Int64GetDatum(relation_size(classForm));
+		values[i++] = Int64GetDatum(idxentry ? idxentry->numscans : 0);
+		values[i++] = Int64GetDatum(idxentry ? idxentry->tuples_returned : 0);
+		values[i++] = Int64GetDatum(idxentry ? idxentry->tuples_fetched : 0);
+		values[i++] = Int64GetDatum(idxentry ?
+						idxentry->blocks_fetched - idxentry->blocks_hit : 0);
+		values[i++] = Int64GetDatum(idxentry ? idxentry->blocks_hit : 0);
+
+		Assert(i == lengthof(values));
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+
+		ReleaseSysCache(classTuple);
+	}
+	systable_endscan(scan);
+	table_close(rel, AccessShareLock);
+
+	hash_destroy(targets);
+
+	return (Datum) 0;
+}
+
+/*
+ * init_materialize - set up the tuplestore to return rows in
+ */
+static Tuplestorestate *
+init_materialize(FunctionCallInfo fcinfo, TupleDesc *tupdesc, int natts)
+{
+	ReturnSetInfo	   *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	Tuplestorestate	   *tupstore;
+	MemoryContext		per_query_ctx;
+	MemoryContext		oldcontext;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+	if ((*tupdesc)->natts != natts)
+		elog(ERROR, "incorrect number of output arguments");
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = *tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	return tupstore;
+}
+
+/*
+ * get_excluded_namespaces - get OIDs of the schemas in the comma-separated
+ * list, in the same format as pg_statsinfo.excluded_schemas
+ */
+static List *
+get_excluded_namespaces(text *schemas)
+{
+	char	   *rawstring = text_to_cstring(schemas);
+	List	   *names;
+	List	   *result = NIL;
+	ListCell   *cell;
+
+	if (!SplitGUCList(rawstring, ',', &names))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid list syntax of excluded schemas: \"%s\"",
+						text_to_cstring(schemas))));
+
+	foreach(cell, names)
+	{
+		Oid		nspid = get_namespace_oid((const char *) lfirst(cell), true);
+
+		if (OidIsValid(nspid))
+			result = lappend_oid(result, nspid);
+	}
+
+	list_free(names);
+
+	return result;
+}
+
+/*
+ * is_target_table - is the relation a table whose statistics are collected?
+ */
+static bool
+is_target_table(Form_pg_class classForm, List *excluded)
+{
+	if (classForm->relkind != RELKIND_RELATION &&
+		classForm->relkind != RELKIND_TOASTVALUE)
+		return false;
+
+	return !list_member_oid(excluded, classForm->relnamespace);
+}
+
+/*
+ * get_valid_indexes - build a hashtable of valid indexes per table
+ */
+static HTAB *
+get_valid_indexes(void)
+{
+	HASHCTL		ctl;
+	HTAB	   *result;
+	Relation	rel;
+	SysScanDesc	scan;
+	HeapTuple	tuple;
+
+	ctl.keysize = sizeof(Oid);
+	ctl.entrysize = sizeof(RelIndexesEntry);
+	ctl.hcxt = CurrentMemoryContext;
+	result = hash_create("Valid Indexes", 1024, &ctl,
+						 HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+
+	rel = table_open(IndexRelationId, AccessShareLock);
+	scan = systable_beginscan(rel, InvalidOid, false, NULL, 0, NULL);
+	while (HeapTupleIsValid(tuple = systable_getnext(scan)))
+	{
+		Form_pg_index		indexForm = (Form_pg_index) GETSTRUCT(tuple);
+		RelIndexesEntry	   *entry;
+		bool				found;
+
+		if (!indexForm->indisvalid)
+			continue;
+
+		entry = (RelIndexesEntry *)
+			hash_search(result, &indexForm->indrelid, HASH_ENTER, &found);
+		if (!found)
+			entry->indexes = NIL;
+		entry->indexes = lappend_oid(entry->indexes, indexForm->indexrelid);
+	}
+	systable_endscan(scan);
+	table_close(rel, AccessShareLock);
+
+	return result;
+}
+
+/*
+ * relation_size - get the size of the main fork of the relation
+ *
+ * Same as pg_relation_size(), but the path is computed from the pg_class
+ * entry so that the relation need not be opened and locked.
+ */
+static int64
+relation_size(Form_pg_class classForm)
+{
+	RelFileLocator	rlocator;
+	ProcNumber		backend;
+	char		   *relationpath;
+	int64			totalsize = 0;
+	unsigned int	segcount;
+
+	if (!RELKIND_HAS_STORAGE(classForm->relkind))
+		return 0;
+
+	rlocator.spcOid = OidIsValid(classForm->reltablespace) ?
+		classForm->reltablespace : MyDatabaseTableSpace;
+	rlocator.dbOid = (rlocator.spcOid == GLOBALTABLESPACE_OID) ?
+		InvalidOid : MyDatabaseId;
+	if (RelFileNumberIsValid(classForm->relfilenode))
+		rlocator.relNumber = classForm->relfilenode;
+	else
+		rlocator.relNumber = RelationMapOidToFilenumber(classForm->oid,
+														classForm->relisshared);
+	if (!RelFileNumberIsValid(rlocator.relNumber))
+		return 0;
+
+	switch (classForm->relpersistence)
+	{
+		case RELPERSISTENCE_UNLOGGED:
+		case RELPERSISTENCE_PERMANENT:
+			backend = INVALID_PROC_NUMBER;
+			break;
+		case RELPERSISTENCE_TEMP:
+			if (isTempOrTempToastNamespace(classForm->relnamespace))
+				backend = ProcNumberForTempRelations();
+			else
+				backend = GetTempNamespaceProcNumber(classForm->relnamespace);
+			break;
+		default:
+			return 0;
+	}
+
+	relationpath = relpathbackend(rlocator, backend, MAIN_FORKNUM);
+
+	for (segcount = 0;; segcount++)
+	{
+		char		pathname[MAXPGPATH];
+		struct stat	fst;
+
+		if (segcount == 0)
+			snprintf(pathname, MAXPGPATH, "%s", relationpath);
+		else
+			snprintf(pathname, MAXPGPATH, "%s.%u", relationpath, segcount);
+
+		if (stat(pathname, &fst) < 0)
+		{
+			if (errno == ENOENT)
+				break;
+			else
+				ereport(ERROR,
+						(errcode_for_file_access(),
+						 errmsg("could not stat file \"%s\": %m", pathname)));
+		}
+		totalsize += fst.st_size;
+	}
+
+	pfree(relationpath);
+
+	return totalsize;
+}
+
+/*
+ * get_indexdef - get the definition of the index, or null if it has been
+ * dropped concurrently
+ */
+static Datum
+get_indexdef(Oid indexrelid, bool *isnull)
+{
+	LOCAL_FCINFO(fcinfo, 1);
+	Datum		result;
+
+	InitFunctionCallInfoData(*fcinfo, NULL, 1, InvalidOid, NULL, NULL);
+	fcinfo->args[0].value = ObjectIdGetDatum(indexrelid);
+	fcinfo->args[0].isnull = false;
+
+	result = pg_get_indexdef(fcinfo);
+	*isnull = fcinfo->isnull;
+
+	return result;
+}
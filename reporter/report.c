@@ -46,10 +46,19 @@ SELECT \
 	'(' || pg_catalog.avg(running_per)::numeric(10,1) || ' %)' \
 FROM \
 	statsrepo.get_proc_tendency_report($1, $2)"
+#define SQL_SELECT_INSTANCE_TS_TENDENCY			"\
+SELECT * FROM \
+( \
+	SELECT * FROM statsrepo.get_instance_ts_tendency($1, $2) \
+	ORDER BY 1 DESC LIMIT 360 \
+) t \
+ORDER BY 1"
 #define SQL_SELECT_BGWRITER_STATS				"SELECT * FROM statsrepo.get_bgwriter_stats($1, $2)"
+#define SQL_SELECT_BUFFERCACHE					"SELECT * FROM statsrepo.get_buffercache($1, $2) LIMIT 20"
 #define SQL_SELECT_WALSTATS						"SELECT * FROM statsrepo.get_wal_stats($1, $2)"
 #define SQL_SELECT_WALSTATS_TENDENCY			"SELECT * FROM statsrepo.get_wal_tendency($1, $2)"
 #define SQL_SELECT_STAT_WAL						"SELECT * FROM statsrepo.get_stat_wal($1, $2)"
+#define SQL_SELECT_WAL_COMPOSITION				"SELECT * FROM statsrepo.get_wal_composition($1, $2) LIMIT 20"
 #define SQL_SELECT_XID_INCREASE_TENDENCY		"SELECT * FROM statsrepo.get_xid_tendency($1, $2)"
 
 #define SQL_SELECT_CPU_LOADAVG_TENDENCY "\
@@ -67,6 +76,7 @@ SELECT \
 FROM \
 	statsrepo.get_cpu_loadavg_tendency($1, $2)"
 #define SQL_SELECT_MEMORY_TENDENCY				"SELECT * FROM statsrepo.get_memory_tendency($1, $2)"
+#define SQL_SELECT_BACKEND_MEMORY				"SELECT * FROM statsrepo.get_backend_memory($1, $2) LIMIT 10"
 #define SQL_SELECT_IO_USAGE						"SELECT * FROM statsrepo.get_io_usage($1, $2)"
 #define SQL_SELECT_IO_USAGE_TENDENCY			"SELECT * FROM statsrepo.get_io_usage_tendency_report($1, $2)"
 #define SQL_SELECT_DISK_USAGE_TABLESPACE		"SELECT * FROM statsrepo.get_disk_usage_tablespace($1, $2)"
@@ -150,6 +160,17 @@ SELECT \
 	mod_rows_max \
 FROM \
 	statsrepo.get_autoanalyze_stats($1, $2)"
+#define SQL_SELECT_PROGRESS_PHASES "\
+SELECT \
+	command, \
+	COALESCE(datname || '.' || nspname || '.' || relname, relname), \
+	phase, \
+	\"count\", \
+	total_duration, \
+	max_duration, \
+	blocks_per_sec \
+FROM \
+	statsrepo.get_progress_phases($1, $2) LIMIT 20"
 #define SQL_SELECT_QUERY_ACTIVITY_FUNCTIONS		"SELECT * FROM statsrepo.get_query_activity_functions($1, $2) LIMIT 20"
 #define SQL_SELECT_QUERY_ACTIVITY_STATEMENTS	"SELECT * FROM statsrepo.get_query_activity_statements($1, $2) LIMIT 20"
 #define SQL_SELECT_QUERY_ACTIVITY_STATEMENTS_RUSAGE	"SELECT * FROM statsrepo.get_query_activity_statements_rusage($1, $2) LIMIT 20"
@@ -178,6 +199,27 @@ SELECT \
 	pg_catalog.to_char(replay_lag_time, 'HH24:MI:SS.US') \
 FROM \
 	statsrepo.get_replication_activity($1, $2)"
+#define SQL_SELECT_REPLICATION_LAG "\
+SELECT \
+	application_name, \
+	procpid, \
+	samples, \
+	pg_catalog.to_char(write_lag_max, 'HH24:MI:SS.US'), \
+	pg_catalog.to_char(flush_lag_max, 'HH24:MI:SS.US'), \
+	pg_catalog.to_char(replay_lag_min, 'HH24:MI:SS.US'), \
+	pg_catalog.to_char(replay_lag_p99, 'HH24:MI:SS.US'), \
+	pg_catalog.to_char(replay_lag_max, 'HH24:MI:SS.US') \
+FROM \
+	statsrepo.get_replication_lag($1, $2)"
+#define SQL_SELECT_REPLICATION_SLOT_RETENTION "\
+SELECT \
+	slot_name, \
+	samples, \
+	statsrepo.pg_size_pretty(retained_min), \
+	statsrepo.pg_size_pretty(retained_p99), \
+	statsrepo.pg_size_pretty(retained_max) \
+FROM \
+	statsrepo.get_replication_slot_retention($1, $2)"
 #define SQL_SELECT_SETTING_PARAMETERS			"SELECT * FROM statsrepo.get_setting_parameters($1, $2)"
 #define SQL_SELECT_SCHEMA_INFORMATION_TABLES	"SELECT * FROM statsrepo.get_schema_info_tables($1, $2)"
 #define SQL_SELECT_SCHEMA_INFORMATION_INDEXES	"SELECT * FROM statsrepo.get_schema_info_indexes($1, $2)"
@@ -638,6 +680,27 @@ report_instance_activity(PGconn *conn, ReportScope *scope, FILE *out)
 	fprintf(out, "\n");
 	PQclear(res);
 
+	fprintf(out, "/** WAL Composition **/\n");
+	fprintf(out, "-----------------------------------\n");
+	fprintf(out, "%-16s  %-24s  %12s  %12s  %12s  %12s  %8s\n",
+		"Resource Manager", "Record Type", "Count", "Record Size", "FPI Size", "Combined Size", "Ratio(%)");
+	fprintf(out, "-------------------------------------------------------------------------------------------------------------\n");
+
+	res = pgut_execute(conn, SQL_SELECT_WAL_COMPOSITION, lengthof(params), params);
+	for(i = 0; i < PQntuples(res); i++)
+	{
+		fprintf(out, "%-16s  %-24s  %12s  %8s MiB  %8s MiB  %9s MiB  %8s\n",
+			PQgetvalue(res, i, 0),
+			PQgetvalue(res, i, 1),
+			PQgetvalue(res, i, 2),
+			PQgetvalue(res, i, 3),
+			PQgetvalue(res, i, 4),
+			PQgetvalue(res, i, 5),
+			PQgetvalue(res, i, 6));
+	}
+	fprintf(out, "\n");
+	PQclear(res);
+
 	fprintf(out, "/** Instance Processes **/\n");
 	fprintf(out, "-----------------------------------\n");
 	fprintf(out, "%-16s  %12s  %12s  %12s  %12s  %12s  %12s  %12s  %12s\n",
@@ -661,6 +724,50 @@ report_instance_activity(PGconn *conn, ReportScope *scope, FILE *out)
 	fprintf(out, "\n");
 	PQclear(res);
 
+	/* the mini-snapshots are reported only when they have been taken */
+	res = pgut_execute(conn, SQL_SELECT_INSTANCE_TS_TENDENCY, lengthof(params), params);
+	if (PQntuples(res) > 0)
+	{
+		fprintf(out, "/** Transaction and I/O Tendency (Mini-Snapshot) **/\n");
+		fprintf(out, "-----------------------------------\n");
+		fprintf(out, "%-19s  %12s  %12s  %12s  %8s  %12s  %12s  %12s\n",
+			"DateTime", "Commit/s", "Rollback/s", "Read/s", "Hit(%)", "WAL MiB/s", "I/O Read/s", "I/O Write/s");
+		fprintf(out, "-------------------------------------------------------------------------------------------------------------\n");
+		for(i = 0; i < PQntuples(res); i++)
+		{
+			fprintf(out, "%-19s  %12s  %12s  %12s  %8s  %12s  %12s  %12s\n",
+				PQgetvalue(res, i, 0),
+				PQgetvalue(res, i, 1),
+				PQgetvalue(res, i, 2),
+				PQgetvalue(res, i, 3),
+				PQgetvalue(res, i, 4),
+				PQgetvalue(res, i, 5),
+				PQgetvalue(res, i, 6),
+				PQgetvalue(res, i, 7));
+		}
+		fprintf(out, "\n");
+
+		fprintf(out, "/** Buffers and Sessions Tendency (Mini-Snapshot) **/\n");
+		fprintf(out, "-----------------------------------\n");
+		fprintf(out, "%-19s  %12s  %12s  %11s  %14s  %8s  %12s  %8s\n",
+			"DateTime", "Cleaned/s", "Allocated/s", "Checkpoints", "Checkpointed/s", "Active", "Idle In Xact", "Waiting");
+		fprintf(out, "---------------------------------------------------------------------------------------------------------------\n");
+		for(i = 0; i < PQntuples(res); i++)
+		{
+			fprintf(out, "%-19s  %12s  %12s  %11s  %14s  %8s  %12s  %8s\n",
+				PQgetvalue(res, i, 0),
+				PQgetvalue(res, i, 8),
+				PQgetvalue(res, i, 9),
+				PQgetvalue(res, i, 10),
+				PQgetvalue(res, i, 11),
+				PQgetvalue(res, i, 12),
+				PQgetvalue(res, i, 13),
+				PQgetvalue(res, i, 14));
+		}
+		fprintf(out, "\n");
+	}
+	PQclear(res);
+
 	fprintf(out, "/** BGWriter Statistics **/\n");
 	fprintf(out, "-----------------------------------\n");
 
@@ -673,6 +780,32 @@ report_instance_activity(PGconn *conn, ReportScope *scope, FILE *out)
 	fprintf(out, "Backend Executed fsync (Maximum)      : %s sync/s\n\n", PQgetvalue(res, 0, 5));
 	PQclear(res);
 
+	fprintf(out, "/** Shared Buffers Residency **/\n");
+	fprintf(out, "-----------------------------------\n");
+	fprintf(out, "%-16s  %-16s  %-24s  %-4s  %12s  %12s  %12s  %8s  %-20s\n",
+		"Database", "Schema", "Relation", "Fork", "Buffers(Avg)", "Buffers(Max)",
+		"Size(Avg)", "Dirty(%)", "Usage 0-1/2-3/4-5(%)");
+	fprintf(out, "--------------------------------------------------------------------------------------------------------------------------------------------\n");
+
+	res = pgut_execute(conn, SQL_SELECT_BUFFERCACHE, lengthof(params), params);
+	for(i = 0; i < PQntuples(res); i++)
+	{
+		fprintf(out, "%-16s  %-16s  %-24s  %-4s  %12s  %12s  %8s MiB  %8s  %5s / %5s / %5s\n",
+			PQgetvalue(res, i, 0),
+			PQgetvalue(res, i, 1),
+			PQgetvalue(res, i, 2),
+			PQgetvalue(res, i, 3),
+			PQgetvalue(res, i, 4),
+			PQgetvalue(res, i, 5),
+			PQgetvalue(res, i, 6),
+			PQgetvalue(res, i, 7),
+			PQgetvalue(res, i, 8),
+			PQgetvalue(res, i, 9),
+			PQgetvalue(res, i, 10));
+	}
+	fprintf(out, "\n");
+	PQclear(res);
+
 	fprintf(out, "/** Transaction Increase Tendency **/\n");
 	fprintf(out, "-----------------------------------\n");
 	fprintf(out, "%-16s  %12s\n",
@@ -834,6 +967,31 @@ report_resource_usage(PGconn *conn, ReportScope *scope, FILE *out)
 	}
 	fprintf(out, "\n");
 	PQclear(res);
+
+	fprintf(out, "/** Backend Memory Peaks **/\n");
+	fprintf(out, "-----------------------------------\n");
+	fprintf(out, "%-8s  %-16s  %-16s  %-19s  %12s  %12s  %12s  %20s  %-15s  %-32s\n",
+		"PID", "Backend Type", "Database", "Peak Time", "RSS", "Anonymous", "Swap",
+		"Query ID", "Contexts Logged", "Query");
+	fprintf(out, "------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------\n");
+
+	res = pgut_execute(conn, SQL_SELECT_BACKEND_MEMORY, lengthof(params), params);
+	for(i = 0; i < PQntuples(res); i++)
+	{
+		fprintf(out, "%-8s  %-16s  %-16s  %-19s  %8s MiB  %8s MiB  %8s MiB  %20s  %-15s  %-32s\n",
+			PQgetvalue(res, i, 0),
+			PQgetvalue(res, i, 1),
+			PQgetvalue(res, i, 2),
+			PQgetvalue(res, i, 3),
+			PQgetvalue(res, i, 4),
+			PQgetvalue(res, i, 5),
+			PQgetvalue(res, i, 6),
+			PQgetvalue(res, i, 7),
+			PQgetvalue(res, i, 8),
+			PQgetvalue(res, i, 9));
+	}
+	fprintf(out, "\n");
+	PQclear(res);
 }
 
 /*
@@ -1192,6 +1350,28 @@ report_autovacuum_activity(PGconn *conn, ReportScope *scope, FILE *out)
 	}
 	fprintf(out, "\n");
 	PQclear(res);
+
+	fprintf(out, "/** Maintenance Progress Phases **/\n");
+	fprintf(out, "-----------------------------------\n");
+	fprintf(out, "%-25s  %-40s  %-40s  %8s  %15s  %15s  %12s\n",
+		"Command", "Table", "Phase", "Count", "Duration(Total)",
+		"Duration(Max)", "Blocks/s");
+	fprintf(out, "-----------------------------------------------------------------------------------------------------------------------------------------------------------------------\n");
+
+	res = pgut_execute(conn, SQL_SELECT_PROGRESS_PHASES, lengthof(params), params);
+	for(i = 0; i < PQntuples(res); i++)
+	{
+		fprintf(out, "%-25s  %-40s  %-40s  %8s  %13s s  %13s s  %12s\n",
+			PQgetvalue(res, i, 0),
+			PQgetvalue(res, i, 1),
+			PQgetvalue(res, i, 2),
+			PQgetvalue(res, i, 3),
+			PQgetvalue(res, i, 4),
+			PQgetvalue(res, i, 5),
+			PQgetvalue(res, i, 6));
+	}
+	fprintf(out, "\n");
+	PQclear(res);
 }
 
 /*
@@ -1463,6 +1643,48 @@ report_replication_activity(PGconn *conn, ReportScope *scope, FILE *out)
 	}
 	fprintf(out, "\n");
 	PQclear(res);
+
+	fprintf(out, "/** Replication Lag Samples **/\n");
+	fprintf(out, "-----------------------------------\n");
+	fprintf(out, "%-16s  %8s  %8s  %15s  %15s  %15s  %15s  %15s\n",
+		"Application Name", "PID", "Samples", "Write Lag Max", "Flush Lag Max",
+		"Replay Lag Min", "Replay Lag P99", "Replay Lag Max");
+	fprintf(out, "-------------------------------------------------------------------------------------------------------------------------\n");
+
+	res = pgut_execute(conn, SQL_SELECT_REPLICATION_LAG, lengthof(params), params);
+	for(i = 0; i < PQntuples(res); i++)
+	{
+		fprintf(out, "%-16s  %8s  %8s  %15s  %15s  %15s  %15s  %15s\n",
+			PQgetvalue(res, i, 0),
+			PQgetvalue(res, i, 1),
+			PQgetvalue(res, i, 2),
+			PQgetvalue(res, i, 3),
+			PQgetvalue(res, i, 4),
+			PQgetvalue(res, i, 5),
+			PQgetvalue(res, i, 6),
+			PQgetvalue(res, i, 7));
+	}
+	fprintf(out, "\n");
+	PQclear(res);
+
+	fprintf(out, "/** Replication Slot WAL Retention **/\n");
+	fprintf(out, "-----------------------------------\n");
+	fprintf(out, "%-15s  %8s  %12s  %12s  %12s\n",
+		"Slot Name", "Samples", "Retained Min", "Retained P99", "Retained Max");
+	fprintf(out, "-------------------------------------------------------------------\n");
+
+	res = pgut_execute(conn, SQL_SELECT_REPLICATION_SLOT_RETENTION, lengthof(params), params);
+	for(i = 0; i < PQntuples(res); i++)
+	{
+		fprintf(out, "%-15s  %8s  %12s  %12s  %12s\n",
+			PQgetvalue(res, i, 0),
+			PQgetvalue(res, i, 1),
+			PQgetvalue(res, i, 2),
+			PQgetvalue(res, i, 3),
+			PQgetvalue(res, i, 4));
+	}
+	fprintf(out, "\n");
+	PQclear(res);
 }
 
 /*
@@ -19,6 +19,7 @@ export PGOPTIONS=' -c intervalstyle=postgres'
 echo "/*---- Input the repository data ----*/"
 send_query -qf "$(pg_config --sharedir)/contrib/pg_statsrepo.sql"
 send_query -c "SELECT statsrepo.create_snapshot_partition('2012-11-01')" > /dev/null
+send_query -c "SELECT statsrepo.create_instance_ts_partition('2012-11-01')" > /dev/null
 send_query -qf ${INPUTDATA_REPOSITORY}
 send_query << EOF > /dev/null
 SELECT statsrepo.input_data(1, '5807946214009601530', 'statsinfo', 5432, '14.0', 1);
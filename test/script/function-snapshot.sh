@@ -89,8 +89,8 @@ FROM
 	statsrepo.schema s,
 	statsrepo.database d
 WHERE
-	s.snapid = (SELECT max(snapid) FROM statsrepo.snapshot)
-	AND s.snapid = d.snapid
+	d.snapid = (SELECT max(snapid) FROM statsrepo.snapshot)
+	AND s.snapid = statsrepo.version_snapid(d.snapid, d.dbid, 'schema')
 	AND s.dbid = d.dbid
 ORDER BY
 	database, schema;
@@ -149,7 +149,7 @@ FROM
 WHERE
 	t.snapid = (SELECT max(snapid) FROM statsrepo.snapshot)
 	AND t.snapid = d.snapid
-	AND t.snapid = s.snapid
+	AND s.snapid = statsrepo.version_snapid(t.snapid, t.dbid, 'schema')
 	AND t.snapid = ts.snapid
 	AND t.dbid = d.dbid
 	AND t.dbid = s.dbid
@@ -237,17 +237,17 @@ EOF
 echo "/**--- Statistics of inherits ---**/"
 send_query << EOF
 SELECT
-	i.snapid,
+	d.snapid,
 	d.name AS database,
-	(SELECT name FROM statsrepo.table WHERE snapid = i.snapid AND tbl = i.inhrelid) AS table,
-	(SELECT name FROM statsrepo.table WHERE snapid = i.snapid AND tbl = i.inhparent) AS parent,
+	(SELECT name FROM statsrepo.table WHERE snapid = d.snapid AND tbl = i.inhrelid) AS table,
+	(SELECT name FROM statsrepo.table WHERE snapid = d.snapid AND tbl = i.inhparent) AS parent,
 	i.inhseqno
 FROM
 	statsrepo.inherits i,
 	statsrepo.database d
 WHERE
-	i.snapid = (SELECT max(snapid) FROM statsrepo.snapshot)
-	AND i.snapid = d.snapid
+	d.snapid = (SELECT max(snapid) FROM statsrepo.snapshot)
+	AND i.snapid = statsrepo.version_snapid(d.snapid, d.dbid, 'inherits')
 	AND i.dbid = d.dbid
 ORDER BY
 	database, "table";
@@ -256,23 +256,27 @@ EOF
 echo "/**--- Statistics of SQL function ---**/"
 send_query << EOF
 SELECT
-	f.snapid,
+	d.snapid,
 	d.name AS database,
 	s.name AS schema,
 	f.funcname,
 	CASE WHEN f.funcid IS NOT NULL THEN 'xxx' END AS funcid,
 	CASE WHEN f.argtypes IS NOT NULL THEN 'xxx' END AS argtypes,
-	CASE WHEN f.calls IS NOT NULL THEN 'xxx' END AS calls,
-	CASE WHEN f.total_time IS NOT NULL THEN 'xxx' END AS total_time,
-	CASE WHEN f.self_time IS NOT NULL THEN 'xxx' END AS self_time
+	CASE WHEN sf.calls IS NOT NULL THEN 'xxx' END AS calls,
+	CASE WHEN sf.total_time IS NOT NULL THEN 'xxx' END AS total_time,
+	CASE WHEN sf.self_time IS NOT NULL THEN 'xxx' END AS self_time
 FROM
 	statsrepo.function f,
+	statsrepo.stat_function sf,
 	statsrepo.database d,
 	statsrepo.schema s
 WHERE
-	f.snapid = (SELECT max(snapid) FROM statsrepo.snapshot)
-	AND f.snapid = d.snapid
-	AND f.snapid = s.snapid
+	d.snapid = (SELECT max(snapid) FROM statsrepo.snapshot)
+	AND f.snapid = statsrepo.version_snapid(d.snapid, d.dbid, 'function')
+	AND sf.snapid = d.snapid
+	AND sf.dbid = d.dbid
+	AND sf.funcid = f.funcid
+	AND s.snapid = statsrepo.version_snapid(d.snapid, d.dbid, 'schema')
 	AND f.dbid = d.dbid
 	AND f.dbid = s.dbid
 	AND f.nsp = s.nsp
@@ -577,7 +581,7 @@ SELECT
 	s.snapid,
 	d.name AS database,
 	r.name AS role,
-	s.query,
+	q.query,
 	s.plans,
 	CASE WHEN s.total_plan_time IS NOT NULL THEN 'xxx' END AS total_plan_time,
 	s.calls,
@@ -600,13 +604,16 @@ SELECT
 	CASE WHEN s.temp_blk_read_time IS NOT NULL THEN 'xxx' END AS temp_blk_read_time,
 	CASE WHEN s.temp_blk_write_time IS NOT NULL THEN 'xxx' END AS temp_blk_write_time
 FROM
-	statsrepo.statement s,
+	statsrepo.statement s
+	LEFT JOIN statsrepo.query_text q ON
+		(q.queryid = s.queryid AND q.dbid = s.dbid AND
+		 q.userid = s.userid AND q.hash = s.query_hash),
 	statsrepo.database d,
 	statsrepo.role r
 WHERE
 	s.snapid = (SELECT max(snapid) FROM statsrepo.snapshot)
 	AND s.snapid = d.snapid
-	AND s.snapid = r.snapid
+	AND r.snapid = statsrepo.version_snapid(s.snapid, 0, 'role')
 	AND s.dbid = d.dbid
 	AND s.userid = r.userid
 ORDER BY
@@ -673,9 +680,9 @@ get_snapshot
 send_query -c "SELECT (COUNT(*) > 0) as cnt FROM statsrepo.column WHERE snapid = (SELECT max(snapid) FROM statsrepo.snapshot)"
 send_query -c "SELECT (COUNT(*) > 0) as cnt FROM statsrepo.index WHERE snapid = (SELECT max(snapid) FROM statsrepo.snapshot)"
 send_query -c "SELECT (COUNT(*) > 0) as cnt  FROM statsrepo.table WHERE snapid = (SELECT max(snapid) FROM statsrepo.snapshot)"
-send_query -c "SELECT (COUNT(*) > 0) as cnt  FROM statsrepo.inherits WHERE snapid = (SELECT max(snapid) FROM statsrepo.snapshot)"
-send_query -c "SELECT (COUNT(*) > 0) as cnt  FROM statsrepo.function WHERE snapid = (SELECT max(snapid) FROM statsrepo.snapshot)"
-send_query -c "SELECT (COUNT(*) > 0) as cnt  FROM statsrepo.schema WHERE snapid = (SELECT max(snapid) FROM statsrepo.snapshot)"
+send_query -c "SELECT (COUNT(*) > 0) as cnt  FROM statsrepo.inherits i, statsrepo.database d WHERE d.snapid = (SELECT max(snapid) FROM statsrepo.snapshot) AND i.dbid = d.dbid AND i.snapid = statsrepo.version_snapid(d.snapid, d.dbid, 'inherits')"
+send_query -c "SELECT (COUNT(*) > 0) as cnt  FROM statsrepo.function f, statsrepo.database d WHERE d.snapid = (SELECT max(snapid) FROM statsrepo.snapshot) AND f.dbid = d.dbid AND f.snapid = statsrepo.version_snapid(d.snapid, d.dbid, 'function')"
+send_query -c "SELECT (COUNT(*) > 0) as cnt  FROM statsrepo.schema s, statsrepo.database d WHERE d.snapid = (SELECT max(snapid) FROM statsrepo.snapshot) AND s.dbid = d.dbid AND s.snapid = statsrepo.version_snapid(d.snapid, d.dbid, 'schema')"
 
 psql -c "ALTER SYSTEM SET pg_statsinfo.collect_column = on"
 psql -c "ALTER SYSTEM SET pg_statsinfo.collect_index = on"
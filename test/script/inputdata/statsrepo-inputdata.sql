@@ -131,10 +131,18 @@ $$
 	--
 	-- Data for Name: function; Type: TABLE DATA; Schema: statsrepo; Owner: postgres
 	--
-	INSERT INTO statsrepo.function VALUES ($6, 12870, 16392, 16391, 'sample', '', 10, 0.0899999999999999967, 0.0899999999999999967);
-	INSERT INTO statsrepo.function VALUES ($6 + 1, 12870, 16392, 16391, 'sample', '', 22, 0.165000000000000008, 0.165000000000000008);
-	INSERT INTO statsrepo.function VALUES ($6 + 2, 12870, 16392, 16391, 'sample', '', 34, 0.262000000000000011, 0.262000000000000011);
-	INSERT INTO statsrepo.function VALUES ($6 + 3, 12870, 16392, 16391, 'sample', '', 46, 0.390000000000000013, 0.390000000000000013);
+	INSERT INTO statsrepo.function VALUES ($6, 12870, 16392, 16391, 'sample', '');
+	INSERT INTO statsrepo.function VALUES ($6 + 1, 12870, 16392, 16391, 'sample', '');
+	INSERT INTO statsrepo.function VALUES ($6 + 2, 12870, 16392, 16391, 'sample', '');
+	INSERT INTO statsrepo.function VALUES ($6 + 3, 12870, 16392, 16391, 'sample', '');
+
+	--
+	-- Data for Name: stat_function; Type: TABLE DATA; Schema: statsrepo; Owner: postgres
+	--
+	INSERT INTO statsrepo.stat_function VALUES ($6, 12870, 16392, 10, 0.0899999999999999967, 0.0899999999999999967);
+	INSERT INTO statsrepo.stat_function VALUES ($6 + 1, 12870, 16392, 22, 0.165000000000000008, 0.165000000000000008);
+	INSERT INTO statsrepo.stat_function VALUES ($6 + 2, 12870, 16392, 34, 0.262000000000000011, 0.262000000000000011);
+	INSERT INTO statsrepo.stat_function VALUES ($6 + 3, 12870, 16392, 46, 0.390000000000000013, 0.390000000000000013);
 
 	--
 	-- Data for Name: schema; Type: TABLE DATA; Schema: statsrepo; Owner: postgres
@@ -286,21 +294,34 @@ $$
 	INSERT INTO statsrepo.memory VALUES ($6 + 2, 149148, 26288, 659236, 67440, 5328);
 	INSERT INTO statsrepo.memory VALUES ($6 + 3, 143180, 26436, 662056, 67440, 592);
 
+	--
+	-- Data for Name: plan_text; Type: TABLE DATA; Schema: statsrepo; Owner: postgres
+	--
+	INSERT INTO statsrepo.plan_text VALUES (1970669142, 1, '{"p":{"t":"b","!":"u","n":"pgbench_accounts","a":"pgbench_accounts","1":0.29,"2":8.31,"3":1,"4":103,"l":[{"t":"i","h":"m","d":"f","i":"pgbench_accounts_pkey","n":"pgbench_accounts","a":"pgbench_accounts","1":0.29,"2":8.31,"3":1,"4":103,"8":"(aid = 46216)"}]}}') ON CONFLICT DO NOTHING;
+	INSERT INTO statsrepo.plan_text VALUES (4132319976, 2, '{"p":{"t":"b","!":"u","n":"pgbench_branches","a":"pgbench_branches","1":0.00,"2":1.01,"3":1,"4":106,"l":[{"t":"h","h":"m","n":"pgbench_branches","a":"pgbench_branches","1":0.00,"2":1.01,"3":1,"4":106,"5":"(bid = 1)"}]}}') ON CONFLICT DO NOTHING;
+	INSERT INTO statsrepo.plan_text VALUES (487339097, 3, '{"p":{"t":"b","!":"u","n":"pgbench_tellers","a":"pgbench_tellers","1":0.00,"2":1.13,"3":1,"4":106,"l":[{"t":"h","h":"m","n":"pgbench_tellers","a":"pgbench_tellers","1":0.00,"2":1.13,"3":1,"4":106,"5":"(tid = 2)"}]}}') ON CONFLICT DO NOTHING;
+	INSERT INTO statsrepo.plan_text VALUES (1970669142, 4, '{"p":{"t":"b","!":"u","n":"pgbench_accounts","a":"pgbench_accounts","1":0.29,"2":8.31,"3":1,"4":103,"l":[{"t":"i","h":"m","d":"f","i":"pgbench_accounts_pkey","n":"pgbench_accounts","a":"pgbench_accounts","1":0.29,"2":8.31,"3":1,"4":103,"8":"(aid = 60907)"}]}}') ON CONFLICT DO NOTHING;
+	INSERT INTO statsrepo.plan_text VALUES (487339097, 5, '{"p":{"t":"b","!":"u","n":"pgbench_tellers","a":"pgbench_tellers","1":0.00,"2":1.13,"3":1,"4":106,"l":[{"t":"h","h":"m","n":"pgbench_tellers","a":"pgbench_tellers","1":0.00,"2":1.13,"3":1,"4":106,"5":"(tid = 5)"}]}}') ON CONFLICT DO NOTHING;
+	INSERT INTO statsrepo.plan_text VALUES (1970669142, 6, '{"p":{"t":"b","!":"u","n":"pgbench_accounts","a":"pgbench_accounts","1":0.29,"2":8.31,"3":1,"4":103,"l":[{"t":"i","h":"m","d":"f","i":"pgbench_accounts_pkey","n":"pgbench_accounts","a":"pgbench_accounts","1":0.29,"2":8.31,"3":1,"4":103,"8":"(aid = 65971)"}]}}') ON CONFLICT DO NOTHING;
+	INSERT INTO statsrepo.plan_text VALUES (487339097, 7, '{"p":{"t":"b","!":"u","n":"pgbench_tellers","a":"pgbench_tellers","1":0.00,"2":1.13,"3":1,"4":106,"l":[{"t":"h","h":"m","n":"pgbench_tellers","a":"pgbench_tellers","1":0.00,"2":1.13,"3":1,"4":106,"5":"(tid = 1)"}]}}') ON CONFLICT DO NOTHING;
+	INSERT INTO statsrepo.plan_text VALUES (1970669142, 8, '{"p":{"t":"b","!":"u","n":"pgbench_accounts","a":"pgbench_accounts","1":0.29,"2":8.31,"3":1,"4":103,"l":[{"t":"i","h":"m","d":"f","i":"pgbench_accounts_pkey","n":"pgbench_accounts","a":"pgbench_accounts","1":0.29,"2":8.31,"3":1,"4":103,"8":"(aid = 9747)"}]}}') ON CONFLICT DO NOTHING;
+	INSERT INTO statsrepo.plan_text VALUES (487339097, 9, '{"p":{"t":"b","!":"u","n":"pgbench_tellers","a":"pgbench_tellers","1":0.00,"2":1.13,"3":1,"4":106,"l":[{"t":"h","h":"m","n":"pgbench_tellers","a":"pgbench_tellers","1":0.00,"2":1.13,"3":1,"4":106,"5":"(tid = 6)"}]}}') ON CONFLICT DO NOTHING;
+
 	--
 	-- Data for Name: plan; Type: TABLE DATA; Schema: statsrepo; Owner: postgres
 	--
-	INSERT INTO statsrepo.plan VALUES ($6, 12870, 10, 847103580, 1970669142, '{"p":{"t":"b","!":"u","n":"pgbench_accounts","a":"pgbench_accounts","1":0.29,"2":8.31,"3":1,"4":103,"l":[{"t":"i","h":"m","d":"f","i":"pgbench_accounts_pkey","n":"pgbench_accounts","a":"pgbench_accounts","1":0.29,"2":8.31,"3":1,"4":103,"8":"(aid = 46216)"}]}}', 823, 0.110259, 823, 6339, 275, 274, 0, 0, 0, 0, 0, 0, 0, 5.157, 0, 100, 200, 0, 0, '2012-11-01 00:00:00+09', '2012-11-01 00:00:00+09');
-	INSERT INTO statsrepo.plan VALUES ($6, 12870, 10, 1067368138, 4132319976, '{"p":{"t":"b","!":"u","n":"pgbench_branches","a":"pgbench_branches","1":0.00,"2":1.01,"3":1,"4":106,"l":[{"t":"h","h":"m","n":"pgbench_branches","a":"pgbench_branches","1":0.00,"2":1.01,"3":1,"4":106,"5":"(bid = 1)"}]}}', 823, 0.0374639999999999, 823, 1647, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 100, 200, 0, 0, '2012-11-01 00:00:00+09', '2012-11-01 00:00:00+09');
-	INSERT INTO statsrepo.plan VALUES ($6, 12870, 10, 1899262118, 487339097, '{"p":{"t":"b","!":"u","n":"pgbench_tellers","a":"pgbench_tellers","1":0.00,"2":1.13,"3":1,"4":106,"l":[{"t":"h","h":"m","n":"pgbench_tellers","a":"pgbench_tellers","1":0.00,"2":1.13,"3":1,"4":106,"5":"(tid = 2)"}]}}', 823, 0.0412209999999999, 823, 1647, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 100, 200, 0, 0, '2012-11-01 00:00:00+09', '2012-11-01 00:00:00+09');
-	INSERT INTO statsrepo.plan VALUES ($6 + 1, 12870, 10, 847103580, 1970669142, '{"p":{"t":"b","!":"u","n":"pgbench_accounts","a":"pgbench_accounts","1":0.29,"2":8.31,"3":1,"4":103,"l":[{"t":"i","h":"m","d":"f","i":"pgbench_accounts_pkey","n":"pgbench_accounts","a":"pgbench_accounts","1":0.29,"2":8.31,"3":1,"4":103,"8":"(aid = 60907)"}]}}', 1279, 0.153424, 1279, 9383, 288, 287, 0, 0, 0, 0, 0, 0, 0, 5.331, 0, 110, 210, 0, 0, '2012-11-01 00:00:00+09', '2012-11-01 00:01:00+09');
-	INSERT INTO statsrepo.plan VALUES ($6 + 1, 12870, 10, 1067368138, 4132319976, '{"p":{"t":"b","!":"u","n":"pgbench_branches","a":"pgbench_branches","1":0.00,"2":1.01,"3":1,"4":106,"l":[{"t":"h","h":"m","n":"pgbench_branches","a":"pgbench_branches","1":0.00,"2":1.01,"3":1,"4":106,"5":"(bid = 1)"}]}}', 1279, 0.0580179999999998, 1279, 2559, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 110, 210, 0, 0, '2012-11-01 00:00:00+09', '2012-11-01 00:01:00+09');
-	INSERT INTO statsrepo.plan VALUES ($6 + 1, 12870, 10, 1899262118, 487339097, '{"p":{"t":"b","!":"u","n":"pgbench_tellers","a":"pgbench_tellers","1":0.00,"2":1.13,"3":1,"4":106,"l":[{"t":"h","h":"m","n":"pgbench_tellers","a":"pgbench_tellers","1":0.00,"2":1.13,"3":1,"4":106,"5":"(tid = 5)"}]}}', 1279, 0.0619969999999996, 1279, 2559, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 110, 210, 0, 0, '2012-11-01 00:00:00+09', '2012-11-01 00:01:00+09');
-	INSERT INTO statsrepo.plan VALUES ($6 + 2, 12870, 10, 847103580, 1970669142, '{"p":{"t":"b","!":"u","n":"pgbench_accounts","a":"pgbench_accounts","1":0.29,"2":8.31,"3":1,"4":103,"l":[{"t":"i","h":"m","d":"f","i":"pgbench_accounts_pkey","n":"pgbench_accounts","a":"pgbench_accounts","1":0.29,"2":8.31,"3":1,"4":103,"8":"(aid = 65971)"}]}}', 1529, 0.177099, 1529, 10992, 292, 291, 0, 0, 0, 0, 0, 0, 0, 5.37, 0, 120, 220, 0, 0, '2012-11-01 00:00:00+09', '2012-11-01 00:02:00+09');
-	INSERT INTO statsrepo.plan VALUES ($6 + 2, 12870, 10, 1067368138, 4132319976, '{"p":{"t":"b","!":"u","n":"pgbench_branches","a":"pgbench_branches","1":0.00,"2":1.01,"3":1,"4":106,"l":[{"t":"h","h":"m","n":"pgbench_branches","a":"pgbench_branches","1":0.00,"2":1.01,"3":1,"4":106,"5":"(bid = 1)"}]}}', 1529, 0.0735179999999998, 1529, 3059, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 120, 220, 0, 0, '2012-11-01 00:00:00+09', '2012-11-01 00:02:00+09');
-	INSERT INTO statsrepo.plan VALUES ($6 + 2, 12870, 10, 1899262118, 487339097, '{"p":{"t":"b","!":"u","n":"pgbench_tellers","a":"pgbench_tellers","1":0.00,"2":1.13,"3":1,"4":106,"l":[{"t":"h","h":"m","n":"pgbench_tellers","a":"pgbench_tellers","1":0.00,"2":1.13,"3":1,"4":106,"5":"(tid = 1)"}]}}', 1529, 0.0729339999999998, 1529, 3059, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 120, 220, 0, 0, '2012-11-01 00:00:00+09', '2012-11-01 00:02:00+09');
-	INSERT INTO statsrepo.plan VALUES ($6 + 3, 12870, 10, 847103580, 1970669142, '{"p":{"t":"b","!":"u","n":"pgbench_accounts","a":"pgbench_accounts","1":0.29,"2":8.31,"3":1,"4":103,"l":[{"t":"i","h":"m","d":"f","i":"pgbench_accounts_pkey","n":"pgbench_accounts","a":"pgbench_accounts","1":0.29,"2":8.31,"3":1,"4":103,"8":"(aid = 9747)"}]}}', 1897, 0.204121, 1897, 13129, 294, 293, 0, 0, 0, 0, 0, 0, 0, 5.37, 0, 130, 230, 0, 0, '2012-11-01 00:00:00+09', '2012-11-01 00:03:00+09');
-	INSERT INTO statsrepo.plan VALUES ($6 + 3, 12870, 10, 1067368138, 4132319976, '{"p":{"t":"b","!":"u","n":"pgbench_branches","a":"pgbench_branches","1":0.00,"2":1.01,"3":1,"4":106,"l":[{"t":"h","h":"m","n":"pgbench_branches","a":"pgbench_branches","1":0.00,"2":1.01,"3":1,"4":106,"5":"(bid = 1)"}]}}', 1896, 0.0980150000000002, 1896, 3793, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 130, 230, 0, 0, '2012-11-01 00:00:00+09', '2012-11-01 00:03:00+09');
-	INSERT INTO statsrepo.plan VALUES ($6 + 3, 12870, 10, 1899262118, 487339097, '{"p":{"t":"b","!":"u","n":"pgbench_tellers","a":"pgbench_tellers","1":0.00,"2":1.13,"3":1,"4":106,"l":[{"t":"h","h":"m","n":"pgbench_tellers","a":"pgbench_tellers","1":0.00,"2":1.13,"3":1,"4":106,"5":"(tid = 6)"}]}}', 1897, 0.0897130000000002, 1897, 3795, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 130, 230, 0, 0, '2012-11-01 00:00:00+09', '2012-11-01 00:03:00+09');
+	INSERT INTO statsrepo.plan VALUES ($6, 12870, 10, 847103580, 1970669142, 1, 823, 0.110259, 823, 6339, 275, 274, 0, 0, 0, 0, 0, 0, 0, 5.157, 0, 100, 200, 0, 0, '2012-11-01 00:00:00+09', '2012-11-01 00:00:00+09');
+	INSERT INTO statsrepo.plan VALUES ($6, 12870, 10, 1067368138, 4132319976, 2, 823, 0.0374639999999999, 823, 1647, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 100, 200, 0, 0, '2012-11-01 00:00:00+09', '2012-11-01 00:00:00+09');
+	INSERT INTO statsrepo.plan VALUES ($6, 12870, 10, 1899262118, 487339097, 3, 823, 0.0412209999999999, 823, 1647, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 100, 200, 0, 0, '2012-11-01 00:00:00+09', '2012-11-01 00:00:00+09');
+	INSERT INTO statsrepo.plan VALUES ($6 + 1, 12870, 10, 847103580, 1970669142, 4, 1279, 0.153424, 1279, 9383, 288, 287, 0, 0, 0, 0, 0, 0, 0, 5.331, 0, 110, 210, 0, 0, '2012-11-01 00:00:00+09', '2012-11-01 00:01:00+09');
+	INSERT INTO statsrepo.plan VALUES ($6 + 1, 12870, 10, 1067368138, 4132319976, 2, 1279, 0.0580179999999998, 1279, 2559, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 110, 210, 0, 0, '2012-11-01 00:00:00+09', '2012-11-01 00:01:00+09');
+	INSERT INTO statsrepo.plan VALUES ($6 + 1, 12870, 10, 1899262118, 487339097, 5, 1279, 0.0619969999999996, 1279, 2559, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 110, 210, 0, 0, '2012-11-01 00:00:00+09', '2012-11-01 00:01:00+09');
+	INSERT INTO statsrepo.plan VALUES ($6 + 2, 12870, 10, 847103580, 1970669142, 6, 1529, 0.177099, 1529, 10992, 292, 291, 0, 0, 0, 0, 0, 0, 0, 5.37, 0, 120, 220, 0, 0, '2012-11-01 00:00:00+09', '2012-11-01 00:02:00+09');
+	INSERT INTO statsrepo.plan VALUES ($6 + 2, 12870, 10, 1067368138, 4132319976, 2, 1529, 0.0735179999999998, 1529, 3059, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 120, 220, 0, 0, '2012-11-01 00:00:00+09', '2012-11-01 00:02:00+09');
+	INSERT INTO statsrepo.plan VALUES ($6 + 2, 12870, 10, 1899262118, 487339097, 7, 1529, 0.0729339999999998, 1529, 3059, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 120, 220, 0, 0, '2012-11-01 00:00:00+09', '2012-11-01 00:02:00+09');
+	INSERT INTO statsrepo.plan VALUES ($6 + 3, 12870, 10, 847103580, 1970669142, 8, 1897, 0.204121, 1897, 13129, 294, 293, 0, 0, 0, 0, 0, 0, 0, 5.37, 0, 130, 230, 0, 0, '2012-11-01 00:00:00+09', '2012-11-01 00:03:00+09');
+	INSERT INTO statsrepo.plan VALUES ($6 + 3, 12870, 10, 1067368138, 4132319976, 2, 1896, 0.0980150000000002, 1896, 3793, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 130, 230, 0, 0, '2012-11-01 00:00:00+09', '2012-11-01 00:03:00+09');
+	INSERT INTO statsrepo.plan VALUES ($6 + 3, 12870, 10, 1899262118, 487339097, 9, 1897, 0.0897130000000002, 1897, 3795, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 130, 230, 0, 0, '2012-11-01 00:00:00+09', '2012-11-01 00:03:00+09');
 
 	--
 	-- Data for Name: replication; Type: TABLE DATA; Schema: statsrepo; Owner: postgres
@@ -348,21 +369,28 @@ $$
 	INSERT INTO statsrepo.setting VALUES ($6 + 2, 'shared_buffers', '4096', '8kB', 'configuration file');
 	INSERT INTO statsrepo.setting VALUES ($6 + 3, 'shared_buffers', '4096', '8kB', 'configuration file');
 
+	--
+	-- Data for Name: query_text; Type: TABLE DATA; Schema: statsrepo; Owner: postgres
+	--
+	INSERT INTO statsrepo.query_text VALUES (12870, 10, 1067368138, 1067368138, 'UPDATE pgbench_branches SET bbalance = bbalance + ? WHERE bid = ?;') ON CONFLICT DO NOTHING;
+	INSERT INTO statsrepo.query_text VALUES (12870, 10, 1899262118, 1899262118, 'UPDATE pgbench_tellers SET tbalance = tbalance + ? WHERE tid = ?;') ON CONFLICT DO NOTHING;
+	INSERT INTO statsrepo.query_text VALUES (12870, 10, 847103580, 847103580, 'UPDATE pgbench_accounts SET abalance = abalance + ? WHERE aid = ?;') ON CONFLICT DO NOTHING;
+
 	--
 	-- Data for Name: statement; Type: TABLE DATA; Schema: statsrepo; Owner: postgres
 	--
-	INSERT INTO statsrepo.statement VALUES ($6, 12870, 10, 1067368138, 'UPDATE pgbench_branches SET bbalance = bbalance + ? WHERE bid = ?;', 0,0, 13959, 68.6447329999982969, 13959, 102552, 10, 10, 0, 0, 0, 0, 0, 0, 0, 0.0749999999999999972, 0, 100.0, 50);
-	INSERT INTO statsrepo.statement VALUES ($6, 12870, 10, 1899262118, 'UPDATE pgbench_tellers SET tbalance = tbalance + ? WHERE tid = ?;', 0,0, 13961, 17.1652659999997006, 13961, 39461, 12, 11, 0, 0, 0, 0, 0, 0, 0, 0.0889999999999999958, 0, 200.0, 50);
-	INSERT INTO statsrepo.statement VALUES ($6, 12870, 10, 847103580, 'UPDATE pgbench_accounts SET abalance = abalance + ? WHERE aid = ?;', 0,0, 13962, 1.42280999999985003, 13962, 63130, 1950, 1948, 0, 0, 0, 0, 0, 0, 0, 73.9310000000001963, 0, 300.0, 50);
-	INSERT INTO statsrepo.statement VALUES ($6 + 1, 12870, 10, 1067368138, 'UPDATE pgbench_branches SET bbalance = bbalance + ? WHERE bid = ?;', 0,0, 36061, 176.479407999995004, 36061, 349687, 11, 11, 0, 0, 0, 0, 0, 0, 0, 0.0749999999999999972, 0, 100.0, 50);
-	INSERT INTO statsrepo.statement VALUES ($6 + 1, 12870, 10, 1899262118, 'UPDATE pgbench_tellers SET tbalance = tbalance + ? WHERE tid = ?;', 0,0, 36063, 45.5574849999972997, 36063, 210248, 12, 11, 0, 0, 0, 0, 0, 0, 0, 0.0889999999999999958, 0, 200.0, 50);
-	INSERT INTO statsrepo.statement VALUES ($6 + 1, 12870, 10, 847103580, 'UPDATE pgbench_accounts SET abalance = abalance + ? WHERE aid = ?;', 0,0, 36064, 3.11938400000004012, 36064, 152482, 1956, 1954, 0, 0, 0, 0, 0, 0, 0, 73.9570000000002068, 0, 300.0, 50);
-	INSERT INTO statsrepo.statement VALUES ($6 + 2, 12870, 10, 1067368138, 'UPDATE pgbench_branches SET bbalance = bbalance + ? WHERE bid = ?;', 0,0, 58140, 286.760816999982978, 58140, 620495, 12, 14, 0, 0, 0, 0, 0, 0, 0, 0.0749999999999999972, 0, 100.0, 50);
-	INSERT INTO statsrepo.statement VALUES ($6 + 2, 12870, 10, 1899262118, 'UPDATE pgbench_tellers SET tbalance = tbalance + ? WHERE tid = ?;', 0,0, 58143, 73.9565750000011946, 58143, 380498, 12, 13, 0, 0, 0, 0, 0, 0, 0, 0.0889999999999999958, 0, 200.0, 50);
-	INSERT INTO statsrepo.statement VALUES ($6 + 2, 12870, 10, 847103580, 'UPDATE pgbench_accounts SET abalance = abalance + ? WHERE aid = ?;', 0,0, 58143, 5.1055540000000299, 58143, 242773, 1964, 2279, 0, 0, 0, 0, 0, 0, 0, 73.9570000000002068, 0, 300.0, 50);
-	INSERT INTO statsrepo.statement VALUES ($6 + 3, 12870, 10, 1067368138, 'UPDATE pgbench_branches SET bbalance = bbalance + ? WHERE bid = ?;', 0,0, 80422, 400.019771999942975, 80422, 896817, 12, 14, 0, 0, 0, 0, 0, 0, 0, 0.0749999999999999972, 0, 100.0, 50);
-	INSERT INTO statsrepo.statement VALUES ($6 + 3, 12870, 10, 1899262118, 'UPDATE pgbench_tellers SET tbalance = tbalance + ? WHERE tid = ?;', 0,0, 80424, 102.535575000004997, 80424, 552512, 12, 13, 0, 0, 0, 0, 0, 0, 0, 0.0889999999999999958, 0, 200.0, 50);
-	INSERT INTO statsrepo.statement VALUES ($6 + 3, 12870, 10, 847103580, 'UPDATE pgbench_accounts SET abalance = abalance + ? WHERE aid = ?;', 0,0, 80425, 6.97668499999906988, 80425, 336204, 1980, 2332, 0, 0, 0, 0, 0, 0, 0, 73.9570000000002068, 0, 300.0, 50);
+	INSERT INTO statsrepo.statement VALUES ($6, 12870, 10, 1067368138, 1067368138, 0,0, 13959, 68.6447329999982969, 13959, 102552, 10, 10, 0, 0, 0, 0, 0, 0, 0, 0.0749999999999999972, 0, 100.0, 50);
+	INSERT INTO statsrepo.statement VALUES ($6, 12870, 10, 1899262118, 1899262118, 0,0, 13961, 17.1652659999997006, 13961, 39461, 12, 11, 0, 0, 0, 0, 0, 0, 0, 0.0889999999999999958, 0, 200.0, 50);
+	INSERT INTO statsrepo.statement VALUES ($6, 12870, 10, 847103580, 847103580, 0,0, 13962, 1.42280999999985003, 13962, 63130, 1950, 1948, 0, 0, 0, 0, 0, 0, 0, 73.9310000000001963, 0, 300.0, 50);
+	INSERT INTO statsrepo.statement VALUES ($6 + 1, 12870, 10, 1067368138, 1067368138, 0,0, 36061, 176.479407999995004, 36061, 349687, 11, 11, 0, 0, 0, 0, 0, 0, 0, 0.0749999999999999972, 0, 100.0, 50);
+	INSERT INTO statsrepo.statement VALUES ($6 + 1, 12870, 10, 1899262118, 1899262118, 0,0, 36063, 45.5574849999972997, 36063, 210248, 12, 11, 0, 0, 0, 0, 0, 0, 0, 0.0889999999999999958, 0, 200.0, 50);
+	INSERT INTO statsrepo.statement VALUES ($6 + 1, 12870, 10, 847103580, 847103580, 0,0, 36064, 3.11938400000004012, 36064, 152482, 1956, 1954, 0, 0, 0, 0, 0, 0, 0, 73.9570000000002068, 0, 300.0, 50);
+	INSERT INTO statsrepo.statement VALUES ($6 + 2, 12870, 10, 1067368138, 1067368138, 0,0, 58140, 286.760816999982978, 58140, 620495, 12, 14, 0, 0, 0, 0, 0, 0, 0, 0.0749999999999999972, 0, 100.0, 50);
+	INSERT INTO statsrepo.statement VALUES ($6 + 2, 12870, 10, 1899262118, 1899262118, 0,0, 58143, 73.9565750000011946, 58143, 380498, 12, 13, 0, 0, 0, 0, 0, 0, 0, 0.0889999999999999958, 0, 200.0, 50);
+	INSERT INTO statsrepo.statement VALUES ($6 + 2, 12870, 10, 847103580, 847103580, 0,0, 58143, 5.1055540000000299, 58143, 242773, 1964, 2279, 0, 0, 0, 0, 0, 0, 0, 73.9570000000002068, 0, 300.0, 50);
+	INSERT INTO statsrepo.statement VALUES ($6 + 3, 12870, 10, 1067368138, 1067368138, 0,0, 80422, 400.019771999942975, 80422, 896817, 12, 14, 0, 0, 0, 0, 0, 0, 0, 0.0749999999999999972, 0, 100.0, 50);
+	INSERT INTO statsrepo.statement VALUES ($6 + 3, 12870, 10, 1899262118, 1899262118, 0,0, 80424, 102.535575000004997, 80424, 552512, 12, 13, 0, 0, 0, 0, 0, 0, 0, 0.0889999999999999958, 0, 200.0, 50);
+	INSERT INTO statsrepo.statement VALUES ($6 + 3, 12870, 10, 847103580, 847103580, 0,0, 80425, 6.97668499999906988, 80425, 336204, 1980, 2332, 0, 0, 0, 0, 0, 0, 0, 73.9570000000002068, 0, 300.0, 50);
 
 	--
 	-- Data for Name: tablespace; Type: TABLE DATA; Schema: statsrepo; Owner: postgres
@@ -450,4 +478,65 @@ $$
 	INSERT INTO statsrepo.ht_info VALUES ($6 + 2, 20, '2012-11-01 02:00:00+09', 20, '2012-11-01 02:00:00+09', 20, '2012-11-01 02:00:00+09');
 	INSERT INTO statsrepo.ht_info VALUES ($6 + 3, 30, '2012-11-01 03:00:00+09', 30, '2012-11-01 03:00:00+09', 30, '2012-11-01 03:00:00+09');
 
+	--
+	-- Data for Name: buffercache; Type: TABLE DATA; Schema: statsrepo; Owner: postgres
+	--
+	INSERT INTO statsrepo.buffercache VALUES ($6, 12870, 1663, 16422, 0, 'public', 'pgbench_accounts', 100, 10, 0, 10, 10, 20, 20, 20, 20);
+	INSERT INTO statsrepo.buffercache VALUES ($6 + 1, 12870, 1663, 16422, 0, 'public', 'pgbench_accounts', 200, 20, 0, 20, 20, 40, 40, 40, 40);
+	INSERT INTO statsrepo.buffercache VALUES ($6 + 1, 0, 1664, 1262, 0, 'pg_catalog', 'pg_database', 4, 0, 0, 0, 0, 0, 0, 0, 4);
+	INSERT INTO statsrepo.buffercache VALUES ($6 + 2, 12870, 1663, 16422, 0, 'public', 'pgbench_accounts', 300, 30, 0, 30, 30, 60, 60, 60, 60);
+	INSERT INTO statsrepo.buffercache VALUES ($6 + 3, 12870, 1663, 16422, 0, 'public', 'pgbench_accounts', 400, 40, 0, 40, 40, 80, 80, 80, 80);
+	INSERT INTO statsrepo.buffercache VALUES ($6 + 3, 0, 1664, 1262, 0, 'pg_catalog', 'pg_database', 6, 0, 0, 0, 0, 0, 0, 2, 4);
+	INSERT INTO statsrepo.buffercache VALUES ($6 + 3, 12870, 1663, 16500, 1, NULL, NULL, 2, 1, 0, 0, 2, 0, 0, 0, 0);
+
+	--
+	-- Data for Name: wal_composition; Type: TABLE DATA; Schema: statsrepo; Owner: postgres
+	--
+	INSERT INTO statsrepo.wal_composition VALUES ($6, '0/1000000', '0/3B7C140', 'Heap', 'INSERT', 999, 104857600, 0, 104857600);
+	INSERT INTO statsrepo.wal_composition VALUES ($6 + 1, '0/3B7C140', '0/5635000', 'Heap', 'INSERT', 100, 10485760, 0, 10485760);
+	INSERT INTO statsrepo.wal_composition VALUES ($6 + 2, '0/5635000', '0/63614A8', 'Heap', 'INSERT', 50, 5242880, 1048576, 6291456);
+	INSERT INTO statsrepo.wal_composition VALUES ($6 + 3, '0/63614A8', '0/6800000', 'Btree', 'INSERT_LEAF', 20, 1048576, 3145728, 4194304);
+
+	--
+	-- Data for Name: backend_memory; Type: TABLE DATA; Schema: statsrepo; Owner: postgres
+	--
+	INSERT INTO statsrepo.backend_memory VALUES ($6, 1001, '2012-11-01 00:00:00+09', 'client backend', 12870, 10, 123456789, 104857600, 52428800, 0, '2012-11-01 00:00:30+09', false, 'SELECT 1');
+	INSERT INTO statsrepo.backend_memory VALUES ($6 + 1, 1002, '2012-11-01 00:00:40+09', 'autovacuum worker', 12870, 10, NULL, 31457280, 20971520, 0, '2012-11-01 00:00:50+09', false, 'autovacuum: VACUUM public.pgbench_history');
+	INSERT INTO statsrepo.backend_memory VALUES ($6 + 2, 1001, '2012-11-01 00:00:00+09', 'client backend', 12870, 10, 123456789, 209715200, 157286400, 1048576, '2012-11-01 00:01:45+09', true, 'SELECT * FROM pgbench_accounts');
+	INSERT INTO statsrepo.backend_memory VALUES ($6 + 3, 1003, '2012-11-01 00:02:00+09', 'walsender', 0, 10, NULL, 10485760, 5242880, 0, '2012-11-01 00:02:10+09', false, '');
+
+	--
+	-- Data for Name: progress; Type: TABLE DATA; Schema: statsrepo; Owner: postgres
+	--
+	INSERT INTO statsrepo.progress VALUES ($6, 2000, 'VACUUM', 12870, 16422, '2012-11-01 00:00:00+09', NULL, 1, 'scanning heap', '2012-11-01 00:00:00+09', '2012-11-01 00:00:50+09', 1640, 0, 1640);
+	INSERT INTO statsrepo.progress VALUES ($6 + 1, 2003, 'ANALYZE', 12870, 99999, '2012-11-01 00:00:10+09', '2012-11-01 00:00:12.5+09', 1, 'acquiring sample rows', '2012-11-01 00:00:10+09', '2012-11-01 00:00:12.5+09', 0, 0, 0);
+	INSERT INTO statsrepo.progress VALUES ($6 + 2, 2001, 'VACUUM', 12870, 16422, '2012-11-01 00:01:10+09', '2012-11-01 00:01:43+09', 1, 'scanning heap', '2012-11-01 00:01:10+09', '2012-11-01 00:01:20+09', 1640, 0, 1000);
+	INSERT INTO statsrepo.progress VALUES ($6 + 2, 2001, 'VACUUM', 12870, 16422, '2012-11-01 00:01:10+09', '2012-11-01 00:01:43+09', 2, 'vacuuming indexes', '2012-11-01 00:01:30+09', '2012-11-01 00:01:35+09', 1640, 1000, 1000);
+	INSERT INTO statsrepo.progress VALUES ($6 + 2, 2001, 'VACUUM', 12870, 16422, '2012-11-01 00:01:10+09', '2012-11-01 00:01:43+09', 3, 'vacuuming heap', '2012-11-01 00:01:35+09', '2012-11-01 00:01:43+09', 1640, 1000, 1640);
+	INSERT INTO statsrepo.progress VALUES ($6 + 3, 2002, 'VACUUM', 12870, 16422, '2012-11-01 00:02:10+09', '2012-11-01 00:02:20+09', 1, 'scanning heap', '2012-11-01 00:02:10+09', '2012-11-01 00:02:20+09', 1640, 0, 500);
+
+	--
+	-- Data for Name: replication_lag; Type: TABLE DATA; Schema: statsrepo; Owner: postgres
+	--
+	INSERT INTO statsrepo.replication_lag VALUES ($6, 3001, 'standby1', 60, '00:00:01', '01:00:00', '00:00:01', '00:00:01', '01:00:00', '00:00:01', '00:00:01', '01:00:00', '00:00:01');
+	INSERT INTO statsrepo.replication_lag VALUES ($6 + 1, 3001, 'standby1', 60, '00:00:00.001', '00:00:00.002', '00:00:00.002', '00:00:00.001', '00:00:00.003', '00:00:00.002', '00:00:00.001', '00:00:00.005', '00:00:00.004');
+	INSERT INTO statsrepo.replication_lag VALUES ($6 + 2, 3001, 'standby1', 60, '00:00:00.001', '00:00:00.01', '00:00:00.008', '00:00:00.001', '00:00:00.02', '00:00:00.015', '00:00:00.002', '00:00:00.05', '00:00:00.03');
+	INSERT INTO statsrepo.replication_lag VALUES ($6 + 3, 3002, 'standby2', 30, '00:00:00.5', '00:00:01', '00:00:00.9', '00:00:00.5', '00:00:01.5', '00:00:01.2', '00:00:00.5', '00:00:02.5', '00:00:02');
+
+	--
+	-- Data for Name: replication_slot_retention; Type: TABLE DATA; Schema: statsrepo; Owner: postgres
+	--
+	INSERT INTO statsrepo.replication_slot_retention VALUES ($6, 'slot1', 60, 1073741824, 1073741824, 1073741824);
+	INSERT INTO statsrepo.replication_slot_retention VALUES ($6 + 1, 'slot1', 60, 16777216, 33554432, 31457280);
+	INSERT INTO statsrepo.replication_slot_retention VALUES ($6 + 2, 'slot1', 60, 8388608, 67108864, 50331648);
+	INSERT INTO statsrepo.replication_slot_retention VALUES ($6 + 3, 'slot2', 30, 1024, 4096, 2048);
+
+	--
+	-- Data for Name: instance_ts; Type: TABLE DATA; Schema: statsrepo; Owner: postgres
+	--
+	INSERT INTO statsrepo.instance_ts VALUES ($1, '2012-11-01 00:00:00+09', 1000, 10, 100, 900, 0, 100, 50, 0, 0, 0, 100, 1, 0, 0, 2, 1, 0);
+	INSERT INTO statsrepo.instance_ts VALUES ($1, '2012-11-01 00:00:10+09', 1500, 20, 200, 1800, 10485760, 200, 100, 5, 1, 50, 300, 1, 1, 100, 3, 0, 1);
+	INSERT INTO statsrepo.instance_ts VALUES ($1, '2012-11-01 00:00:20+09', 2500, 20, 250, 2250, 20971520, 250, 200, 5, 1, 50, 400, 1, 1, 100, 1, 2, 0);
+	INSERT INTO statsrepo.instance_ts VALUES ($1, '2012-11-01 00:03:10+09', 9000, 90, 900, 9000, 99999999, 900, 900, 9, 9, 90, 900, 9, 9, 900, 9, 9, 9);
+
 $$ LANGUAGE sql;